@@ -17,9 +17,14 @@
 */
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Common/b2Snapshot.h>
 
 b2BroadPhase::b2BroadPhase()
 {
+	m_staticProxyCount = 0;
+	m_separateStaticTree = false;
+	m_staticTreeDirty = false;
+
 	m_proxyCount = 0;
 
 	m_pairCapacity = 16;
@@ -37,24 +42,92 @@ b2BroadPhase::~b2BroadPhase()
 	b2Free(m_pairBuffer);
 }
 
-int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+void b2BroadPhase::SetSeparateStaticTree(bool flag)
 {
-	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+	b2Assert(m_staticProxyCount == 0);
+	m_separateStaticTree = flag;
+}
+
+int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData, bool isStatic)
+{
+	int32 proxyId;
+	if (isStatic && m_separateStaticTree)
+	{
+		proxyId = m_staticTree.CreateProxy(aabb, userData);
+		b2Assert((proxyId & e_staticProxyFlag) == 0);
+		proxyId |= e_staticProxyFlag;
+		++m_staticProxyCount;
+		m_staticTreeDirty = true;
+	}
+	else
+	{
+		proxyId = m_tree.CreateProxy(aabb, userData);
+		b2Assert((proxyId & e_staticProxyFlag) == 0);
+	}
 	++m_proxyCount;
 	BufferMove(proxyId);
 	return proxyId;
 }
 
+void b2BroadPhase::CreateProxies(const b2AABB* aabbs, void* const* userData,
+								 int32 count, bool isStatic, int32* proxyIds)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (isStatic && m_separateStaticTree)
+	{
+		// The bulk build replaces any rebuild that was pending.
+		m_staticTree.CreateProxies(aabbs, userData, count, proxyIds);
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2Assert((proxyIds[i] & e_staticProxyFlag) == 0);
+			proxyIds[i] |= e_staticProxyFlag;
+		}
+		m_staticProxyCount += count;
+		m_staticTreeDirty = false;
+	}
+	else if (count >= m_proxyCount - m_staticProxyCount)
+	{
+		m_tree.CreateProxies(aabbs, userData, count, proxyIds);
+	}
+	else
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			proxyIds[i] = m_tree.CreateProxy(aabbs[i], userData[i]);
+		}
+	}
+
+	m_proxyCount += count;
+	for (int32 i = 0; i < count; ++i)
+	{
+		BufferMove(proxyIds[i]);
+	}
+}
+
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
 	UnBufferMove(proxyId);
 	--m_proxyCount;
-	m_tree.DestroyProxy(proxyId);
+	if (proxyId & e_staticProxyFlag)
+	{
+		m_staticTree.DestroyProxy(GetTreeProxyId(proxyId));
+		--m_staticProxyCount;
+		m_staticTreeDirty = true;
+	}
+	else
+	{
+		m_tree.DestroyProxy(proxyId);
+	}
 }
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
-	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
+	b2DynamicTree& tree = (proxyId & e_staticProxyFlag) ? m_staticTree : m_tree;
+	bool buffer = tree.MoveProxy(GetTreeProxyId(proxyId), aabb, displacement);
 	if (buffer)
 	{
 		BufferMove(proxyId);
@@ -117,3 +190,33 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 
 	return true;
 }
+
+void b2BroadPhase::Save(b2SnapshotWriter* writer) const
+{
+	m_tree.Save(writer);
+	m_staticTree.Save(writer);
+	writer->Write(m_staticProxyCount);
+	writer->Write(m_separateStaticTree);
+	writer->Write(m_staticTreeDirty);
+	writer->Write(m_proxyCount);
+	writer->Write(m_moveCount);
+	writer->Write(m_moveBuffer, m_moveCount * sizeof(int32));
+}
+
+void b2BroadPhase::Restore(b2SnapshotReader* reader)
+{
+	m_tree.Restore(reader);
+	m_staticTree.Restore(reader);
+	m_staticProxyCount = reader->Read<int32>();
+	m_separateStaticTree = reader->Read<bool>();
+	m_staticTreeDirty = reader->Read<bool>();
+	m_proxyCount = reader->Read<int32>();
+	m_moveCount = reader->Read<int32>();
+	if (m_moveCount > m_moveCapacity)
+	{
+		b2Free(m_moveBuffer);
+		m_moveCapacity = m_moveCount;
+		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	}
+	reader->Read(m_moveBuffer, m_moveCount * sizeof(int32));
+}
@@ -30,6 +30,8 @@ struct b2Pair
 	int32 proxyIdB;
 };
 
+template <typename T> struct b2StaticTreeCallback;
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
@@ -39,15 +41,32 @@ public:
 
 	enum
 	{
-		e_nullProxy = -1
+		e_nullProxy = -1,
+		/// Set in the ids of proxies in the static tree.
+		e_staticProxyFlag = 0x40000000
 	};
 
 	b2BroadPhase();
 	~b2BroadPhase();
 
+	/// Keep the proxies of static fixtures in a tree of their own. The static
+	/// tree is rebuilt in bulk when proxies have been added to or removed from
+	/// it, and pairs of two static proxies are never reported. Can only be
+	/// changed while there are no static proxies.
+	void SetSeparateStaticTree(bool flag);
+	bool GetSeparateStaticTree() const;
+
 	/// Create a proxy with an initial AABB. Pairs are not reported until
-	/// UpdatePairs is called.
-	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	/// UpdatePairs is called. Static proxies go to the static tree if there
+	/// is one.
+	int32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic = false);
+
+	/// Create many proxies at once. The tree they go to is rebuilt in bulk
+	/// instead of inserting the proxies one by one, unless it already has
+	/// more proxies than are being added.
+	/// @param proxyIds receives the id of each proxy.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData,
+					   int32 count, bool isStatic, int32* proxyIds);
 
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
@@ -90,13 +109,14 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
-	/// Get the height of the embedded tree.
+	/// Get the height of the embedded tree, or the higher of the two trees.
 	int32 GetTreeHeight() const;
 
-	/// Get the balance of the embedded tree.
+	/// Get the balance of the embedded tree, or the worse of the two trees.
 	int32 GetTreeBalance() const;
 
-	/// Get the quality metric of the embedded tree.
+	/// Get the quality metric of the embedded tree. With a separate static
+	/// tree, this is the quality of the tree of moving proxies.
 	float32 GetTreeQuality() const;
 
 	/// Shift the world origin. Useful for large worlds.
@@ -104,17 +124,36 @@ public:
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Write the trees and the proxies waiting for UpdatePairs to a
+	/// snapshot.
+	void Save(b2SnapshotWriter* writer) const;
+
+	/// Read back the state written with Save().
+	void Restore(b2SnapshotReader* reader);
+
 private:
 
 	friend class b2DynamicTree;
+	template <typename T> friend struct b2StaticTreeCallback;
 
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
 
 	bool QueryCallback(int32 proxyId);
 
+	/// Get the tree of a proxy and its id in that tree.
+	const b2DynamicTree& GetTree(int32 proxyId) const;
+	static int32 GetTreeProxyId(int32 proxyId);
+
 	b2DynamicTree m_tree;
 
+	/// Static proxies when m_separateStaticTree is set.
+	b2DynamicTree m_staticTree;
+	int32 m_staticProxyCount;
+	bool m_separateStaticTree;
+	/// Set when static proxies were added or removed since the last rebuild.
+	bool m_staticTreeDirty;
+
 	int32 m_proxyCount;
 
 	int32* m_moveBuffer;
@@ -128,6 +167,44 @@ private:
 	int32 m_queryProxyId;
 };
 
+/// Passes the proxies of the static tree to a broad-phase callback with
+/// their broad-phase ids.
+template <typename T>
+struct b2StaticTreeCallback
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		return callback->QueryCallback(proxyId | b2BroadPhase::e_staticProxyFlag);
+	}
+
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		return callback->RayCastCallback(input,
+			proxyId | b2BroadPhase::e_staticProxyFlag);
+	}
+
+	T* callback;
+};
+
+/// Passes a ray-cast callback on and keeps track of how far the ray
+/// extends, so that a second tree can be ray-cast with the same limit.
+template <typename T>
+struct b2RayCastClipCallback
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		float32 value = callback->RayCastCallback(input, proxyId);
+		if (value >= 0.0f)
+		{
+			maxFraction = value;
+		}
+		return value;
+	}
+
+	T* callback;
+	float32 maxFraction;
+};
+
 /// This is used to sort pairs.
 inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 {
@@ -144,21 +221,36 @@ inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 	return false;
 }
 
+inline bool b2BroadPhase::GetSeparateStaticTree() const
+{
+	return m_separateStaticTree;
+}
+
+inline const b2DynamicTree& b2BroadPhase::GetTree(int32 proxyId) const
+{
+	return (proxyId & e_staticProxyFlag) ? m_staticTree : m_tree;
+}
+
+inline int32 b2BroadPhase::GetTreeProxyId(int32 proxyId)
+{
+	return proxyId & ~e_staticProxyFlag;
+}
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
-	return m_tree.GetUserData(proxyId);
+	return GetTree(proxyId).GetUserData(GetTreeProxyId(proxyId));
 }
 
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
-	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
-	const b2AABB& aabbB = m_tree.GetFatAABB(proxyIdB);
+	const b2AABB& aabbA = GetFatAABB(proxyIdA);
+	const b2AABB& aabbB = GetFatAABB(proxyIdB);
 	return b2TestOverlap(aabbA, aabbB);
 }
 
 inline const b2AABB& b2BroadPhase::GetFatAABB(int32 proxyId) const
 {
-	return m_tree.GetFatAABB(proxyId);
+	return GetTree(proxyId).GetFatAABB(GetTreeProxyId(proxyId));
 }
 
 inline int32 b2BroadPhase::GetProxyCount() const
@@ -168,12 +260,12 @@ inline int32 b2BroadPhase::GetProxyCount() const
 
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
-	return m_tree.GetHeight();
+	return b2Max(m_tree.GetHeight(), m_staticTree.GetHeight());
 }
 
 inline int32 b2BroadPhase::GetTreeBalance() const
 {
-	return m_tree.GetMaxBalance();
+	return b2Max(m_tree.GetMaxBalance(), m_staticTree.GetMaxBalance());
 }
 
 inline float32 b2BroadPhase::GetTreeQuality() const
@@ -187,6 +279,18 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	// Reset pair buffer
 	m_pairCount = 0;
 
+	if (m_staticTreeDirty)
+	{
+		if (m_staticProxyCount > 0)
+		{
+			m_staticTree.Rebuild();
+		}
+		m_staticTreeDirty = false;
+	}
+
+	b2StaticTreeCallback<b2BroadPhase> staticCallback;
+	staticCallback.callback = this;
+
 	// Perform tree queries for all moving proxies.
 	for (int32 i = 0; i < m_moveCount; ++i)
 	{
@@ -198,10 +302,17 @@ void b2BroadPhase::UpdatePairs(T* callback)
 
 		// We have to query the tree with the fat AABB so that
 		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
+		const b2AABB& fatAABB = GetFatAABB(m_queryProxyId);
 
 		// Query tree, create pairs and add them pair buffer.
 		m_tree.Query(this, fatAABB);
+
+		// Static proxies don't pair with each other.
+		if ((m_queryProxyId & e_staticProxyFlag) == 0 &&
+			m_staticProxyCount > 0)
+		{
+			m_staticTree.Query(&staticCallback, fatAABB);
+		}
 	}
 
 	// Reset move buffer
@@ -215,8 +326,8 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	while (i < m_pairCount)
 	{
 		b2Pair* primaryPair = m_pairBuffer + i;
-		void* userDataA = m_tree.GetUserData(primaryPair->proxyIdA);
-		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
+		void* userDataA = GetUserData(primaryPair->proxyIdA);
+		void* userDataB = GetUserData(primaryPair->proxyIdB);
 
 		callback->AddPair(userDataA, userDataB);
 		++i;
@@ -241,17 +352,44 @@ template <typename T>
 inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb) const
 {
 	m_tree.Query(callback, aabb);
+	if (m_staticProxyCount > 0)
+	{
+		b2StaticTreeCallback<T> staticCallback;
+		staticCallback.callback = callback;
+		m_staticTree.Query(&staticCallback, aabb);
+	}
 }
 
 template <typename T>
 inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) const
 {
-	m_tree.RayCast(callback, input);
+	if (m_staticProxyCount == 0)
+	{
+		m_tree.RayCast(callback, input);
+		return;
+	}
+
+	// The static tree is ray-cast as far as the ray got in the other tree.
+	b2RayCastClipCallback<T> clipCallback;
+	clipCallback.callback = callback;
+	clipCallback.maxFraction = input.maxFraction;
+	m_tree.RayCast(&clipCallback, input);
+	if (clipCallback.maxFraction == 0.0f)
+	{
+		return;
+	}
+
+	b2RayCastInput staticInput = input;
+	staticInput.maxFraction = clipCallback.maxFraction;
+	b2StaticTreeCallback<T> staticCallback;
+	staticCallback.callback = callback;
+	m_staticTree.RayCast(&staticCallback, staticInput);
 }
 
 inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	m_tree.ShiftOrigin(newOrigin);
+	m_staticTree.ShiftOrigin(newOrigin);
 }
 
 #endif
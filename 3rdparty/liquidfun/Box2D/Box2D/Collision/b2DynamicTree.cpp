@@ -18,9 +18,14 @@
 */
 
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <algorithm>
 #include <memory.h>
 #include <string.h>
 
+/// Number of bins the leaf centers are sorted into to find a split.
+static const int32 b2_sahBinCount = 16;
+
 b2DynamicTree::b2DynamicTree()
 {
 	m_root = b2_nullNode;
@@ -773,6 +778,230 @@ void b2DynamicTree::RebuildBottomUp()
 	B2_DEBUG_STATEMENT(Validate());
 }
 
+void b2DynamicTree::CreateProxies(const b2AABB* aabbs, void* const* userData,
+								  int32 count, int32* proxyIds)
+{
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateNode();
+		m_nodes[proxyId].aabb.lowerBound = aabbs[i].lowerBound - r;
+		m_nodes[proxyId].aabb.upperBound = aabbs[i].upperBound + r;
+		m_nodes[proxyId].userData = userData[i];
+		m_nodes[proxyId].height = 0;
+		proxyIds[i] = proxyId;
+	}
+
+	// Rebuild() picks the new leaves up along with the old ones.
+	Rebuild();
+}
+
+void b2DynamicTree::Rebuild()
+{
+	int32* leaves = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32 leafCount = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[leafCount] = i;
+			++leafCount;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	// Hand out the free nodes in index order, so that the internal nodes
+	// allocated by BuildSAH() end up in depth-first order.
+	m_freeList = b2_nullNode;
+	for (int32 i = m_nodeCapacity - 1; i >= 0; --i)
+	{
+		if (m_nodes[i].height == -1)
+		{
+			m_nodes[i].next = m_freeList;
+			m_freeList = i;
+		}
+	}
+
+	m_root = b2_nullNode;
+	if (leafCount > 0)
+	{
+		m_root = BuildSAH(leaves, leafCount);
+		m_nodes[m_root].parent = b2_nullNode;
+	}
+	b2Free(leaves);
+
+	B2_DEBUG_STATEMENT(Validate());
+}
+
+// Orders leaves by the center of their AABB along one axis.
+struct b2LeafCenterLess
+{
+	bool operator()(int32 a, int32 b) const
+	{
+		const b2AABB& aabbA = nodes[a].aabb;
+		const b2AABB& aabbB = nodes[b].aabb;
+		if (axis == 0)
+		{
+			return aabbA.lowerBound.x + aabbA.upperBound.x <
+				   aabbB.lowerBound.x + aabbB.upperBound.x;
+		}
+		return aabbA.lowerBound.y + aabbA.upperBound.y <
+			   aabbB.lowerBound.y + aabbB.upperBound.y;
+	}
+
+	const b2TreeNode* nodes;
+	int32 axis;
+};
+
+// Build a subtree over the given leaves and return its root. The leaves
+// are reordered.
+int32 b2DynamicTree::BuildSAH(int32* leaves, int32 count)
+{
+	if (count == 1)
+	{
+		return leaves[0];
+	}
+
+	// Allocate the parent before its children for a depth-first layout.
+	int32 nodeId = AllocateNode();
+
+	// Split along the axis the leaf centers are spread out the most.
+	b2Vec2 lower = m_nodes[leaves[0]].aabb.GetCenter();
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = m_nodes[leaves[i]].aabb.GetCenter();
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+	int32 axis = (upper.x - lower.x) >= (upper.y - lower.y) ? 0 : 1;
+	float32 minCenter = axis == 0 ? lower.x : lower.y;
+	float32 extent = axis == 0 ? upper.x - lower.x : upper.y - lower.y;
+
+	int32 split = 0;
+	if (extent > 0.0f)
+	{
+		// Sort the leaves into bins by their centers.
+		int32 binCounts[b2_sahBinCount];
+		b2AABB binAABBs[b2_sahBinCount];
+		for (int32 i = 0; i < b2_sahBinCount; ++i)
+		{
+			binCounts[i] = 0;
+		}
+		float32 binScale = b2_sahBinCount / extent;
+		for (int32 i = 0; i < count; ++i)
+		{
+			const b2AABB& aabb = m_nodes[leaves[i]].aabb;
+			b2Vec2 c = aabb.GetCenter();
+			int32 bin = (int32)(((axis == 0 ? c.x : c.y) - minCenter) * binScale);
+			bin = b2Clamp(bin, 0, b2_sahBinCount - 1);
+			if (binCounts[bin] == 0)
+			{
+				binAABBs[bin] = aabb;
+			}
+			else
+			{
+				binAABBs[bin].Combine(aabb);
+			}
+			++binCounts[bin];
+		}
+
+		// Sweep from the right to get the cost of the right side of each
+		// split, then from the left to find the cheapest split. The cost
+		// of a side is its perimeter times its number of leaves.
+		float32 rightCosts[b2_sahBinCount];
+		b2AABB side;
+		side.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+		side.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+		int32 sideCount = 0;
+		for (int32 i = b2_sahBinCount - 1; i > 0; --i)
+		{
+			if (binCounts[i] > 0)
+			{
+				side.Combine(binAABBs[i]);
+				sideCount += binCounts[i];
+			}
+			rightCosts[i] = sideCount > 0 ? sideCount * side.GetPerimeter() : 0.0f;
+		}
+
+		float32 minCost = b2_maxFloat;
+		int32 splitBin = 0;
+		side.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+		side.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+		sideCount = 0;
+		for (int32 i = 0; i < b2_sahBinCount - 1; ++i)
+		{
+			if (binCounts[i] > 0)
+			{
+				side.Combine(binAABBs[i]);
+				sideCount += binCounts[i];
+			}
+			if (sideCount == 0 || sideCount == count)
+			{
+				continue;
+			}
+			float32 cost = sideCount * side.GetPerimeter() + rightCosts[i + 1];
+			if (cost < minCost)
+			{
+				minCost = cost;
+				splitBin = i;
+				split = sideCount;
+			}
+		}
+
+		// Move the leaves of the left bins to the front.
+		if (split > 0)
+		{
+			int32 left = 0;
+			for (int32 i = 0; i < count; ++i)
+			{
+				b2Vec2 c = m_nodes[leaves[i]].aabb.GetCenter();
+				int32 bin = (int32)(((axis == 0 ? c.x : c.y) - minCenter) * binScale);
+				if (b2Clamp(bin, 0, b2_sahBinCount - 1) <= splitBin)
+				{
+					b2Swap(leaves[i], leaves[left]);
+					++left;
+				}
+			}
+			b2Assert(left == split);
+		}
+	}
+
+	// Fall back to a median split when the centers can't be told apart.
+	if (split == 0)
+	{
+		split = count / 2;
+		b2LeafCenterLess less;
+		less.nodes = m_nodes;
+		less.axis = axis;
+		std::nth_element(leaves, leaves + split, leaves + count, less);
+	}
+
+	int32 child1 = BuildSAH(leaves, split);
+	int32 child2 = BuildSAH(leaves + split, count - split);
+
+	b2TreeNode* node = m_nodes + nodeId;
+	node->child1 = child1;
+	node->child2 = child2;
+	node->aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+	node->height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+	m_nodes[child1].parent = nodeId;
+	m_nodes[child2].parent = nodeId;
+	return nodeId;
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
@@ -782,3 +1011,32 @@ void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 		m_nodes[i].aabb.upperBound -= newOrigin;
 	}
 }
+
+void b2DynamicTree::Save(b2SnapshotWriter* writer) const
+{
+	writer->Write(m_root);
+	writer->Write(m_nodeCount);
+	writer->Write(m_nodeCapacity);
+	writer->Write(m_freeList);
+	writer->Write(m_path);
+	writer->Write(m_insertionCount);
+	writer->Write(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+}
+
+void b2DynamicTree::Restore(b2SnapshotReader* reader)
+{
+	m_root = reader->Read<int32>();
+	m_nodeCount = reader->Read<int32>();
+	int32 nodeCapacity = reader->Read<int32>();
+	m_freeList = reader->Read<int32>();
+	m_path = reader->Read<uint32>();
+	m_insertionCount = reader->Read<int32>();
+
+	if (nodeCapacity != m_nodeCapacity)
+	{
+		b2Free(m_nodes);
+		m_nodeCapacity = nodeCapacity;
+		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	}
+	reader->Read(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+}
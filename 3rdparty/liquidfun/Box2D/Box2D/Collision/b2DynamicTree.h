@@ -21,9 +21,43 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
+#include <Box2D/Common/b2Float4.h>
 
 #define b2_nullNode (-1)
 
+class b2SnapshotReader;
+class b2SnapshotWriter;
+
+/// An AABB prepared for b2TestOverlap4(): the upper bound followed by
+/// b2_maxFloat twice, then -b2_maxFloat twice followed by the lower bound.
+struct b2OverlapQuery4
+{
+	b2Float4 upper;
+	b2Float4 lower;
+};
+
+inline b2OverlapQuery4 b2PrepareOverlap4(const b2AABB& aabb)
+{
+	const float32 upper[4] = { aabb.upperBound.x, aabb.upperBound.y,
+							   b2_maxFloat, b2_maxFloat };
+	const float32 lower[4] = { -b2_maxFloat, -b2_maxFloat,
+							   aabb.lowerBound.x, aabb.lowerBound.y };
+	b2OverlapQuery4 query;
+	query.upper = b2Load4(upper);
+	query.lower = b2Load4(lower);
+	return query;
+}
+
+/// Same as b2TestOverlap(a, b) for b prepared with b2PrepareOverlap4(), but
+/// compares all four bounds at once.
+inline bool b2TestOverlap4(const b2AABB& a, const b2OverlapQuery4& b)
+{
+	// (a.lower, a.upper) <= (b.upper, max) and (-max, b.lower) <= a.upper.
+	b2Float4 bounds = b2Load4(&a.lowerBound.x);
+	return b2AllTrue(b2And(b2LessEqual(bounds, b.upper),
+						   b2LessEqual(b.lower, bounds)));
+}
+
 /// A node in the dynamic tree. The client does not interact with this directly.
 struct b2TreeNode
 {
@@ -118,11 +152,34 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Rebuild the tree top down, splitting the proxies where the surface
+	/// area heuristic (SAH) estimates queries to be cheapest. The internal
+	/// nodes are stored in depth-first order, so that a query mostly walks
+	/// forward in memory. Proxy ids don't change. This costs O(n log n) and
+	/// is meant for trees that rarely change, such as static geometry.
+	void Rebuild();
+
+	/// Create many proxies at once and build the tree with Rebuild(). This
+	/// is much faster than creating them one by one into a large tree.
+	/// @param aabbs tight fitting AABBs of the proxies.
+	/// @param userData user data of each proxy.
+	/// @param count the number of proxies.
+	/// @param proxyIds receives the id of each proxy.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData,
+					   int32 count, int32* proxyIds);
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Write the whole tree, including its free nodes, to a snapshot.
+	void Save(b2SnapshotWriter* writer) const;
+
+	/// Read back a tree written with Save(). The user data of the proxies
+	/// is restored as it was.
+	void Restore(b2SnapshotReader* reader);
+
 private:
 
 	int32 AllocateNode();
@@ -133,6 +190,8 @@ private:
 
 	int32 Balance(int32 index);
 
+	int32 BuildSAH(int32* leaves, int32 count);
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
@@ -170,6 +229,9 @@ inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 {
 	b2GrowableStack<int32, 256> stack;
 	stack.Push(m_root);
+#if defined(LIQUIDFUN_SIMD_SSE)
+	const b2OverlapQuery4 query = b2PrepareOverlap4(aabb);
+#endif // defined(LIQUIDFUN_SIMD_SSE)
 
 	while (stack.GetCount() > 0)
 	{
@@ -181,7 +243,11 @@ inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 
 		const b2TreeNode* node = m_nodes + nodeId;
 
+#if defined(LIQUIDFUN_SIMD_SSE)
+		if (b2TestOverlap4(node->aabb, query))
+#else
 		if (b2TestOverlap(node->aabb, aabb))
+#endif // defined(LIQUIDFUN_SIMD_SSE)
 		{
 			if (node->IsLeaf())
 			{
@@ -228,6 +294,9 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 
 	b2GrowableStack<int32, 256> stack;
 	stack.Push(m_root);
+#if defined(LIQUIDFUN_SIMD_SSE)
+	b2OverlapQuery4 segmentQuery = b2PrepareOverlap4(segmentAABB);
+#endif // defined(LIQUIDFUN_SIMD_SSE)
 
 	while (stack.GetCount() > 0)
 	{
@@ -239,7 +308,11 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 
 		const b2TreeNode* node = m_nodes + nodeId;
 
+#if defined(LIQUIDFUN_SIMD_SSE)
+		if (b2TestOverlap4(node->aabb, segmentQuery) == false)
+#else
 		if (b2TestOverlap(node->aabb, segmentAABB) == false)
+#endif // defined(LIQUIDFUN_SIMD_SSE)
 		{
 			continue;
 		}
@@ -276,6 +349,9 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 				b2Vec2 t = p1 + maxFraction * (p2 - p1);
 				segmentAABB.lowerBound = b2Min(p1, t);
 				segmentAABB.upperBound = b2Max(p1, t);
+#if defined(LIQUIDFUN_SIMD_SSE)
+				segmentQuery = b2PrepareOverlap4(segmentAABB);
+#endif // defined(LIQUIDFUN_SIMD_SSE)
 			}
 		}
 		else
@@ -0,0 +1,242 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#ifndef B2_FLOAT4_H
+#define B2_FLOAT4_H
+
+#include <Box2D/Common/b2Settings.h>
+
+#if defined(LIQUIDFUN_SIMD_SSE)
+#include <emmintrin.h>
+#else
+#include <math.h>
+#endif // defined(LIQUIDFUN_SIMD_SSE)
+
+/// Four floats processed in parallel. Uses SSE2 when LIQUIDFUN_SIMD_SSE is
+/// defined and plain arrays otherwise. Comparisons return masks with all
+/// bits of a lane set, which b2Select() uses to choose between two values.
+struct b2Float4
+{
+#if defined(LIQUIDFUN_SIMD_SSE)
+	__m128 v;
+#else
+	union
+	{
+		float32 f[4];
+		uint32 u[4];
+	};
+#endif // defined(LIQUIDFUN_SIMD_SSE)
+};
+
+#if defined(LIQUIDFUN_SIMD_SSE)
+
+inline b2Float4 b2MakeFloat4(__m128 v)
+{
+	b2Float4 r;
+	r.v = v;
+	return r;
+}
+
+/// Load four floats. p does not need to be aligned.
+inline b2Float4 b2Load4(const float32* p)
+{
+	return b2MakeFloat4(_mm_loadu_ps(p));
+}
+
+/// Store four floats. p does not need to be aligned.
+inline void b2Store4(float32* p, const b2Float4& a)
+{
+	_mm_storeu_ps(p, a.v);
+}
+
+inline b2Float4 b2Splat4(float32 s)
+{
+	return b2MakeFloat4(_mm_set1_ps(s));
+}
+
+inline b2Float4 operator+(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_add_ps(a.v, b.v));
+}
+
+inline b2Float4 operator-(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_sub_ps(a.v, b.v));
+}
+
+inline b2Float4 operator*(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_mul_ps(a.v, b.v));
+}
+
+inline b2Float4 operator/(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_div_ps(a.v, b.v));
+}
+
+inline b2Float4 operator-(const b2Float4& a)
+{
+	return b2MakeFloat4(_mm_sub_ps(_mm_setzero_ps(), a.v));
+}
+
+inline b2Float4 b2Min(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_min_ps(a.v, b.v));
+}
+
+inline b2Float4 b2Max(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_max_ps(a.v, b.v));
+}
+
+inline b2Float4 b2Sqrt(const b2Float4& a)
+{
+	return b2MakeFloat4(_mm_sqrt_ps(a.v));
+}
+
+inline b2Float4 b2GreaterEqual(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_cmpge_ps(a.v, b.v));
+}
+
+inline b2Float4 b2Greater(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_cmpgt_ps(a.v, b.v));
+}
+
+inline b2Float4 b2Less(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_cmplt_ps(a.v, b.v));
+}
+
+inline b2Float4 b2LessEqual(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_cmple_ps(a.v, b.v));
+}
+
+/// Check whether all lanes of a mask are set.
+inline bool b2AllTrue(const b2Float4& mask)
+{
+	return _mm_movemask_ps(mask.v) == 0xF;
+}
+
+inline b2Float4 b2And(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_and_ps(a.v, b.v));
+}
+
+inline b2Float4 b2Or(const b2Float4& a, const b2Float4& b)
+{
+	return b2MakeFloat4(_mm_or_ps(a.v, b.v));
+}
+
+/// Per lane mask ? a : b.
+inline b2Float4 b2Select(const b2Float4& mask, const b2Float4& a,
+						 const b2Float4& b)
+{
+	return b2MakeFloat4(
+		_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)));
+}
+
+#else
+
+/// Load four floats. p does not need to be aligned.
+inline b2Float4 b2Load4(const float32* p)
+{
+	b2Float4 r;
+	for (int32 i = 0; i < 4; ++i) r.f[i] = p[i];
+	return r;
+}
+
+/// Store four floats. p does not need to be aligned.
+inline void b2Store4(float32* p, const b2Float4& a)
+{
+	for (int32 i = 0; i < 4; ++i) p[i] = a.f[i];
+}
+
+inline b2Float4 b2Splat4(float32 s)
+{
+	b2Float4 r;
+	for (int32 i = 0; i < 4; ++i) r.f[i] = s;
+	return r;
+}
+
+#define B2_FLOAT4_BINARY_OP(name, expr) \
+	inline b2Float4 name(const b2Float4& a, const b2Float4& b) \
+	{ \
+		b2Float4 r; \
+		for (int32 i = 0; i < 4; ++i) expr; \
+		return r; \
+	}
+
+B2_FLOAT4_BINARY_OP(operator+, r.f[i] = a.f[i] + b.f[i])
+B2_FLOAT4_BINARY_OP(operator-, r.f[i] = a.f[i] - b.f[i])
+B2_FLOAT4_BINARY_OP(operator*, r.f[i] = a.f[i] * b.f[i])
+B2_FLOAT4_BINARY_OP(operator/, r.f[i] = a.f[i] / b.f[i])
+B2_FLOAT4_BINARY_OP(b2Min, r.f[i] = a.f[i] < b.f[i] ? a.f[i] : b.f[i])
+B2_FLOAT4_BINARY_OP(b2Max, r.f[i] = a.f[i] > b.f[i] ? a.f[i] : b.f[i])
+B2_FLOAT4_BINARY_OP(b2GreaterEqual, r.u[i] = a.f[i] >= b.f[i] ? ~0u : 0u)
+B2_FLOAT4_BINARY_OP(b2Greater, r.u[i] = a.f[i] > b.f[i] ? ~0u : 0u)
+B2_FLOAT4_BINARY_OP(b2Less, r.u[i] = a.f[i] < b.f[i] ? ~0u : 0u)
+B2_FLOAT4_BINARY_OP(b2LessEqual, r.u[i] = a.f[i] <= b.f[i] ? ~0u : 0u)
+B2_FLOAT4_BINARY_OP(b2And, r.u[i] = a.u[i] & b.u[i])
+B2_FLOAT4_BINARY_OP(b2Or, r.u[i] = a.u[i] | b.u[i])
+
+#undef B2_FLOAT4_BINARY_OP
+
+inline b2Float4 operator-(const b2Float4& a)
+{
+	b2Float4 r;
+	for (int32 i = 0; i < 4; ++i) r.f[i] = -a.f[i];
+	return r;
+}
+
+inline b2Float4 b2Sqrt(const b2Float4& a)
+{
+	b2Float4 r;
+	for (int32 i = 0; i < 4; ++i) r.f[i] = sqrtf(a.f[i]);
+	return r;
+}
+
+/// Check whether all lanes of a mask are set.
+inline bool b2AllTrue(const b2Float4& mask)
+{
+	return (mask.u[0] & mask.u[1] & mask.u[2] & mask.u[3]) != 0;
+}
+
+/// Per lane mask ? a : b.
+inline b2Float4 b2Select(const b2Float4& mask, const b2Float4& a,
+						 const b2Float4& b)
+{
+	b2Float4 r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.u[i] = (mask.u[i] & a.u[i]) | (~mask.u[i] & b.u[i]);
+	}
+	return r;
+}
+
+#endif // defined(LIQUIDFUN_SIMD_SSE)
+
+/// Cross product of (ax, ay) and (bx, by) in each lane.
+inline b2Float4 b2Cross4(const b2Float4& ax, const b2Float4& ay,
+						 const b2Float4& bx, const b2Float4& by)
+{
+	return ax * by - ay * bx;
+}
+
+#endif
@@ -157,6 +157,12 @@ typedef unsigned long long uint64;
 #define b2_toiBaugarte				0.75f
 
 
+/// Use SSE2 for the wide contact solver when the compiler targets it.
+#if !defined(LIQUIDFUN_SIMD_SSE) && (defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LIQUIDFUN_SIMD_SSE
+#endif
+
 // Particle
 
 /// NEON SIMD requires 16-bit particle indices
@@ -0,0 +1,121 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#ifndef B2_SNAPSHOT_H
+#define B2_SNAPSHOT_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <string.h>
+
+/// Writes the parts of a world snapshot one after the other into a buffer.
+/// Keeps counting the size when the buffer is full, so that writing into a
+/// NULL buffer gives the size needed.
+class b2SnapshotWriter
+{
+public:
+	b2SnapshotWriter(void* buffer, int32 capacity) :
+		m_buffer((uint8*)buffer),
+		m_capacity(buffer ? capacity : 0),
+		m_size(0)
+	{
+	}
+
+	void Write(const void* data, int32 size)
+	{
+		// Empty buffers are written with a NULL pointer, which must not
+		// reach memcpy.
+		if (size == 0)
+		{
+			return;
+		}
+		WriteAt(m_size, data, size);
+		m_size += size;
+	}
+
+	template <typename T>
+	void Write(const T& value)
+	{
+		Write(&value, sizeof(T));
+	}
+
+	/// Overwrite something written earlier.
+	void WriteAt(int32 position, const void* data, int32 size)
+	{
+		if (size > 0 && position + size <= m_capacity)
+		{
+			memcpy(m_buffer + position, data, size);
+		}
+	}
+
+	/// Get the number of bytes written, or that would have been written if
+	/// the buffer was large enough.
+	int32 GetSize() const { return m_size; }
+
+private:
+	uint8* m_buffer;
+	int32 m_capacity;
+	int32 m_size;
+};
+
+/// Reads back what was written with b2SnapshotWriter, in the same order.
+class b2SnapshotReader
+{
+public:
+	b2SnapshotReader(const void* buffer, int32 size) :
+		m_buffer((const uint8*)buffer),
+		m_size(size),
+		m_position(0)
+	{
+	}
+
+	void Read(void* data, int32 size)
+	{
+		// Empty buffers are read into a NULL pointer.
+		if (size == 0)
+		{
+			return;
+		}
+		b2Assert(m_position + size <= m_size);
+		if (m_position + size <= m_size)
+		{
+			memcpy(data, m_buffer + m_position, size);
+		}
+		else
+		{
+			memset(data, 0, size);
+		}
+		m_position += size;
+	}
+
+	template <typename T>
+	T Read()
+	{
+		T value;
+		Read(&value, sizeof(T));
+		return value;
+	}
+
+	/// Get the number of bytes left to read.
+	int32 GetRemaining() const { return m_size - m_position; }
+
+private:
+	const uint8* m_buffer;
+	int32 m_size;
+	int32 m_position;
+};
+
+#endif
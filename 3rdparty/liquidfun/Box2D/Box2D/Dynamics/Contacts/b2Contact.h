@@ -189,6 +189,17 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// Compute the manifold for the current transforms, with the impulses of
+	// matching points carried over, and return whether the fixtures touch.
+	// The contact isn't changed, so different contacts can be done at the
+	// same time.
+	bool ComputeManifold(b2Manifold* manifold);
+
+	// Store a manifold from ComputeManifold() and notify the listener of
+	// the changes.
+	void ApplyManifold(const b2Manifold& manifold, bool touching,
+					   b2ContactListener* listener);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
@@ -26,7 +26,7 @@
 class b2Contact;
 class b2Body;
 class b2StackAllocator;
-struct b2ContactPositionConstraint;
+class b2WideContactSolver;
 
 struct b2VelocityConstraintPoint
 {
@@ -56,6 +56,21 @@ struct b2ContactVelocityConstraint
 	int32 contactIndex;
 };
 
+struct b2ContactPositionConstraint
+{
+	b2Vec2 localPoints[b2_maxManifoldPoints];
+	b2Vec2 localNormal;
+	b2Vec2 localPoint;
+	int32 indexA;
+	int32 indexB;
+	float32 invMassA, invMassB;
+	b2Vec2 localCenterA, localCenterB;
+	float32 invIA, invIB;
+	b2Manifold::Type type;
+	float32 radiusA, radiusB;
+	int32 pointCount;
+};
+
 struct b2ContactSolverDef
 {
 	b2TimeStep step;
@@ -89,6 +104,9 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+	/// Solves the constraints in batches when b2TimeStep::wideContactSolver
+	/// is set. NULL otherwise.
+	b2WideContactSolver* m_wideSolver;
 };
 
 #endif
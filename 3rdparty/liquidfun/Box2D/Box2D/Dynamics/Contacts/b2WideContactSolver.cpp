@@ -0,0 +1,756 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Contacts/b2WideContactSolver.h>
+
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Common/b2Float4.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+#include <memory.h>
+#include <string.h>
+
+// Constraints that don't fit in any of these colors get a batch of their
+// own.
+static const int32 k_maxColors = 32;
+
+// Velocities of the bodies of a batch, one lane per constraint.
+struct b2WideVelocities
+{
+	b2Float4 vAX, vAY, wA;
+	b2Float4 vBX, vBY, wB;
+};
+
+// Positions of the bodies of a batch, one lane per constraint.
+struct b2WidePositions
+{
+	b2Float4 cAX, cAY, aA;
+	b2Float4 cBX, cBY, aB;
+};
+
+static inline bool IsMovable(float32 invMass, float32 invI)
+{
+	return invMass != 0.0f || invI != 0.0f;
+}
+
+static void GatherVelocities(const b2Velocity* velocities,
+							 const b2WideVelocityConstraint& c,
+							 b2WideVelocities* out)
+{
+	float32 vAX[b2_wideSolverLanes], vAY[b2_wideSolverLanes];
+	float32 wA[b2_wideSolverLanes];
+	float32 vBX[b2_wideSolverLanes], vBY[b2_wideSolverLanes];
+	float32 wB[b2_wideSolverLanes];
+	for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+	{
+		if (c.constraints[lane] < 0)
+		{
+			vAX[lane] = vAY[lane] = wA[lane] = 0.0f;
+			vBX[lane] = vBY[lane] = wB[lane] = 0.0f;
+			continue;
+		}
+		const b2Velocity& a = velocities[c.indexA[lane]];
+		const b2Velocity& b = velocities[c.indexB[lane]];
+		vAX[lane] = a.v.x;
+		vAY[lane] = a.v.y;
+		wA[lane] = a.w;
+		vBX[lane] = b.v.x;
+		vBY[lane] = b.v.y;
+		wB[lane] = b.w;
+	}
+	out->vAX = b2Load4(vAX);
+	out->vAY = b2Load4(vAY);
+	out->wA = b2Load4(wA);
+	out->vBX = b2Load4(vBX);
+	out->vBY = b2Load4(vBY);
+	out->wB = b2Load4(wB);
+}
+
+static void ScatterVelocities(const b2WideVelocities& in,
+							  const b2WideVelocityConstraint& c,
+							  b2Velocity* velocities)
+{
+	float32 vAX[b2_wideSolverLanes], vAY[b2_wideSolverLanes];
+	float32 wA[b2_wideSolverLanes];
+	float32 vBX[b2_wideSolverLanes], vBY[b2_wideSolverLanes];
+	float32 wB[b2_wideSolverLanes];
+	b2Store4(vAX, in.vAX);
+	b2Store4(vAY, in.vAY);
+	b2Store4(wA, in.wA);
+	b2Store4(vBX, in.vBX);
+	b2Store4(vBY, in.vBY);
+	b2Store4(wB, in.wB);
+	for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+	{
+		if (c.constraints[lane] < 0)
+		{
+			continue;
+		}
+		b2Velocity& a = velocities[c.indexA[lane]];
+		b2Velocity& b = velocities[c.indexB[lane]];
+		a.v.Set(vAX[lane], vAY[lane]);
+		a.w = wA[lane];
+		b.v.Set(vBX[lane], vBY[lane]);
+		b.w = wB[lane];
+	}
+}
+
+static void GatherPositions(const b2Position* positions,
+							const b2WideVelocityConstraint& c,
+							b2WidePositions* out)
+{
+	float32 cAX[b2_wideSolverLanes], cAY[b2_wideSolverLanes];
+	float32 aA[b2_wideSolverLanes];
+	float32 cBX[b2_wideSolverLanes], cBY[b2_wideSolverLanes];
+	float32 aB[b2_wideSolverLanes];
+	for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+	{
+		if (c.constraints[lane] < 0)
+		{
+			cAX[lane] = cAY[lane] = aA[lane] = 0.0f;
+			cBX[lane] = cBY[lane] = aB[lane] = 0.0f;
+			continue;
+		}
+		const b2Position& a = positions[c.indexA[lane]];
+		const b2Position& b = positions[c.indexB[lane]];
+		cAX[lane] = a.c.x;
+		cAY[lane] = a.c.y;
+		aA[lane] = a.a;
+		cBX[lane] = b.c.x;
+		cBY[lane] = b.c.y;
+		aB[lane] = b.a;
+	}
+	out->cAX = b2Load4(cAX);
+	out->cAY = b2Load4(cAY);
+	out->aA = b2Load4(aA);
+	out->cBX = b2Load4(cBX);
+	out->cBY = b2Load4(cBY);
+	out->aB = b2Load4(aB);
+}
+
+static void ScatterPositions(const b2WidePositions& in,
+							 const b2WideVelocityConstraint& c,
+							 b2Position* positions)
+{
+	float32 cAX[b2_wideSolverLanes], cAY[b2_wideSolverLanes];
+	float32 aA[b2_wideSolverLanes];
+	float32 cBX[b2_wideSolverLanes], cBY[b2_wideSolverLanes];
+	float32 aB[b2_wideSolverLanes];
+	b2Store4(cAX, in.cAX);
+	b2Store4(cAY, in.cAY);
+	b2Store4(aA, in.aA);
+	b2Store4(cBX, in.cBX);
+	b2Store4(cBY, in.cBY);
+	b2Store4(aB, in.aB);
+	for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+	{
+		if (c.constraints[lane] < 0)
+		{
+			continue;
+		}
+		b2Position& a = positions[c.indexA[lane]];
+		b2Position& b = positions[c.indexB[lane]];
+		a.c.Set(cAX[lane], cAY[lane]);
+		a.a = aA[lane];
+		b.c.Set(cBX[lane], cBY[lane]);
+		b.a = aB[lane];
+	}
+}
+
+// Compute the sine and cosine of each lane.
+static void SinCos4(const b2Float4& angle, b2Float4* s, b2Float4* c)
+{
+	float32 a[b2_wideSolverLanes];
+	float32 sa[b2_wideSolverLanes], ca[b2_wideSolverLanes];
+	b2Store4(a, angle);
+	for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+	{
+		sa[lane] = sinf(a[lane]);
+		ca[lane] = cosf(a[lane]);
+	}
+	*s = b2Load4(sa);
+	*c = b2Load4(ca);
+}
+
+b2WideContactSolver::b2WideContactSolver(b2ContactSolver* solver)
+{
+	m_solver = solver;
+	m_allocator = solver->m_allocator;
+	m_positions = solver->m_positions;
+	m_velocities = solver->m_velocities;
+
+	int32 colorCounts[k_maxColors + 1];
+	m_colors = (int32*)m_allocator->Allocate(
+		solver->m_count * sizeof(int32));
+	m_batchCount = ColorConstraints(colorCounts);
+	m_velocityConstraints = (b2WideVelocityConstraint*)m_allocator->Allocate(
+		m_batchCount * sizeof(b2WideVelocityConstraint));
+	m_positionConstraints = (b2WidePositionConstraint*)m_allocator->Allocate(
+		m_batchCount * sizeof(b2WidePositionConstraint));
+	InitializeBatches(colorCounts);
+}
+
+b2WideContactSolver::~b2WideContactSolver()
+{
+	m_allocator->Free(m_positionConstraints);
+	m_allocator->Free(m_velocityConstraints);
+	m_allocator->Free(m_colors);
+}
+
+// Greedily color the constraints so that a body that can move never has
+// two constraints of the same color. Bodies that can't move are shared
+// freely since the solver never changes them. Returns the number of batches.
+int32 b2WideContactSolver::ColorConstraints(int32* colorCounts)
+{
+	const b2ContactVelocityConstraint* constraints =
+		m_solver->m_velocityConstraints;
+	const int32 count = m_solver->m_count;
+
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = constraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(vc->indexA, vc->indexB) + 1);
+	}
+
+	// Colors used by the constraints of each body.
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(
+		bodyCount * sizeof(uint32));
+	memset(bodyColors, 0, bodyCount * sizeof(uint32));
+	memset(colorCounts, 0, (k_maxColors + 1) * sizeof(int32));
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = constraints + i;
+		const bool movableA = IsMovable(vc->invMassA, vc->invIA);
+		const bool movableB = IsMovable(vc->invMassB, vc->invIB);
+		uint32 used = 0;
+		if (movableA)
+		{
+			used |= bodyColors[vc->indexA];
+		}
+		if (movableB)
+		{
+			used |= bodyColors[vc->indexB];
+		}
+
+		int32 color = 0;
+		while (color < k_maxColors && (used & (1u << color)))
+		{
+			++color;
+		}
+		if (color < k_maxColors)
+		{
+			if (movableA)
+			{
+				bodyColors[vc->indexA] |= 1u << color;
+			}
+			if (movableB)
+			{
+				bodyColors[vc->indexB] |= 1u << color;
+			}
+		}
+		m_colors[i] = color;
+		++colorCounts[color];
+	}
+
+	m_allocator->Free(bodyColors);
+
+	int32 batchCount = colorCounts[k_maxColors];
+	for (int32 color = 0; color < k_maxColors; ++color)
+	{
+		batchCount += (colorCounts[color] + b2_wideSolverLanes - 1) /
+			b2_wideSolverLanes;
+	}
+	return batchCount;
+}
+
+// Copy the scalar constraints into the lanes of the batches, in color order.
+void b2WideContactSolver::InitializeBatches(const int32* colorCounts)
+{
+	memset(m_velocityConstraints, 0,
+		   m_batchCount * sizeof(b2WideVelocityConstraint));
+	memset(m_positionConstraints, 0,
+		   m_batchCount * sizeof(b2WidePositionConstraint));
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+		{
+			m_velocityConstraints[i].constraints[lane] = -1;
+		}
+	}
+
+	// Next free lane of each color, counted over all batches.
+	int32 next[k_maxColors + 1];
+	int32 slot = 0;
+	for (int32 color = 0; color < k_maxColors; ++color)
+	{
+		next[color] = slot;
+		slot += (colorCounts[color] + b2_wideSolverLanes - 1) /
+			b2_wideSolverLanes * b2_wideSolverLanes;
+	}
+	next[k_maxColors] = slot;
+
+	for (int32 i = 0; i < m_solver->m_count; ++i)
+	{
+		const int32 color = m_colors[i];
+		const int32 s = next[color];
+		next[color] += color < k_maxColors ? 1 : b2_wideSolverLanes;
+		const int32 batch = s / b2_wideSolverLanes;
+		const int32 lane = s % b2_wideSolverLanes;
+
+		const b2ContactVelocityConstraint* vc =
+			m_solver->m_velocityConstraints + i;
+		b2WideVelocityConstraint* wvc = m_velocityConstraints + batch;
+		wvc->constraints[lane] = i;
+		wvc->indexA[lane] = vc->indexA;
+		wvc->indexB[lane] = vc->indexB;
+		wvc->normalX[lane] = vc->normal.x;
+		wvc->normalY[lane] = vc->normal.y;
+		wvc->invMassA[lane] = vc->invMassA;
+		wvc->invMassB[lane] = vc->invMassB;
+		wvc->invIA[lane] = vc->invIA;
+		wvc->invIB[lane] = vc->invIB;
+		wvc->friction[lane] = vc->friction;
+		wvc->tangentSpeed[lane] = vc->tangentSpeed;
+		for (int32 j = 0; j < vc->pointCount; ++j)
+		{
+			const b2VelocityConstraintPoint* vcp = vc->points + j;
+			wvc->rAX[j][lane] = vcp->rA.x;
+			wvc->rAY[j][lane] = vcp->rA.y;
+			wvc->rBX[j][lane] = vcp->rB.x;
+			wvc->rBY[j][lane] = vcp->rB.y;
+			wvc->normalImpulse[j][lane] = vcp->normalImpulse;
+			wvc->tangentImpulse[j][lane] = vcp->tangentImpulse;
+			wvc->normalMass[j][lane] = vcp->normalMass;
+			wvc->tangentMass[j][lane] = vcp->tangentMass;
+			wvc->velocityBias[j][lane] = vcp->velocityBias;
+		}
+		if (vc->pointCount == 2)
+		{
+			wvc->blockSolve[lane] = 1.0f;
+			wvc->k11[lane] = vc->K.ex.x;
+			wvc->k12[lane] = vc->K.ey.x;
+			wvc->k22[lane] = vc->K.ey.y;
+			wvc->normalMass11[lane] = vc->normalMass.ex.x;
+			wvc->normalMass12[lane] = vc->normalMass.ey.x;
+			wvc->normalMass22[lane] = vc->normalMass.ey.y;
+		}
+
+		const b2ContactPositionConstraint* pc =
+			m_solver->m_positionConstraints + i;
+		b2WidePositionConstraint* wpc = m_positionConstraints + batch;
+		for (int32 j = 0; j < pc->pointCount; ++j)
+		{
+			wpc->localPointsX[j][lane] = pc->localPoints[j].x;
+			wpc->localPointsY[j][lane] = pc->localPoints[j].y;
+			wpc->pointActive[j][lane] = 1.0f;
+		}
+		wpc->localNormalX[lane] = pc->localNormal.x;
+		wpc->localNormalY[lane] = pc->localNormal.y;
+		wpc->localPointX[lane] = pc->localPoint.x;
+		wpc->localPointY[lane] = pc->localPoint.y;
+		wpc->localCenterAX[lane] = pc->localCenterA.x;
+		wpc->localCenterAY[lane] = pc->localCenterA.y;
+		wpc->localCenterBX[lane] = pc->localCenterB.x;
+		wpc->localCenterBY[lane] = pc->localCenterB.y;
+		wpc->invMassA[lane] = pc->invMassA;
+		wpc->invMassB[lane] = pc->invMassB;
+		wpc->invIA[lane] = pc->invIA;
+		wpc->invIB[lane] = pc->invIB;
+		wpc->radiusA[lane] = pc->radiusA;
+		wpc->radiusB[lane] = pc->radiusB;
+		wpc->circles[lane] = pc->type == b2Manifold::e_circles ? 1.0f : 0.0f;
+		wpc->faceB[lane] = pc->type == b2Manifold::e_faceB ? 1.0f : 0.0f;
+	}
+}
+
+void b2WideContactSolver::WarmStart()
+{
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		const b2WideVelocityConstraint& c = m_velocityConstraints[i];
+
+		b2WideVelocities v;
+		GatherVelocities(m_velocities, c, &v);
+
+		const b2Float4 mA = b2Load4(c.invMassA);
+		const b2Float4 iA = b2Load4(c.invIA);
+		const b2Float4 mB = b2Load4(c.invMassB);
+		const b2Float4 iB = b2Load4(c.invIB);
+		const b2Float4 normalX = b2Load4(c.normalX);
+		const b2Float4 normalY = b2Load4(c.normalY);
+		const b2Float4 tangentX = normalY;
+		const b2Float4 tangentY = -normalX;
+
+		// Single point lanes have no impulse on the second point.
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			const b2Float4 normalImpulse = b2Load4(c.normalImpulse[j]);
+			const b2Float4 tangentImpulse = b2Load4(c.tangentImpulse[j]);
+			const b2Float4 rAX = b2Load4(c.rAX[j]);
+			const b2Float4 rAY = b2Load4(c.rAY[j]);
+			const b2Float4 rBX = b2Load4(c.rBX[j]);
+			const b2Float4 rBY = b2Load4(c.rBY[j]);
+
+			const b2Float4 PX = normalImpulse * normalX +
+				tangentImpulse * tangentX;
+			const b2Float4 PY = normalImpulse * normalY +
+				tangentImpulse * tangentY;
+			v.wA = v.wA - iA * b2Cross4(rAX, rAY, PX, PY);
+			v.vAX = v.vAX - mA * PX;
+			v.vAY = v.vAY - mA * PY;
+			v.wB = v.wB + iB * b2Cross4(rBX, rBY, PX, PY);
+			v.vBX = v.vBX + mB * PX;
+			v.vBY = v.vBY + mB * PY;
+		}
+
+		ScatterVelocities(v, c, m_velocities);
+	}
+}
+
+void b2WideContactSolver::SolveVelocityConstraints()
+{
+	const b2Float4 zero = b2Splat4(0.0f);
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2WideVelocityConstraint& c = m_velocityConstraints[i];
+
+		b2WideVelocities v;
+		GatherVelocities(m_velocities, c, &v);
+
+		const b2Float4 mA = b2Load4(c.invMassA);
+		const b2Float4 iA = b2Load4(c.invIA);
+		const b2Float4 mB = b2Load4(c.invMassB);
+		const b2Float4 iB = b2Load4(c.invIB);
+		const b2Float4 normalX = b2Load4(c.normalX);
+		const b2Float4 normalY = b2Load4(c.normalY);
+		const b2Float4 tangentX = normalY;
+		const b2Float4 tangentY = -normalX;
+		const b2Float4 friction = b2Load4(c.friction);
+		const b2Float4 tangentSpeed = b2Load4(c.tangentSpeed);
+
+		b2Float4 rAX[b2_maxManifoldPoints], rAY[b2_maxManifoldPoints];
+		b2Float4 rBX[b2_maxManifoldPoints], rBY[b2_maxManifoldPoints];
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			rAX[j] = b2Load4(c.rAX[j]);
+			rAY[j] = b2Load4(c.rAY[j]);
+			rBX[j] = b2Load4(c.rBX[j]);
+			rBY[j] = b2Load4(c.rBY[j]);
+		}
+
+		// Solve tangent constraints first because non-penetration is more
+		// important than friction. The second point of a single point lane
+		// has no mass, so it applies no impulse.
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			// Relative velocity at contact
+			const b2Float4 dvX = v.vBX - v.wB * rBY[j] - v.vAX + v.wA * rAY[j];
+			const b2Float4 dvY = v.vBY + v.wB * rBX[j] - v.vAY - v.wA * rAX[j];
+
+			// Compute tangent force
+			const b2Float4 vt = dvX * tangentX + dvY * tangentY - tangentSpeed;
+			b2Float4 lambda = b2Load4(c.tangentMass[j]) * -vt;
+
+			// b2Clamp the accumulated force
+			const b2Float4 maxFriction = friction * b2Load4(c.normalImpulse[j]);
+			const b2Float4 oldImpulse = b2Load4(c.tangentImpulse[j]);
+			const b2Float4 newImpulse = b2Max(-maxFriction,
+				b2Min(oldImpulse + lambda, maxFriction));
+			lambda = newImpulse - oldImpulse;
+			b2Store4(c.tangentImpulse[j], newImpulse);
+
+			// Apply contact impulse
+			const b2Float4 PX = lambda * tangentX;
+			const b2Float4 PY = lambda * tangentY;
+
+			v.vAX = v.vAX - mA * PX;
+			v.vAY = v.vAY - mA * PY;
+			v.wA = v.wA - iA * b2Cross4(rAX[j], rAY[j], PX, PY);
+
+			v.vBX = v.vBX + mB * PX;
+			v.vBY = v.vBY + mB * PY;
+			v.wB = v.wB + iB * b2Cross4(rBX[j], rBY[j], PX, PY);
+		}
+
+		// Solve normal constraints. Every lane evaluates both the single
+		// point solution and the block solver of b2ContactSolver and then
+		// keeps the one that matches its point count.
+		const b2Float4 a1 = b2Load4(c.normalImpulse[0]);
+		const b2Float4 a2 = b2Load4(c.normalImpulse[1]);
+		const b2Float4 bias1 = b2Load4(c.velocityBias[0]);
+		const b2Float4 bias2 = b2Load4(c.velocityBias[1]);
+		const b2Float4 normalMass1 = b2Load4(c.normalMass[0]);
+		const b2Float4 normalMass2 = b2Load4(c.normalMass[1]);
+
+		// Relative velocity at contact
+		const b2Float4 dv1X = v.vBX - v.wB * rBY[0] - v.vAX + v.wA * rAY[0];
+		const b2Float4 dv1Y = v.vBY + v.wB * rBX[0] - v.vAY - v.wA * rAX[0];
+		const b2Float4 dv2X = v.vBX - v.wB * rBY[1] - v.vAX + v.wA * rAY[1];
+		const b2Float4 dv2Y = v.vBY + v.wB * rBX[1] - v.vAY - v.wA * rAX[1];
+
+		// Compute normal velocity
+		const b2Float4 vn1 = dv1X * normalX + dv1Y * normalY;
+		const b2Float4 vn2 = dv2X * normalX + dv2Y * normalY;
+
+		// Single point: clamp the accumulated impulse.
+		const b2Float4 singleX1 = b2Max(a1 + -normalMass1 * (vn1 - bias1),
+										zero);
+
+		// Block solver: compute b' = b - K * a and test the cases in
+		// reverse order of preference so the first valid case wins. If no
+		// case is valid the impulse doesn't change.
+		const b2Float4 k11 = b2Load4(c.k11);
+		const b2Float4 k12 = b2Load4(c.k12);
+		const b2Float4 k22 = b2Load4(c.k22);
+		const b2Float4 b1 = vn1 - bias1 - (k11 * a1 + k12 * a2);
+		const b2Float4 b2 = vn2 - bias2 - (k12 * a1 + k22 * a2);
+
+		b2Float4 x1 = a1;
+		b2Float4 x2 = a2;
+		b2Float4 valid;
+
+		// Case 4: x1 = 0 and x2 = 0
+		valid = b2And(b2GreaterEqual(b1, zero), b2GreaterEqual(b2, zero));
+		x1 = b2Select(valid, zero, x1);
+		x2 = b2Select(valid, zero, x2);
+
+		// Case 3: vn2 = 0 and x1 = 0
+		const b2Float4 case3X2 = -normalMass2 * b2;
+		valid = b2And(b2GreaterEqual(case3X2, zero),
+					  b2GreaterEqual(k12 * case3X2 + b1, zero));
+		x1 = b2Select(valid, zero, x1);
+		x2 = b2Select(valid, case3X2, x2);
+
+		// Case 2: vn1 = 0 and x2 = 0
+		const b2Float4 case2X1 = -normalMass1 * b1;
+		valid = b2And(b2GreaterEqual(case2X1, zero),
+					  b2GreaterEqual(k12 * case2X1 + b2, zero));
+		x1 = b2Select(valid, case2X1, x1);
+		x2 = b2Select(valid, zero, x2);
+
+		// Case 1: vn = 0
+		const b2Float4 normalMass11 = b2Load4(c.normalMass11);
+		const b2Float4 normalMass12 = b2Load4(c.normalMass12);
+		const b2Float4 normalMass22 = b2Load4(c.normalMass22);
+		const b2Float4 case1X1 = -(normalMass11 * b1 + normalMass12 * b2);
+		const b2Float4 case1X2 = -(normalMass12 * b1 + normalMass22 * b2);
+		valid = b2And(b2GreaterEqual(case1X1, zero),
+					  b2GreaterEqual(case1X2, zero));
+		x1 = b2Select(valid, case1X1, x1);
+		x2 = b2Select(valid, case1X2, x2);
+
+		const b2Float4 block = b2Greater(b2Load4(c.blockSolve), zero);
+		x1 = b2Select(block, x1, singleX1);
+		x2 = b2Select(block, x2, a2);
+
+		// Apply incremental impulse
+		const b2Float4 d1 = x1 - a1;
+		const b2Float4 d2 = x2 - a2;
+		const b2Float4 P1X = d1 * normalX;
+		const b2Float4 P1Y = d1 * normalY;
+		const b2Float4 P2X = d2 * normalX;
+		const b2Float4 P2Y = d2 * normalY;
+
+		v.vAX = v.vAX - mA * (P1X + P2X);
+		v.vAY = v.vAY - mA * (P1Y + P2Y);
+		v.wA = v.wA - iA * (b2Cross4(rAX[0], rAY[0], P1X, P1Y) +
+							b2Cross4(rAX[1], rAY[1], P2X, P2Y));
+
+		v.vBX = v.vBX + mB * (P1X + P2X);
+		v.vBY = v.vBY + mB * (P1Y + P2Y);
+		v.wB = v.wB + iB * (b2Cross4(rBX[0], rBY[0], P1X, P1Y) +
+							b2Cross4(rBX[1], rBY[1], P2X, P2Y));
+
+		// Accumulate
+		b2Store4(c.normalImpulse[0], x1);
+		b2Store4(c.normalImpulse[1], x2);
+
+		ScatterVelocities(v, c, m_velocities);
+	}
+}
+
+void b2WideContactSolver::StoreImpulses()
+{
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		const b2WideVelocityConstraint& c = m_velocityConstraints[i];
+		for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+		{
+			if (c.constraints[lane] < 0)
+			{
+				continue;
+			}
+			b2ContactVelocityConstraint* vc =
+				m_solver->m_velocityConstraints + c.constraints[lane];
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				vc->points[j].normalImpulse = c.normalImpulse[j][lane];
+				vc->points[j].tangentImpulse = c.tangentImpulse[j][lane];
+			}
+		}
+	}
+}
+
+bool b2WideContactSolver::SolvePositionConstraints()
+{
+	const b2Float4 zero = b2Splat4(0.0f);
+	const b2Float4 half = b2Splat4(0.5f);
+	const b2Float4 epsilon = b2Splat4(b2_epsilon);
+	const b2Float4 baumgarte = b2Splat4(b2_baumgarte);
+	const b2Float4 linearSlop = b2Splat4(b2_linearSlop);
+	const b2Float4 maxLinearCorrection = b2Splat4(-b2_maxLinearCorrection);
+	b2Float4 minSeparation = zero;
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		const b2WidePositionConstraint& c = m_positionConstraints[i];
+
+		b2WidePositions p;
+		GatherPositions(m_positions, m_velocityConstraints[i], &p);
+
+		const b2Float4 mA = b2Load4(c.invMassA);
+		const b2Float4 iA = b2Load4(c.invIA);
+		const b2Float4 mB = b2Load4(c.invMassB);
+		const b2Float4 iB = b2Load4(c.invIB);
+		const b2Float4 localCenterAX = b2Load4(c.localCenterAX);
+		const b2Float4 localCenterAY = b2Load4(c.localCenterAY);
+		const b2Float4 localCenterBX = b2Load4(c.localCenterBX);
+		const b2Float4 localCenterBY = b2Load4(c.localCenterBY);
+		const b2Float4 localNormalX = b2Load4(c.localNormalX);
+		const b2Float4 localNormalY = b2Load4(c.localNormalY);
+		const b2Float4 localPointX = b2Load4(c.localPointX);
+		const b2Float4 localPointY = b2Load4(c.localPointY);
+		const b2Float4 radiusA = b2Load4(c.radiusA);
+		const b2Float4 radiusB = b2Load4(c.radiusB);
+		const b2Float4 circles = b2Greater(b2Load4(c.circles), zero);
+		const b2Float4 faceB = b2Greater(b2Load4(c.faceB), zero);
+
+		// Solve normal constraints
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2Float4 sA, cosA, sB, cosB;
+			SinCos4(p.aA, &sA, &cosA);
+			SinCos4(p.aB, &sB, &cosB);
+			const b2Float4 xfAX = p.cAX -
+				(cosA * localCenterAX - sA * localCenterAY);
+			const b2Float4 xfAY = p.cAY -
+				(sA * localCenterAX + cosA * localCenterAY);
+			const b2Float4 xfBX = p.cBX -
+				(cosB * localCenterBX - sB * localCenterBY);
+			const b2Float4 xfBY = p.cBY -
+				(sB * localCenterBX + cosB * localCenterBY);
+
+			// The manifold is defined in the frame of the reference body,
+			// which is B for e_faceB and A otherwise.
+			const b2Float4 sRef = b2Select(faceB, sB, sA);
+			const b2Float4 cosRef = b2Select(faceB, cosB, cosA);
+			const b2Float4 xfRefX = b2Select(faceB, xfBX, xfAX);
+			const b2Float4 xfRefY = b2Select(faceB, xfBY, xfAY);
+			const b2Float4 sInc = b2Select(faceB, sA, sB);
+			const b2Float4 cosInc = b2Select(faceB, cosA, cosB);
+			const b2Float4 xfIncX = b2Select(faceB, xfAX, xfBX);
+			const b2Float4 xfIncY = b2Select(faceB, xfAY, xfBY);
+
+			const b2Float4 localClipX = b2Load4(c.localPointsX[j]);
+			const b2Float4 localClipY = b2Load4(c.localPointsY[j]);
+			const b2Float4 planePointX =
+				(cosRef * localPointX - sRef * localPointY) + xfRefX;
+			const b2Float4 planePointY =
+				(sRef * localPointX + cosRef * localPointY) + xfRefY;
+			const b2Float4 clipPointX =
+				(cosInc * localClipX - sInc * localClipY) + xfIncX;
+			const b2Float4 clipPointY =
+				(sInc * localClipX + cosInc * localClipY) + xfIncY;
+			const b2Float4 dX = clipPointX - planePointX;
+			const b2Float4 dY = clipPointY - planePointY;
+
+			// Circles use the normalized direction between the two points.
+			const b2Float4 length = b2Sqrt(dX * dX + dY * dY);
+			const b2Float4 invLength = b2Splat4(1.0f) / length;
+			const b2Float4 tooShort = b2Less(length, epsilon);
+			b2Float4 normalX = b2Select(circles,
+				b2Select(tooShort, dX, dX * invLength),
+				cosRef * localNormalX - sRef * localNormalY);
+			b2Float4 normalY = b2Select(circles,
+				b2Select(tooShort, dY, dY * invLength),
+				sRef * localNormalX + cosRef * localNormalY);
+
+			const b2Float4 separation =
+				dX * normalX + dY * normalY - radiusA - radiusB;
+			const b2Float4 pointX = b2Select(circles,
+				half * (planePointX + clipPointX), clipPointX);
+			const b2Float4 pointY = b2Select(circles,
+				half * (planePointY + clipPointY), clipPointY);
+
+			// Ensure normal points from A to B
+			normalX = b2Select(faceB, -normalX, normalX);
+			normalY = b2Select(faceB, -normalY, normalY);
+
+			const b2Float4 rAX = pointX - p.cAX;
+			const b2Float4 rAY = pointY - p.cAY;
+			const b2Float4 rBX = pointX - p.cBX;
+			const b2Float4 rBY = pointY - p.cBY;
+
+			// Track max constraint error.
+			const b2Float4 active = b2Greater(b2Load4(c.pointActive[j]), zero);
+			minSeparation = b2Min(minSeparation,
+								  b2Select(active, separation, zero));
+
+			// Prevent large corrections and allow slop.
+			const b2Float4 C = b2Max(maxLinearCorrection,
+				b2Min(baumgarte * (separation + linearSlop), zero));
+
+			// Compute the effective mass.
+			const b2Float4 rnA = b2Cross4(rAX, rAY, normalX, normalY);
+			const b2Float4 rnB = b2Cross4(rBX, rBY, normalX, normalY);
+			const b2Float4 K = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
+
+			// Compute normal impulse
+			const b2Float4 impulse = b2Select(
+				b2And(active, b2Greater(K, zero)), -C / K, zero);
+
+			const b2Float4 PX = impulse * normalX;
+			const b2Float4 PY = impulse * normalY;
+
+			p.cAX = p.cAX - mA * PX;
+			p.cAY = p.cAY - mA * PY;
+			p.aA = p.aA - iA * b2Cross4(rAX, rAY, PX, PY);
+
+			p.cBX = p.cBX + mB * PX;
+			p.cBY = p.cBY + mB * PY;
+			p.aB = p.aB + iB * b2Cross4(rBX, rBY, PX, PY);
+		}
+
+		ScatterPositions(p, m_velocityConstraints[i], m_positions);
+	}
+
+	float32 separations[b2_wideSolverLanes];
+	b2Store4(separations, minSeparation);
+	float32 minLaneSeparation = 0.0f;
+	for (int32 lane = 0; lane < b2_wideSolverLanes; ++lane)
+	{
+		minLaneSeparation = b2Min(minLaneSeparation, separations[lane]);
+	}
+
+	// We can't expect minSpeparation >= -b2_linearSlop because we don't
+	// push the separation above -b2_linearSlop.
+	return minLaneSeparation >= -3.0f * b2_linearSlop;
+}
@@ -0,0 +1,132 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#ifndef B2_WIDE_CONTACT_SOLVER_H
+#define B2_WIDE_CONTACT_SOLVER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+class b2ContactSolver;
+class b2StackAllocator;
+struct b2Position;
+struct b2Velocity;
+
+/// Number of contact constraints solved together.
+#define b2_wideSolverLanes 4
+
+/// Velocity constraints of up to four contacts, one contact per lane. The
+/// second point of a lane with a single point is zero.
+struct b2WideVelocityConstraint
+{
+	float32 normalX[b2_wideSolverLanes];
+	float32 normalY[b2_wideSolverLanes];
+	float32 rAX[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 rAY[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 rBX[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 rBY[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 normalImpulse[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 tangentImpulse[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 normalMass[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 tangentMass[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 velocityBias[b2_maxManifoldPoints][b2_wideSolverLanes];
+	/// Block solver matrix and its inverse. Both are symmetric.
+	float32 k11[b2_wideSolverLanes];
+	float32 k12[b2_wideSolverLanes];
+	float32 k22[b2_wideSolverLanes];
+	float32 normalMass11[b2_wideSolverLanes];
+	float32 normalMass12[b2_wideSolverLanes];
+	float32 normalMass22[b2_wideSolverLanes];
+	float32 invMassA[b2_wideSolverLanes];
+	float32 invMassB[b2_wideSolverLanes];
+	float32 invIA[b2_wideSolverLanes];
+	float32 invIB[b2_wideSolverLanes];
+	float32 friction[b2_wideSolverLanes];
+	float32 tangentSpeed[b2_wideSolverLanes];
+	/// 1 for lanes solved with the block solver, 0 otherwise.
+	float32 blockSolve[b2_wideSolverLanes];
+	int32 indexA[b2_wideSolverLanes];
+	int32 indexB[b2_wideSolverLanes];
+	/// Index of the scalar constraint in each lane, -1 for an empty lane.
+	int32 constraints[b2_wideSolverLanes];
+};
+
+/// Position constraints matching the lanes of a b2WideVelocityConstraint.
+struct b2WidePositionConstraint
+{
+	float32 localPointsX[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 localPointsY[b2_maxManifoldPoints][b2_wideSolverLanes];
+	float32 localNormalX[b2_wideSolverLanes];
+	float32 localNormalY[b2_wideSolverLanes];
+	float32 localPointX[b2_wideSolverLanes];
+	float32 localPointY[b2_wideSolverLanes];
+	float32 localCenterAX[b2_wideSolverLanes];
+	float32 localCenterAY[b2_wideSolverLanes];
+	float32 localCenterBX[b2_wideSolverLanes];
+	float32 localCenterBY[b2_wideSolverLanes];
+	float32 invMassA[b2_wideSolverLanes];
+	float32 invMassB[b2_wideSolverLanes];
+	float32 invIA[b2_wideSolverLanes];
+	float32 invIB[b2_wideSolverLanes];
+	float32 radiusA[b2_wideSolverLanes];
+	float32 radiusB[b2_wideSolverLanes];
+	/// 1 for lanes with a b2Manifold::e_circles manifold, 0 otherwise.
+	float32 circles[b2_wideSolverLanes];
+	/// 1 for lanes with a b2Manifold::e_faceB manifold, 0 otherwise.
+	float32 faceB[b2_wideSolverLanes];
+	/// 1 for each point that exists in the lane's manifold, 0 otherwise.
+	float32 pointActive[b2_maxManifoldPoints][b2_wideSolverLanes];
+};
+
+/// Solves the contact constraints of a b2ContactSolver four at a time.
+/// The constraints are graph coloured so that no two constraints in a batch
+/// share a body that can move, which lets every lane of a batch read and
+/// write its bodies independently. Created by b2ContactSolver when
+/// b2TimeStep::wideContactSolver is set, after the velocity constraints
+/// have been initialized.
+class b2WideContactSolver
+{
+public:
+	b2WideContactSolver(b2ContactSolver* solver);
+	~b2WideContactSolver();
+
+	void WarmStart();
+	void SolveVelocityConstraints();
+
+	/// Copy the accumulated impulses back to the scalar velocity constraints.
+	void StoreImpulses();
+
+	bool SolvePositionConstraints();
+
+	/// Get the number of batches the constraints were packed into.
+	int32 GetBatchCount() const { return m_batchCount; }
+
+private:
+	int32 ColorConstraints(int32* colorCounts);
+	void InitializeBatches(const int32* colorCounts);
+
+	b2ContactSolver* m_solver;
+	b2StackAllocator* m_allocator;
+	b2Position* m_positions;
+	b2Velocity* m_velocities;
+	/// Color of each scalar constraint.
+	int32* m_colors;
+	b2WideVelocityConstraint* m_velocityConstraints;
+	b2WidePositionConstraint* m_positionConstraints;
+	int32 m_batchCount;
+};
+
+#endif
@@ -38,6 +38,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	{
 		m_flags |= e_bulletFlag;
 	}
+	if (bd->ccd)
+	{
+		m_flags |= e_ccdFlag;
+	}
 	if (bd->fixedRotation)
 	{
 		m_flags |= e_fixedRotationFlag;
@@ -79,6 +83,7 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_linearDamping = bd->linearDamping;
 	m_angularDamping = bd->angularDamping;
 	m_gravityScale = bd->gravityScale;
+	m_ccdPriority = bd->ccdPriority;
 
 	m_force.SetZero();
 	m_torque = 0.0f;
@@ -125,6 +130,12 @@ void b2Body::SetType(b2BodyType type)
 		return;
 	}
 
+	bool staticChanged = m_type == b2_staticBody || type == b2_staticBody;
+	if (staticChanged)
+	{
+		++m_world->m_staticGeometryVersion;
+	}
+
 	m_type = type;
 
 	ResetMassData();
@@ -153,8 +164,19 @@ void b2Body::SetType(b2BodyType type)
 	}
 	m_contactList = NULL;
 
-	// Touch the proxies so that new contacts will be created (when appropriate)
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	if (broadPhase->GetSeparateStaticTree() && staticChanged && IsActive())
+	{
+		// Move the proxies to the other tree. New proxies get new contacts.
+		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+		{
+			f->DestroyProxies(broadPhase);
+			f->CreateProxies(broadPhase, m_xf);
+		}
+		return;
+	}
+
+	// Touch the proxies so that new contacts will be created (when appropriate)
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
 		int32 proxyCount = f->m_proxyCount;
@@ -173,6 +195,8 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		return NULL;
 	}
 
+	++m_world->m_structureVersion;
+
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
 	void* memory = allocator->Allocate(sizeof(b2Fixture));
@@ -201,6 +225,11 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	// to be created at the beginning of the next time step.
 	m_world->m_flags |= b2World::e_newFixture;
 
+	if (m_type == b2_staticBody)
+	{
+		++m_world->m_staticGeometryVersion;
+	}
+
 	return fixture;
 }
 
@@ -221,6 +250,8 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 		return;
 	}
 
+	++m_world->m_structureVersion;
+
 	b2Assert(fixture->m_body == this);
 
 	// Remove the fixture from this body's singly linked list.
@@ -280,6 +311,11 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 
 	--m_fixtureCount;
 
+	if (m_type == b2_staticBody)
+	{
+		++m_world->m_staticGeometryVersion;
+	}
+
 	// Reset the mass data.
 	ResetMassData();
 }
@@ -443,6 +479,11 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 	{
 		f->Synchronize(broadPhase, m_xf, m_xf);
 	}
+
+	if (m_type == b2_staticBody)
+	{
+		++m_world->m_staticGeometryVersion;
+	}
 }
 
 void b2Body::SynchronizeFixtures()
@@ -467,6 +508,11 @@ void b2Body::SetActive(bool flag)
 		return;
 	}
 
+	if (m_type == b2_staticBody)
+	{
+		++m_world->m_staticGeometryVersion;
+	}
+
 	if (flag)
 	{
 		m_flags |= e_activeFlag;
@@ -542,6 +588,8 @@ void b2Body::Dump()
 	b2Log("  bd.awake = bool(%d);\n", m_flags & e_awakeFlag);
 	b2Log("  bd.fixedRotation = bool(%d);\n", m_flags & e_fixedRotationFlag);
 	b2Log("  bd.bullet = bool(%d);\n", m_flags & e_bulletFlag);
+	b2Log("  bd.ccd = bool(%d);\n", m_flags & e_ccdFlag);
+	b2Log("  bd.ccdPriority = %d;\n", m_ccdPriority);
 	b2Log("  bd.active = bool(%d);\n", m_flags & e_activeFlag);
 	b2Log("  bd.gravityScale = %.15lef;\n", m_gravityScale);
 	b2Log("  bodies[%d] = m_world->CreateBody(&bd);\n", m_islandIndex);
@@ -65,6 +65,8 @@ struct b2BodyDef
 		awake = true;
 		fixedRotation = false;
 		bullet = false;
+		ccd = true;
+		ccdPriority = 0;
 		type = b2_staticBody;
 		active = true;
 		gravityScale = 1.0f;
@@ -118,6 +120,14 @@ struct b2BodyDef
 	/// @warning You should use this flag sparingly since it increases processing time.
 	bool bullet;
 
+	/// Does this body take part in continuous collision detection? Contacts
+	/// with a body that doesn't are never sub-stepped.
+	bool ccd;
+
+	/// Bodies with a priority above zero keep getting time of impact events
+	/// after the world's TOI budget is spent. See b2World::SetTOIBudget().
+	int32 ccdPriority;
+
 	/// Does this body start out active?
 	bool active;
 
@@ -317,6 +327,19 @@ public:
 	/// Is this body treated like a bullet for continuous collision detection?
 	bool IsBullet() const;
 
+	/// Enable/disable continuous collision detection for this body.
+	void SetCCDEnabled(bool flag);
+
+	/// Does this body take part in continuous collision detection?
+	bool IsCCDEnabled() const;
+
+	/// Set the continuous collision priority of this body. Bodies with a
+	/// priority above zero ignore the world's TOI budget.
+	void SetCCDPriority(int32 priority);
+
+	/// Get the continuous collision priority of this body.
+	int32 GetCCDPriority() const;
+
 	/// You can disable sleeping on this body. If you disable sleeping, the
 	/// body will be woken.
 	void SetSleepingAllowed(bool flag);
@@ -433,7 +456,8 @@ private:
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		e_ccdFlag			= 0x0080
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -483,6 +507,8 @@ private:
 	float32 m_angularDamping;
 	float32 m_gravityScale;
 
+	int32 m_ccdPriority;
+
 	float32 m_sleepTime;
 
 	void* m_userData;
@@ -652,6 +678,33 @@ inline bool b2Body::IsBullet() const
 	return (m_flags & e_bulletFlag) == e_bulletFlag;
 }
 
+inline void b2Body::SetCCDEnabled(bool flag)
+{
+	if (flag)
+	{
+		m_flags |= e_ccdFlag;
+	}
+	else
+	{
+		m_flags &= ~e_ccdFlag;
+	}
+}
+
+inline bool b2Body::IsCCDEnabled() const
+{
+	return (m_flags & e_ccdFlag) == e_ccdFlag;
+}
+
+inline void b2Body::SetCCDPriority(int32 priority)
+{
+	m_ccdPriority = priority;
+}
+
+inline int32 b2Body::GetCCDPriority() const
+{
+	return m_ccdPriority;
+}
+
 inline void b2Body::SetAwake(bool flag)
 {
 	if (flag)
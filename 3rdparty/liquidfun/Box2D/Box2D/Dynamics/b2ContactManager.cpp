@@ -22,6 +22,7 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2StackAllocator.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
@@ -33,6 +34,8 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_stackAllocator = NULL;
+	m_taskDispatcher = NULL;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -103,12 +106,112 @@ void b2ContactManager::Destroy(b2Contact* c)
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
+// A manifold computed ahead of the serial pass in Collide().
+struct b2ContactManifoldResult
+{
+	b2Manifold manifold;
+	bool computed;
+	bool sensor;
+	bool overlap;
+	bool touching;
+};
+
+struct b2ComputeManifoldsContext
+{
+	b2ContactManager* manager;
+	b2Contact** contacts;
+	b2ContactManifoldResult* results;
+};
+
+void b2ContactManager::ComputeManifolds(b2Contact** contacts, void* results)
+{
+	b2ComputeManifoldsContext context;
+	context.manager = this;
+	context.contacts = contacts;
+	context.results = (b2ContactManifoldResult*)results;
+	m_taskDispatcher->ParallelFor(ComputeManifoldsTask, &context,
+								  m_contactCount);
+}
+
+// Compute the manifolds of the contacts Collide() would update if no
+// bodies were woken up on the way. Nothing but the results is written.
+void b2ContactManager::ComputeManifoldsTask(void* context, int32 begin,
+											int32 end, int32 threadIndex)
+{
+	B2_NOT_USED(threadIndex);
+	b2ComputeManifoldsContext* ctx = (b2ComputeManifoldsContext*)context;
+	const b2BroadPhase& broadPhase = ctx->manager->m_broadPhase;
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2Contact* c = ctx->contacts[i];
+		b2ContactManifoldResult& result = ctx->results[i];
+		result.computed = false;
+
+		// Filtering calls back to the user, so it is left to Collide().
+		if (c->m_flags & b2Contact::e_filterFlag)
+		{
+			continue;
+		}
+
+		b2Fixture* fixtureA = c->GetFixtureA();
+		b2Fixture* fixtureB = c->GetFixtureB();
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+		if (activeA == false && activeB == false)
+		{
+			continue;
+		}
+
+		int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+		result.computed = true;
+		result.sensor = fixtureA->IsSensor() || fixtureB->IsSensor();
+		result.overlap = broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		if (result.overlap)
+		{
+			result.touching = c->ComputeManifold(&result.manifold);
+		}
+	}
+}
+
 void b2ContactManager::Collide()
 {
+	// With a task dispatcher, the manifolds are computed in parallel first.
+	// The contacts are then updated in list order as usual, using the
+	// computed manifolds where possible, so the results and the callbacks
+	// are the same as without one.
+	b2Contact** contacts = NULL;
+	b2ContactManifoldResult* results = NULL;
+	if (m_taskDispatcher && m_contactCount > 0)
+	{
+		contacts = (b2Contact**)m_stackAllocator->Allocate(
+			m_contactCount * sizeof(b2Contact*));
+		results = (b2ContactManifoldResult*)m_stackAllocator->Allocate(
+			m_contactCount * sizeof(b2ContactManifoldResult));
+		int32 i = 0;
+		for (b2Contact* c = m_contactList; c; c = c->GetNext())
+		{
+			contacts[i++] = c;
+		}
+		ComputeManifolds(contacts, results);
+	}
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
+	int32 index = 0;
 	while (c)
 	{
+		// No contacts are added to or moved in the list here.
+		const b2ContactManifoldResult* precomputed = NULL;
+		if (results)
+		{
+			b2Assert(contacts[index] == c);
+			precomputed = &results[index];
+		}
+		++index;
+
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		int32 indexA = c->GetChildIndexA();
@@ -151,9 +254,26 @@ void b2ContactManager::Collide()
 			continue;
 		}
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		// A body woken up earlier in this pass, or a sensor flag changed by
+		// a callback, makes the computed result unusable.
+		bool sensor = fixtureA->IsSensor() || fixtureB->IsSensor();
+		if (precomputed &&
+			(precomputed->computed == false || precomputed->sensor != sensor))
+		{
+			precomputed = NULL;
+		}
+
+		bool overlap;
+		if (precomputed)
+		{
+			overlap = precomputed->overlap;
+		}
+		else
+		{
+			int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+			int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+			overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		}
 
 		// Here we destroy contacts that cease to overlap in the broad-phase.
 		if (overlap == false)
@@ -165,9 +285,23 @@ void b2ContactManager::Collide()
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
+		if (precomputed)
+		{
+			c->ApplyManifold(precomputed->manifold, precomputed->touching,
+							 m_contactListener);
+		}
+		else
+		{
+			c->Update(m_contactListener);
+		}
 		c = c->GetNext();
 	}
+
+	if (results)
+	{
+		m_stackAllocator->Free(results);
+		m_stackAllocator->Free(contacts);
+	}
 }
 
 void b2ContactManager::FindNewContacts()
@@ -175,6 +309,61 @@ void b2ContactManager::FindNewContacts()
 	m_broadPhase.UpdatePairs(this);
 }
 
+b2Contact* b2ContactManager::Create(b2Fixture* fixtureA, int32 indexA,
+								   b2Fixture* fixtureB, int32 indexB)
+{
+	// Call the factory.
+	b2Contact* c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
+	if (c == NULL)
+	{
+		return NULL;
+	}
+
+	// Contact creation may swap fixtures.
+	fixtureA = c->GetFixtureA();
+	fixtureB = c->GetFixtureB();
+	b2Body* bodyA = fixtureA->GetBody();
+	b2Body* bodyB = fixtureB->GetBody();
+
+	// Insert into the world.
+	c->m_prev = NULL;
+	c->m_next = m_contactList;
+	if (m_contactList != NULL)
+	{
+		m_contactList->m_prev = c;
+	}
+	m_contactList = c;
+
+	// Connect to island graph.
+
+	// Connect to body A
+	c->m_nodeA.contact = c;
+	c->m_nodeA.other = bodyB;
+
+	c->m_nodeA.prev = NULL;
+	c->m_nodeA.next = bodyA->m_contactList;
+	if (bodyA->m_contactList != NULL)
+	{
+		bodyA->m_contactList->prev = &c->m_nodeA;
+	}
+	bodyA->m_contactList = &c->m_nodeA;
+
+	// Connect to body B
+	c->m_nodeB.contact = c;
+	c->m_nodeB.other = bodyA;
+
+	c->m_nodeB.prev = NULL;
+	c->m_nodeB.next = bodyB->m_contactList;
+	if (bodyB->m_contactList != NULL)
+	{
+		bodyB->m_contactList->prev = &c->m_nodeB;
+	}
+	bodyB->m_contactList = &c->m_nodeB;
+
+	++m_contactCount;
+	return c;
+}
+
 void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 {
 	b2FixtureProxy* proxyA = (b2FixtureProxy*)proxyUserDataA;
@@ -236,8 +425,7 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
-	// Call the factory.
-	b2Contact* c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
+	b2Contact* c = Create(fixtureA, indexA, fixtureB, indexB);
 	if (c == NULL)
 	{
 		return;
@@ -249,47 +437,10 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	bodyA = fixtureA->GetBody();
 	bodyB = fixtureB->GetBody();
 
-	// Insert into the world.
-	c->m_prev = NULL;
-	c->m_next = m_contactList;
-	if (m_contactList != NULL)
-	{
-		m_contactList->m_prev = c;
-	}
-	m_contactList = c;
-
-	// Connect to island graph.
-
-	// Connect to body A
-	c->m_nodeA.contact = c;
-	c->m_nodeA.other = bodyB;
-
-	c->m_nodeA.prev = NULL;
-	c->m_nodeA.next = bodyA->m_contactList;
-	if (bodyA->m_contactList != NULL)
-	{
-		bodyA->m_contactList->prev = &c->m_nodeA;
-	}
-	bodyA->m_contactList = &c->m_nodeA;
-
-	// Connect to body B
-	c->m_nodeB.contact = c;
-	c->m_nodeB.other = bodyA;
-
-	c->m_nodeB.prev = NULL;
-	c->m_nodeB.next = bodyB->m_contactList;
-	if (bodyB->m_contactList != NULL)
-	{
-		bodyB->m_contactList->prev = &c->m_nodeB;
-	}
-	bodyB->m_contactList = &c->m_nodeB;
-
 	// Wake up the bodies
 	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
 	{
 		bodyA->SetAwake(true);
 		bodyB->SetAwake(true);
 	}
-
-	++m_contactCount;
 }
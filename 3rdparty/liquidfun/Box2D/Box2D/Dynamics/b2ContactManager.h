@@ -25,7 +25,10 @@ class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2StackAllocator;
 class b2ParticleSystem;
+class b2TaskDispatcher;
+class b2Fixture;
 
 // Delegate of b2World.
 class b2ContactManager
@@ -40,6 +43,11 @@ public:
 
 	void FindNewContacts();
 
+	// Create a contact and link it to the world and the bodies, without
+	// waking the bodies.
+	b2Contact* Create(b2Fixture* fixtureA, int32 indexA,
+					  b2Fixture* fixtureB, int32 indexB);
+
 	void Destroy(b2Contact* c);
 
 	void Collide();
@@ -50,6 +58,15 @@ public:
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+	b2StackAllocator* m_stackAllocator;
+	// If set, Collide() computes the manifolds with it before updating the
+	// contacts.
+	b2TaskDispatcher* m_taskDispatcher;
+
+private:
+	void ComputeManifolds(b2Contact** contacts, void* results);
+	static void ComputeManifoldsTask(void* context, int32 begin, int32 end,
+									 int32 threadIndex);
 };
 
 #endif
@@ -130,7 +130,8 @@ void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 	{
 		b2FixtureProxy* proxy = m_proxies + i;
 		m_shape->ComputeAABB(&proxy->aabb, xf, i);
-		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
+		proxy->proxyId = broadPhase->CreateProxy(
+			proxy->aabb, proxy, m_body->GetType() == b2_staticBody);
 		proxy->fixture = this;
 		proxy->childIndex = i;
 	}
@@ -223,6 +224,10 @@ void b2Fixture::SetSensor(bool sensor)
 	{
 		m_body->SetAwake(true);
 		m_isSensor = sensor;
+		if (m_body->GetType() == b2_staticBody)
+		{
+			++m_body->GetWorld()->m_staticGeometryVersion;
+		}
 	}
 }
 
@@ -27,6 +27,7 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+struct b2ContactImpulse;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
@@ -35,7 +36,8 @@ class b2Island
 {
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
-			b2StackAllocator* allocator, b2ContactListener* listener);
+			b2StackAllocator* allocator, b2ContactListener* listener,
+			int32 sharedCount = 0);
 	~b2Island();
 
 	void Clear()
@@ -52,7 +54,7 @@ public:
 	void Add(b2Body* body)
 	{
 		b2Assert(m_bodyCount < m_bodyCapacity);
-		body->m_islandIndex = m_bodyCount;
+		body->m_islandIndex = m_sharedCount + m_bodyCount;
 		m_bodies[m_bodyCount] = body;
 		++m_bodyCount;
 	}
@@ -81,6 +83,15 @@ public:
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
 
+	// Number of entries at the front of m_positions and m_velocities that
+	// belong to static bodies shared with islands solved at the same time.
+	// The caller fills them in; the island never writes the bodies back.
+	int32 m_sharedCount;
+
+	// If set, Report() stores the contact impulses here instead of calling
+	// m_listener, so the caller can report them later.
+	b2ContactImpulse* m_impulses;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 	int32 m_contactCount;
@@ -22,6 +22,47 @@
 
 #include <Box2D/Common/b2Math.h>
 
+/// Stages of the particle solver, see b2ParticleSystem::SetStageProfiling().
+enum b2ParticleStage
+{
+	b2_particleStageLifetimes,
+	b2_particleStageZombie,
+	b2_particleStageUpdateContacts,
+	b2_particleStageUpdateBodyContacts,
+	b2_particleStageComputeWeight,
+	b2_particleStageComputeDepth,
+	b2_particleStageReactive,
+	b2_particleStageForce,
+	b2_particleStageViscous,
+	b2_particleStageRepulsive,
+	b2_particleStagePowder,
+	b2_particleStageTensile,
+	b2_particleStageSolid,
+	b2_particleStageColorMixing,
+	b2_particleStageGravity,
+	b2_particleStageStaticPressure,
+	b2_particleStagePressure,
+	b2_particleStageDamping,
+	b2_particleStageElastic,
+	b2_particleStageSpring,
+	b2_particleStageLimitVelocity,
+	b2_particleStageRigid,
+	b2_particleStageBarrier,
+	b2_particleStageCollision,
+	b2_particleStageWall,
+	b2_particleStageIntegrate,
+	b2_particleStageCount
+};
+
+/// Particle solver profiling data. Times are in milliseconds and summed over
+/// the particle iterations of a step.
+struct b2ParticleProfile
+{
+	float32 solve;
+	/// Only measured when stage profiling is enabled.
+	float32 stages[b2_particleStageCount];
+};
+
 /// Profiling data. Times are in milliseconds.
 struct b2Profile
 {
@@ -33,6 +74,16 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+	/// Passes over the contacts looking for the first time of impact.
+	int32 toiIterations;
+	/// Times of impact computed.
+	int32 toiComputations;
+	/// Time of impact events handled.
+	int32 toiEvents;
+	/// Contacts left out once the TOI budget was spent.
+	int32 toiSkipped;
+	/// Summed over all particle systems. Part of solve.
+	b2ParticleProfile particles;
 };
 
 /// This is an internal structure.
@@ -45,6 +96,7 @@ struct b2TimeStep
 	int32 positionIterations;
 	int32 particleIterations;
 	bool warmStarting;
+	bool wideContactSolver;
 };
 
 /// This is an internal structure.
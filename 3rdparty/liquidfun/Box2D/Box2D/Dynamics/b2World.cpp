@@ -32,10 +32,13 @@
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Common/b2Timer.h>
 #include <new>
+#include <string.h>
 
-b2World::b2World(const b2Vec2& gravity)
+b2World::b2World(const b2Vec2& gravity) :
+	m_particleFixtures(m_blockAllocator)
 {
 	Init(gravity);
 }
@@ -65,6 +68,9 @@ b2World::~b2World()
 		DestroyParticleSystem(m_particleSystemList);
 	}
 
+	DestroyThreadAllocators();
+	m_particleFixtures.Free();
+
 	// Even though the block allocator frees them for us, for safety,
 	// we should ensure that all buffers have been freed.
 	b2Assert(m_blockAllocator.GetNumGiantAllocations() == 0);
@@ -90,6 +96,47 @@ void b2World::SetDebugDraw(b2Draw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetTaskDispatcher(b2TaskDispatcher* dispatcher)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	DestroyThreadAllocators();
+	m_taskDispatcher = dispatcher;
+	m_contactManager.m_taskDispatcher = dispatcher;
+	if (dispatcher == NULL)
+	{
+		return;
+	}
+
+	m_threadAllocatorCount = dispatcher->GetThreadCount();
+	m_threadAllocators = (b2StackAllocator**)b2Alloc(
+		m_threadAllocatorCount * sizeof(b2StackAllocator*));
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		void* mem = b2Alloc(sizeof(b2StackAllocator));
+		m_threadAllocators[i] = new (mem) b2StackAllocator;
+	}
+}
+
+void b2World::DestroyThreadAllocators()
+{
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i]->~b2StackAllocator();
+		b2Free(m_threadAllocators[i]);
+	}
+	if (m_threadAllocators)
+	{
+		b2Free(m_threadAllocators);
+	}
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -98,6 +145,8 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 		return NULL;
 	}
 
+	++m_structureVersion;
+
 	void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
 	b2Body* b = new (mem) b2Body(def, this);
 
@@ -114,6 +163,148 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	return b;
 }
 
+void b2World::CreateBatch(const b2BatchDef* def, b2Body** bodies,
+						  b2Fixture** fixtures, b2Joint** joints)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2Body** batchBodies = bodies;
+	if (batchBodies == NULL)
+	{
+		batchBodies = (b2Body**)m_stackAllocator.Allocate(
+			def->bodyCount * sizeof(b2Body*));
+	}
+	for (int32 i = 0; i < def->bodyCount; ++i)
+	{
+		batchBodies[i] = CreateBody(def->bodies + i);
+	}
+
+	// Create the fixtures without proxies.
+	++m_structureVersion;
+	int32 proxyCount = 0;
+	bool staticFixtures = false;
+	for (int32 i = 0; i < def->fixtureCount; ++i)
+	{
+		b2Body* body = batchBodies[def->fixtureBodies[i]];
+		void* memory = m_blockAllocator.Allocate(sizeof(b2Fixture));
+		b2Fixture* fixture = new (memory) b2Fixture;
+		fixture->Create(&m_blockAllocator, body, def->fixtures + i);
+
+		fixture->m_next = body->m_fixtureList;
+		body->m_fixtureList = fixture;
+		++body->m_fixtureCount;
+
+		if (body->m_flags & b2Body::e_activeFlag)
+		{
+			proxyCount += fixture->m_shape->GetChildCount();
+		}
+		staticFixtures = staticFixtures || body->m_type == b2_staticBody;
+		if (fixtures)
+		{
+			fixtures[i] = fixture;
+		}
+	}
+
+	// Create the proxies of the static fixtures and then the rest, both in
+	// one go.
+	b2AABB* aabbs = (b2AABB*)m_stackAllocator.Allocate(
+		proxyCount * sizeof(b2AABB));
+	void** userData = (void**)m_stackAllocator.Allocate(
+		proxyCount * sizeof(void*));
+	int32* proxyIds = (int32*)m_stackAllocator.Allocate(
+		proxyCount * sizeof(int32));
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	for (int32 pass = 0; pass < 2; ++pass)
+	{
+		const bool isStatic = pass == 0;
+		int32 count = 0;
+		for (int32 i = 0; i < def->bodyCount; ++i)
+		{
+			b2Body* b = batchBodies[i];
+			if ((b->m_type == b2_staticBody) != isStatic ||
+				(b->m_flags & b2Body::e_activeFlag) == 0)
+			{
+				continue;
+			}
+
+			for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+			{
+				f->m_proxyCount = f->m_shape->GetChildCount();
+				for (int32 j = 0; j < f->m_proxyCount; ++j)
+				{
+					b2FixtureProxy* proxy = f->m_proxies + j;
+					f->m_shape->ComputeAABB(&proxy->aabb, b->m_xf, j);
+					proxy->fixture = f;
+					proxy->childIndex = j;
+					aabbs[count] = proxy->aabb;
+					userData[count] = proxy;
+					++count;
+				}
+			}
+		}
+
+		broadPhase->CreateProxies(aabbs, userData, count, isStatic, proxyIds);
+		for (int32 i = 0; i < count; ++i)
+		{
+			((b2FixtureProxy*)userData[i])->proxyId = proxyIds[i];
+		}
+	}
+	m_stackAllocator.Free(proxyIds);
+	m_stackAllocator.Free(userData);
+	m_stackAllocator.Free(aabbs);
+
+	// Adjust mass properties once per body.
+	for (int32 i = 0; i < def->bodyCount; ++i)
+	{
+		b2Body* b = batchBodies[i];
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			if (f->m_density > 0.0f)
+			{
+				b->ResetMassData();
+				break;
+			}
+		}
+	}
+
+	// New contacts are found once at the beginning of the next time step.
+	if (def->fixtureCount > 0)
+	{
+		m_flags |= e_newFixture;
+	}
+	if (staticFixtures)
+	{
+		++m_staticGeometryVersion;
+	}
+
+	for (int32 i = 0; i < def->jointCount; ++i)
+	{
+		b2JointDef* jd = def->joints[i];
+		if (def->jointBodiesA && def->jointBodiesA[i] >= 0)
+		{
+			jd->bodyA = batchBodies[def->jointBodiesA[i]];
+		}
+		if (def->jointBodiesB && def->jointBodiesB[i] >= 0)
+		{
+			jd->bodyB = batchBodies[def->jointBodiesB[i]];
+		}
+		b2Joint* j = CreateJoint(jd);
+		if (joints)
+		{
+			joints[i] = j;
+		}
+	}
+
+	if (bodies == NULL)
+	{
+		m_stackAllocator.Free(batchBodies);
+	}
+}
+
 void b2World::DestroyBody(b2Body* b)
 {
 	b2Assert(m_bodyCount > 0);
@@ -123,6 +314,8 @@ void b2World::DestroyBody(b2Body* b)
 		return;
 	}
 
+	++m_structureVersion;
+
 	// Delete the attached joints.
 	b2JointEdge* je = b->m_jointList;
 	while (je)
@@ -151,6 +344,11 @@ void b2World::DestroyBody(b2Body* b)
 	}
 	b->m_contactList = NULL;
 
+	if (b->m_type == b2_staticBody && b->m_fixtureList)
+	{
+		++m_staticGeometryVersion;
+	}
+
 	// Delete the attached fixtures. This destroys broad-phase proxies.
 	b2Fixture* f = b->m_fixtureList;
 	while (f)
@@ -203,6 +401,8 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 		return NULL;
 	}
 
+	++m_structureVersion;
+
 	b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
 
 	// Connect to the world list.
@@ -263,6 +463,8 @@ void b2World::DestroyJoint(b2Joint* j)
 		return;
 	}
 
+	++m_structureVersion;
+
 	bool collideConnected = j->m_collideConnected;
 
 	// Remove from the doubly linked list.
@@ -358,6 +560,8 @@ b2ParticleSystem* b2World::CreateParticleSystem(const b2ParticleSystemDef* def)
 		return NULL;
 	}
 
+	++m_structureVersion;
+
 	void* mem = m_blockAllocator.Allocate(sizeof(b2ParticleSystem));
 	b2ParticleSystem* p = new (mem) b2ParticleSystem(def, this);
 
@@ -382,6 +586,8 @@ void b2World::DestroyParticleSystem(b2ParticleSystem* p)
 		return;
 	}
 
+	++m_structureVersion;
+
 	// Remove world particleSystem list.
 	if (p->m_prev)
 	{
@@ -420,12 +626,54 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
+void b2World::SetSeparateStaticTree(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || flag == GetSeparateStaticTree())
+	{
+		return;
+	}
+
+	// Recreate the static proxies in the tree they now belong to.
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if (b->GetType() == b2_staticBody)
+		{
+			for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+			{
+				f->DestroyProxies(broadPhase);
+			}
+		}
+	}
+	broadPhase->SetSeparateStaticTree(flag);
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if (b->GetType() == b2_staticBody && b->IsActive())
+		{
+			for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+			{
+				f->CreateProxies(broadPhase, b->m_xf);
+			}
+		}
+	}
+}
+
+bool b2World::GetSeparateStaticTree() const
+{
+	return m_contactManager.m_broadPhase.GetSeparateStaticTree();
+}
+
 // Initialize the world with a specified gravity.
 void b2World::Init(const b2Vec2& gravity)
 {
 	m_destructionListener = NULL;
 	m_debugDraw = NULL;
 
+	m_taskDispatcher = NULL;
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
 	m_bodyList = NULL;
 	m_jointList = NULL;
 	m_particleSystemList = NULL;
@@ -436,9 +684,16 @@ void b2World::Init(const b2Vec2& gravity)
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_wideContactSolver = false;
+	m_toiBudget = 0;
+	m_sharedParticleBroadphase = false;
+	m_hasParticleFixtures = false;
 
 	m_stepComplete = true;
 
+	m_staticGeometryVersion = 0;
+	m_structureVersion = 0;
+
 	m_allowSleep = true;
 	m_gravity = gravity;
 
@@ -447,6 +702,7 @@ void b2World::Init(const b2Vec2& gravity)
 	m_inv_dt0 = 0.0f;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+	m_contactManager.m_stackAllocator = &m_stackAllocator;
 
 	m_liquidFunVersion = &b2_liquidFunVersion;
 	m_liquidFunVersionString = b2_liquidFunVersionString;
@@ -455,6 +711,329 @@ void b2World::Init(const b2Vec2& gravity)
 }
 
 // Find islands, integrate and solve constraints, solve position constraints
+// Collect the island containing seed with a depth first search (DFS) on the
+// constraint graph. Bodies, contacts and joints added to the island are
+// flagged so they aren't added to another island.
+void b2World::BuildIsland(b2Body* seed, b2Body** stack, int32 stackSize,
+						  b2Island* island)
+{
+	// Reset island and stack.
+	island->Clear();
+	int32 stackCount = 0;
+	stack[stackCount++] = seed;
+	seed->m_flags |= b2Body::e_islandFlag;
+
+	// Perform a depth first search (DFS) on the constraint graph.
+	while (stackCount > 0)
+	{
+		// Grab the next body off the stack and add it to the island.
+		b2Body* b = stack[--stackCount];
+		b2Assert(b->IsActive() == true);
+		island->Add(b);
+
+		// Make sure the body is awake.
+		b->SetAwake(true);
+
+		// To keep islands as small as possible, we don't
+		// propagate islands across static bodies.
+		if (b->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		// Search all contacts connected to this body.
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			b2Contact* contact = ce->contact;
+
+			// Has this contact already been added to an island?
+			if (contact->m_flags & b2Contact::e_islandFlag)
+			{
+				continue;
+			}
+
+			// Is this contact solid and touching?
+			if (contact->IsEnabled() == false ||
+				contact->IsTouching() == false)
+			{
+				continue;
+			}
+
+			// Skip sensors.
+			bool sensorA = contact->m_fixtureA->m_isSensor;
+			bool sensorB = contact->m_fixtureB->m_isSensor;
+			if (sensorA || sensorB)
+			{
+				continue;
+			}
+
+			island->Add(contact);
+			contact->m_flags |= b2Contact::e_islandFlag;
+
+			b2Body* other = ce->other;
+
+			// Was the other body already added to this island?
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
+		}
+
+		// Search all joints connect to this body.
+		for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+		{
+			if (je->joint->m_islandFlag == true)
+			{
+				continue;
+			}
+
+			b2Body* other = je->other;
+
+			// Don't simulate joints connected to inactive bodies.
+			if (other->IsActive() == false)
+			{
+				continue;
+			}
+
+			island->Add(je->joint);
+			je->joint->m_islandFlag = true;
+
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
+		}
+	}
+}
+
+// An island collected by SolveIslandsInParallel(). The ranges index the
+// shared body, static body, contact and joint arrays.
+struct b2IslandRange
+{
+	int32 bodyStart, bodyCount;
+	int32 staticStart, staticCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+	b2Profile profile;
+};
+
+struct b2SolveIslandsContext
+{
+	b2World* world;
+	const b2TimeStep* step;
+	b2IslandRange* islands;
+	b2Body** bodies;
+	b2Body** staticBodies;
+	int32 staticCount;
+	b2Contact** contacts;
+	b2Joint** joints;
+	b2ContactImpulse* impulses;
+};
+
+// Build all awake islands on this thread, solve them with the task
+// dispatcher and then apply the results that touch more than one island in
+// the order Solve() would have. Static bodies are the only bodies shared
+// between islands. They get a slot of their own at the front of every
+// island's position and velocity arrays and are updated here afterwards.
+void b2World::SolveIslandsInParallel(const b2TimeStep& step, b2Island* island,
+									 b2Body** stack, int32 stackSize)
+{
+	const int32 contactCount = m_contactManager.m_contactCount;
+	b2IslandRange* islands = (b2IslandRange*)m_stackAllocator.Allocate(
+		m_bodyCount * sizeof(b2IslandRange));
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(
+		m_bodyCount * sizeof(b2Body*));
+	b2Body** staticBodies = (b2Body**)m_stackAllocator.Allocate(
+		(contactCount + m_jointCount) * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(
+		contactCount * sizeof(b2Contact*));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(
+		m_jointCount * sizeof(b2Joint*));
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	b2ContactImpulse* impulses = NULL;
+	if (listener)
+	{
+		impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(
+			contactCount * sizeof(b2ContactImpulse));
+	}
+
+	int32 islandCount = 0;
+	int32 bodyCount = 0, staticCount = 0, islandContactCount = 0;
+	int32 jointCount = 0;
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		if (seed->IsAwake() == false || seed->IsActive() == false)
+		{
+			continue;
+		}
+
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		BuildIsland(seed, stack, stackSize, island);
+
+		b2IslandRange& range = islands[islandCount++];
+		range.bodyStart = bodyCount;
+		range.staticStart = staticCount;
+		for (int32 i = 0; i < island->m_bodyCount; ++i)
+		{
+			b2Body* b = island->m_bodies[i];
+			if (b->GetType() == b2_staticBody)
+			{
+				// Allow static bodies to participate in other islands.
+				b->m_flags &= ~b2Body::e_islandFlag;
+				staticBodies[staticCount++] = b;
+			}
+			else
+			{
+				bodies[bodyCount++] = b;
+			}
+		}
+		range.bodyCount = bodyCount - range.bodyStart;
+		range.staticCount = staticCount - range.staticStart;
+
+		range.contactStart = islandContactCount;
+		range.contactCount = island->m_contactCount;
+		memcpy(contacts + islandContactCount, island->m_contacts,
+			   island->m_contactCount * sizeof(b2Contact*));
+		islandContactCount += island->m_contactCount;
+
+		range.jointStart = jointCount;
+		range.jointCount = island->m_jointCount;
+		memcpy(joints + jointCount, island->m_joints,
+			   island->m_jointCount * sizeof(b2Joint*));
+		jointCount += island->m_jointCount;
+	}
+
+	// Give every static body one slot shared by all islands. The island flag
+	// marks the bodies that already have one.
+	int32 sharedCount = 0;
+	for (int32 i = 0; i < staticCount; ++i)
+	{
+		b2Body* b = staticBodies[i];
+		if ((b->m_flags & b2Body::e_islandFlag) == 0)
+		{
+			b->m_flags |= b2Body::e_islandFlag;
+			b->m_islandIndex = sharedCount++;
+		}
+	}
+	for (int32 i = 0; i < staticCount; ++i)
+	{
+		staticBodies[i]->m_flags &= ~b2Body::e_islandFlag;
+	}
+
+	b2SolveIslandsContext context;
+	context.world = this;
+	context.step = &step;
+	context.islands = islands;
+	context.bodies = bodies;
+	context.staticBodies = staticBodies;
+	context.staticCount = sharedCount;
+	context.contacts = contacts;
+	context.joints = joints;
+	context.impulses = impulses;
+	m_taskDispatcher->ParallelFor(SolveIslandsTask, &context, islandCount);
+
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		const b2IslandRange& range = islands[i];
+		m_profile.solveInit += range.profile.solveInit;
+		m_profile.solveVelocity += range.profile.solveVelocity;
+		m_profile.solvePosition += range.profile.solvePosition;
+
+		if (listener)
+		{
+			for (int32 j = 0; j < range.contactCount; ++j)
+			{
+				int32 k = range.contactStart + j;
+				listener->PostSolve(contacts[k], &impulses[k]);
+			}
+		}
+
+		// A static body ends up awake or asleep with the last island it
+		// was part of.
+		bool awake = bodies[range.bodyStart]->IsAwake();
+		for (int32 j = 0; j < range.staticCount; ++j)
+		{
+			b2Body* b = staticBodies[range.staticStart + j];
+			b->m_sweep.c0 = b->m_sweep.c;
+			b->m_sweep.a0 = b->m_sweep.a;
+			b->SynchronizeTransform();
+			b->SetAwake(awake);
+		}
+	}
+
+	if (impulses)
+	{
+		m_stackAllocator.Free(impulses);
+	}
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(staticBodies);
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(islands);
+}
+
+void b2World::SolveIslandsTask(void* context, int32 begin, int32 end,
+							   int32 threadIndex)
+{
+	b2SolveIslandsContext* c = (b2SolveIslandsContext*)context;
+	b2World* world = c->world;
+	b2Assert(threadIndex < world->m_threadAllocatorCount);
+	b2StackAllocator* allocator = world->m_threadAllocators[threadIndex];
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2IslandRange& range = c->islands[i];
+		b2Island island(range.bodyCount, range.contactCount,
+						range.jointCount, allocator, NULL, c->staticCount);
+
+		for (int32 j = 0; j < range.staticCount; ++j)
+		{
+			const b2Body* b = c->staticBodies[range.staticStart + j];
+			island.m_positions[b->m_islandIndex].c = b->m_sweep.c;
+			island.m_positions[b->m_islandIndex].a = b->m_sweep.a;
+			island.m_velocities[b->m_islandIndex].v = b->m_linearVelocity;
+			island.m_velocities[b->m_islandIndex].w = b->m_angularVelocity;
+		}
+		for (int32 j = 0; j < range.bodyCount; ++j)
+		{
+			island.Add(c->bodies[range.bodyStart + j]);
+		}
+		for (int32 j = 0; j < range.contactCount; ++j)
+		{
+			island.Add(c->contacts[range.contactStart + j]);
+		}
+		for (int32 j = 0; j < range.jointCount; ++j)
+		{
+			island.Add(c->joints[range.jointStart + j]);
+		}
+		if (c->impulses)
+		{
+			island.m_impulses = c->impulses + range.contactStart;
+		}
+
+		island.Solve(&range.profile, *c->step, world->m_gravity,
+					 world->m_allowSleep);
+	}
+}
+
 void b2World::Solve(const b2TimeStep& step)
 {
 	// update previous transforms
@@ -491,134 +1070,47 @@ void b2World::Solve(const b2TimeStep& step)
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	if (m_taskDispatcher)
 	{
-		if (seed->m_flags & b2Body::e_islandFlag)
-		{
-			continue;
-		}
-
-		if (seed->IsAwake() == false || seed->IsActive() == false)
-		{
-			continue;
-		}
-
-		// The seed can be dynamic or kinematic.
-		if (seed->GetType() == b2_staticBody)
-		{
-			continue;
-		}
-
-		// Reset island and stack.
-		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
-
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+		SolveIslandsInParallel(step, &island, stack, stackSize);
+	}
+	else
+	{
+		for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
-			b2Assert(b->IsActive() == true);
-			island.Add(b);
-
-			// Make sure the body is awake.
-			b->SetAwake(true);
-
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->GetType() == b2_staticBody)
+			if (seed->m_flags & b2Body::e_islandFlag)
 			{
 				continue;
 			}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			if (seed->IsAwake() == false || seed->IsActive() == false)
 			{
-				b2Contact* contact = ce->contact;
-
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
-
-				// Is this contact solid and touching?
-				if (contact->IsEnabled() == false ||
-					contact->IsTouching() == false)
-				{
-					continue;
-				}
-
-				// Skip sensors.
-				bool sensorA = contact->m_fixtureA->m_isSensor;
-				bool sensorB = contact->m_fixtureB->m_isSensor;
-				if (sensorA || sensorB)
-				{
-					continue;
-				}
-
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
-
-				b2Body* other = ce->other;
-
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+				continue;
 			}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			// The seed can be dynamic or kinematic.
+			if (seed->GetType() == b2_staticBody)
 			{
-				if (je->joint->m_islandFlag == true)
-				{
-					continue;
-				}
-
-				b2Body* other = je->other;
+				continue;
+			}
 
-				// Don't simulate joints connected to inactive bodies.
-				if (other->IsActive() == false)
-				{
-					continue;
-				}
+			BuildIsland(seed, stack, stackSize, &island);
 
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
+			b2Profile profile;
+			island.Solve(&profile, step, m_gravity, m_allowSleep);
+			m_profile.solveInit += profile.solveInit;
+			m_profile.solveVelocity += profile.solveVelocity;
+			m_profile.solvePosition += profile.solvePosition;
 
-				if (other->m_flags & b2Body::e_islandFlag)
+			// Post solve cleanup.
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				// Allow static bodies to participate in other islands.
+				b2Body* b = island.m_bodies[i];
+				if (b->GetType() == b2_staticBody)
 				{
-					continue;
+					b->m_flags &= ~b2Body::e_islandFlag;
 				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
-		}
-
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
-
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
-		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->GetType() == b2_staticBody)
-			{
-				b->m_flags &= ~b2Body::e_islandFlag;
 			}
 		}
 	}
@@ -679,6 +1171,9 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		// Find the first TOI.
 		b2Contact* minContact = NULL;
 		float32 minAlpha = 1.0f;
+		const bool budgetSpent =
+			m_toiBudget > 0 && m_profile.toiEvents >= m_toiBudget;
+		++m_profile.toiIterations;
 
 		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
 		{
@@ -694,6 +1189,17 @@ void b2World::SolveTOI(const b2TimeStep& step)
 				continue;
 			}
 
+			// Once the budget is spent only prioritized bodies are
+			// sub-stepped. The others are left out for the rest of the step.
+			if (budgetSpent &&
+				c->GetFixtureA()->GetBody()->m_ccdPriority <= 0 &&
+				c->GetFixtureB()->GetBody()->m_ccdPriority <= 0)
+			{
+				c->m_toiCount = b2_maxSubSteps + 1;
+				++m_profile.toiSkipped;
+				continue;
+			}
+
 			float32 alpha = 1.0f;
 			if (c->m_flags & b2Contact::e_toiFlag)
 			{
@@ -736,6 +1242,12 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					continue;
 				}
 
+				// Is continuous collision disabled for either body?
+				if (bA->IsCCDEnabled() == false || bB->IsCCDEnabled() == false)
+				{
+					continue;
+				}
+
 				// Compute the TOI for this contact.
 				// Put the sweeps onto the same time interval.
 				float32 alpha0 = bA->m_sweep.alpha0;
@@ -766,6 +1278,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 				b2TOIOutput output;
 				b2TimeOfImpact(&output, &input);
+				++m_profile.toiComputations;
 
 				// Beta is the fraction of the remaining portion of the .
 				float32 beta = output.t;
@@ -805,6 +1318,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 		b2Sweep backup1 = bA->m_sweep;
 		b2Sweep backup2 = bB->m_sweep;
+		++m_profile.toiEvents;
 
 		bA->Advance(minAlpha);
 		bB->Advance(minAlpha);
@@ -939,6 +1453,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.particleIterations = step.particleIterations;
 		subStep.warmStarting = false;
+		subStep.wideContactSolver = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
@@ -1007,6 +1522,7 @@ void b2World::Step(
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.wideContactSolver = m_wideContactSolver;
 
 	// Update contacts. This is where some contacts are destroyed.
 	{
@@ -1016,18 +1532,20 @@ void b2World::Step(
 	}
 
 	// Integrate velocities, solve velocity constraints, and integrate positions.
+	memset(&m_profile.particles, 0, sizeof(m_profile.particles));
 	if (m_stepComplete && step.dt > 0.0f)
 	{
 		b2Timer timer;
-		for (b2ParticleSystem* p = m_particleSystemList; p; p = p->GetNext())
-		{
-			p->Solve(step); // Particle Simulation
-		}
+		SolveParticleSystems(step); // Particle Simulation
 		Solve(step);
 		m_profile.solve = timer.GetMilliseconds();
 	}
 
 	// Handle TOI events.
+	m_profile.toiIterations = 0;
+	m_profile.toiComputations = 0;
+	m_profile.toiEvents = 0;
+	m_profile.toiSkipped = 0;
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
 		b2Timer timer;
@@ -1071,6 +1589,134 @@ struct b2WorldQueryWrapper
 	b2QueryCallback* callback;
 };
 
+void b2World::SolveParticleSystems(const b2TimeStep& step)
+{
+	int32 systemCount = 0;
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->GetNext())
+	{
+		++systemCount;
+	}
+
+	if (m_sharedParticleBroadphase && systemCount > 1)
+	{
+		bool* active = (bool*)m_stackAllocator.Allocate(
+			sizeof(bool) * systemCount);
+		int32 activeCount = 0;
+		int32 index = 0;
+		for (b2ParticleSystem* p = m_particleSystemList; p; p = p->GetNext())
+		{
+			active[index] = p->PrepareSolve(step);
+			activeCount += active[index++] ? 1 : 0;
+		}
+
+		for (int32 iteration = 0;
+			 activeCount > 0 && iteration < step.particleIterations;
+			 iteration++)
+		{
+			// The particle AABBs are padded by a diameter, which is as far as
+			// a particle moves in one iteration after LimitVelocity, so the
+			// fixtures gathered here cover both the body contact and the
+			// collision queries. Queries they don't cover use the world.
+			b2AABB bounds;
+			bounds.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+			bounds.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+			index = 0;
+			for (b2ParticleSystem* p = m_particleSystemList; p;
+				 p = p->GetNext())
+			{
+				if (active[index++])
+				{
+					b2AABB aabb;
+					p->ComputeAABB(&aabb);
+					bounds.Combine(aabb);
+				}
+			}
+			GatherParticleFixtures(bounds);
+
+			index = 0;
+			for (b2ParticleSystem* p = m_particleSystemList; p;
+				 p = p->GetNext())
+			{
+				if (active[index++])
+				{
+					p->SolveIteration(step, iteration);
+				}
+			}
+		}
+		m_hasParticleFixtures = false;
+		m_stackAllocator.Free(active);
+
+		for (b2ParticleSystem* p = m_particleSystemList; p; p = p->GetNext())
+		{
+			p->FinishSolve();
+		}
+	}
+	else
+	{
+		for (b2ParticleSystem* p = m_particleSystemList; p; p = p->GetNext())
+		{
+			p->Solve(step);
+		}
+	}
+
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->GetNext())
+	{
+		const b2ParticleProfile& profile = p->GetProfile();
+		m_profile.particles.solve += profile.solve;
+		for (int32 i = 0; i < b2_particleStageCount; i++)
+		{
+			m_profile.particles.stages[i] += profile.stages[i];
+		}
+	}
+}
+
+struct b2World::ParticleFixtureGatherer
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		b2FixtureProxy* proxy =
+			(b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		ParticleFixture& fixture = fixtures->Append();
+		fixture.aabb = broadPhase->GetFatAABB(proxyId);
+		fixture.fixture = proxy->fixture;
+		return true;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2GrowableBuffer<ParticleFixture>* fixtures;
+};
+
+void b2World::GatherParticleFixtures(const b2AABB& aabb)
+{
+	m_particleFixtures.SetCount(0);
+	ParticleFixtureGatherer gatherer;
+	gatherer.broadPhase = &m_contactManager.m_broadPhase;
+	gatherer.fixtures = &m_particleFixtures;
+	m_contactManager.m_broadPhase.Query(&gatherer, aabb);
+	m_particleFixtureBounds = aabb;
+	m_hasParticleFixtures = true;
+}
+
+bool b2World::QueryParticleFixtures(b2QueryCallback* callback,
+									const b2AABB& aabb) const
+{
+	if (!m_hasParticleFixtures || !m_particleFixtureBounds.Contains(aabb))
+	{
+		return false;
+	}
+	// The same fixtures as a broad-phase query of aabb would report, but
+	// not necessarily in the same order.
+	const ParticleFixture* end = m_particleFixtures.End();
+	for (const ParticleFixture* f = m_particleFixtures.Begin(); f < end; ++f)
+	{
+		if (b2TestOverlap(f->aabb, aabb) && !callback->ReportFixture(f->fixture))
+		{
+			break;
+		}
+	}
+	return true;
+}
+
 void b2World::QueryAABB(b2QueryCallback* callback, const b2AABB& aabb) const
 {
 	b2WorldQueryWrapper wrapper;
@@ -1440,6 +2086,187 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
 }
 
+// Identifies snapshots written by SaveSnapshot(). Increment the version
+// whenever the layout changes.
+static const uint32 b2_snapshotMagic = 0x4e533262; // "b2SN"
+static const uint32 b2_snapshotVersion = 1;
+
+int32 b2World::SaveSnapshot(void* buffer, int32 capacity) const
+{
+	b2SnapshotWriter writer(buffer, capacity);
+	writer.Write(b2_snapshotMagic);
+	writer.Write(b2_snapshotVersion);
+	const int32 sizePosition = writer.GetSize();
+	writer.Write(int32(0));
+	writer.Write(this);
+	writer.Write(m_structureVersion);
+	writer.Write(m_staticGeometryVersion);
+	for (const b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		writer.Write(p->m_count);
+	}
+
+	writer.Write(m_flags);
+	writer.Write(m_gravity);
+	writer.Write(m_inv_dt0);
+	writer.Write(m_stepComplete);
+
+	// The same bodies, fixtures and joints exist when the snapshot is
+	// restored, so they are saved as they are.
+	for (const b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		writer.Write(b, sizeof(b2Body));
+		for (const b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			writer.Write(f, sizeof(b2Fixture));
+			writer.Write(f->m_proxies,
+						 f->m_shape->GetChildCount() * sizeof(b2FixtureProxy));
+		}
+	}
+	for (const b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		writer.Write(j, b2Joint::GetSize(j->m_type));
+	}
+
+	// Contacts from the end of the list, so that recreating them in order
+	// rebuilds the contact lists of the world and the bodies as they are.
+	writer.Write(m_contactManager.m_contactCount);
+	const b2Contact* last = m_contactManager.m_contactList;
+	while (last && last->m_next)
+	{
+		last = last->m_next;
+	}
+	for (const b2Contact* c = last; c; c = c->m_prev)
+	{
+		writer.Write(c->m_fixtureA);
+		writer.Write(c->m_indexA);
+		writer.Write(c->m_fixtureB);
+		writer.Write(c->m_indexB);
+		writer.Write(c->m_flags);
+		writer.Write(c->m_manifold);
+		writer.Write(c->m_toiCount);
+		writer.Write(c->m_toi);
+		writer.Write(c->m_friction);
+		writer.Write(c->m_restitution);
+		writer.Write(c->m_tangentSpeed);
+	}
+
+	m_contactManager.m_broadPhase.Save(&writer);
+
+	for (const b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		p->Save(&writer);
+	}
+
+	const int32 size = writer.GetSize();
+	writer.WriteAt(sizePosition, &size, sizeof(size));
+	return size;
+}
+
+bool b2World::RestoreSnapshot(const void* buffer, int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	// Check the header before changing anything.
+	const int32 headerSize = 2 * sizeof(uint32) + 3 * sizeof(int32) +
+							 sizeof(b2World*);
+	if (size < headerSize)
+	{
+		return false;
+	}
+	b2SnapshotReader reader(buffer, size);
+	if (reader.Read<uint32>() != b2_snapshotMagic ||
+		reader.Read<uint32>() != b2_snapshotVersion ||
+		reader.Read<int32>() != size ||
+		reader.Read<const b2World*>() != this ||
+		reader.Read<int32>() != m_structureVersion)
+	{
+		return false;
+	}
+	if (reader.Read<int32>() != m_staticGeometryVersion)
+	{
+		// Static bodies may move back, so baked distance fields are out of
+		// date.
+		++m_staticGeometryVersion;
+	}
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		if (!p->ReserveForRestore(reader.Read<int32>()))
+		{
+			return false;
+		}
+	}
+
+	// Remove the current contacts without reporting them. Bodies woken up
+	// by this are restored right after.
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	m_contactManager.m_contactListener = NULL;
+	while (m_contactManager.m_contactList)
+	{
+		m_contactManager.Destroy(m_contactManager.m_contactList);
+	}
+	m_contactManager.m_contactListener = listener;
+
+	m_flags = reader.Read<int32>();
+	m_gravity = reader.Read<b2Vec2>();
+	m_inv_dt0 = reader.Read<float32>();
+	m_stepComplete = reader.Read<bool>();
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		void* userData = b->m_userData;
+		reader.Read(b, sizeof(b2Body));
+		b->m_userData = userData;
+		b->m_contactList = NULL;
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			void* fixtureUserData = f->m_userData;
+			reader.Read(f, sizeof(b2Fixture));
+			f->m_userData = fixtureUserData;
+			reader.Read(f->m_proxies,
+						f->m_shape->GetChildCount() * sizeof(b2FixtureProxy));
+		}
+	}
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		void* userData = j->m_userData;
+		reader.Read(j, b2Joint::GetSize(j->m_type));
+		j->m_userData = userData;
+	}
+
+	const int32 contactCount = reader.Read<int32>();
+	for (int32 i = 0; i < contactCount; ++i)
+	{
+		b2Fixture* fixtureA = reader.Read<b2Fixture*>();
+		int32 indexA = reader.Read<int32>();
+		b2Fixture* fixtureB = reader.Read<b2Fixture*>();
+		int32 indexB = reader.Read<int32>();
+		b2Contact* c = m_contactManager.Create(fixtureA, indexA,
+											   fixtureB, indexB);
+		b2Assert(c && c->m_fixtureA == fixtureA);
+		c->m_flags = reader.Read<uint32>();
+		c->m_manifold = reader.Read<b2Manifold>();
+		c->m_toiCount = reader.Read<int32>();
+		c->m_toi = reader.Read<float32>();
+		c->m_friction = reader.Read<float32>();
+		c->m_restitution = reader.Read<float32>();
+		c->m_tangentSpeed = reader.Read<float32>();
+	}
+
+	m_contactManager.m_broadPhase.Restore(&reader);
+
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		p->Restore(&reader);
+	}
+	b2Assert(reader.GetRemaining() == 0);
+	return true;
+}
+
 void b2World::Dump()
 {
 	if ((m_flags & e_locked) == e_locked)
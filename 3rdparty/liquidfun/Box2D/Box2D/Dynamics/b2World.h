@@ -23,6 +23,7 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2GrowableBuffer.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
@@ -31,13 +32,52 @@
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2FixtureDef;
 struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
+class b2Island;
 class b2Joint;
 class b2ParticleGroup;
 
+/// Bodies, fixtures and joints to create at once with b2World::CreateBatch().
+/// Bodies are referred to by their index in bodies.
+struct b2BatchDef
+{
+	b2BatchDef()
+	{
+		bodies = NULL;
+		bodyCount = 0;
+		fixtures = NULL;
+		fixtureBodies = NULL;
+		fixtureCount = 0;
+		joints = NULL;
+		jointBodiesA = NULL;
+		jointBodiesB = NULL;
+		jointCount = 0;
+	}
+
+	/// The bodies to create.
+	const b2BodyDef* bodies;
+	int32 bodyCount;
+
+	/// The fixtures to create, and the index of the body of each fixture.
+	const b2FixtureDef* fixtures;
+	const int32* fixtureBodies;
+	int32 fixtureCount;
+
+	/// The joints to create, and the indices of their bodies. An index of
+	/// -1, or no indices at all, keeps the body set in the definition, for
+	/// joints to bodies created earlier. The bodies don't exist when the
+	/// definitions are made, so the local anchors have to be set directly
+	/// instead of with Initialize().
+	b2JointDef* const* joints;
+	const int32* jointBodiesA;
+	const int32* jointBodiesB;
+	int32 jointCount;
+};
+
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
 /// management facilities.
@@ -69,11 +109,33 @@ public:
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Register a task dispatcher to compute contact manifolds and solve
+	/// independent islands in parallel. Contacts are still updated and
+	/// islands built on the calling thread, and contact listener callbacks
+	/// are made from it in the same order as without a dispatcher, so the
+	/// results don't depend on the number of threads. Pass NULL to do
+	/// everything on the calling thread. The dispatcher is owned by you
+	/// and must remain in scope.
+	/// @warning This function is locked during callbacks.
+	void SetTaskDispatcher(b2TaskDispatcher* dispatcher);
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
 	b2Body* CreateBody(const b2BodyDef* def);
 
+	/// Create many bodies with their fixtures and joints at once. The proxies
+	/// of the fixtures are added to the broad-phase in bulk, which is much
+	/// faster than creating them one by one when building a level. Sets
+	/// bodyA and bodyB of the joint definitions. No other reference to the
+	/// definitions is retained.
+	/// @param bodies if not NULL, receives the bodies.
+	/// @param fixtures if not NULL, receives the fixtures.
+	/// @param joints if not NULL, receives the joints.
+	/// @warning This function is locked during callbacks.
+	void CreateBatch(const b2BatchDef* def, b2Body** bodies,
+					 b2Fixture** fixtures, b2Joint** joints);
+
 	/// Destroy a rigid body.
 	/// This function is locked during callbacks.
 	/// @warning This automatically deletes all associated shapes and joints.
@@ -207,10 +269,49 @@ public:
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
 
+	/// Limit the number of time of impact events handled per step, which
+	/// bounds the time continuous physics can take. Once the budget is spent
+	/// only contacts with a body of positive CCD priority are sub-stepped,
+	/// the rest finish the step without continuous collision.
+	/// @param maxEvents the budget, or zero for no limit (the default).
+	void SetTOIBudget(int32 maxEvents) { m_toiBudget = maxEvents; }
+	int32 GetTOIBudget() const { return m_toiBudget; }
+
 	/// Enable/disable single stepped continuous physics. For testing.
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable the wide contact solver. It solves four contacts at a
+	/// time with SIMD instructions (SSE2 where available). Contacts are
+	/// solved in a different order than with the default solver, so the
+	/// results are not bit-identical.
+	void SetWideContactSolver(bool flag) { m_wideContactSolver = flag; }
+	bool GetWideContactSolver() const { return m_wideContactSolver; }
+
+	/// Enable/disable a shared broad-phase query for the particle systems.
+	/// The fixtures near any particle system are gathered once per particle
+	/// iteration and each system picks its own candidates from them, instead
+	/// of every system querying the world twice per iteration. The systems
+	/// then take turns solving each iteration, so the impulses they apply to
+	/// bodies are ordered differently and the results are not bit-identical.
+	void SetSharedParticleBroadphase(bool flag)
+	{
+		m_sharedParticleBroadphase = flag;
+	}
+	bool GetSharedParticleBroadphase() const
+	{
+		return m_sharedParticleBroadphase;
+	}
+
+	/// Enable/disable a separate broad-phase tree for static fixtures. The
+	/// static tree is rebuilt in bulk only when static fixtures are added or
+	/// removed, and moving fixtures no longer have to share a tree with them.
+	/// Contacts may be created in a different order, so the results are not
+	/// bit-identical.
+	/// @warning This function is locked during callbacks.
+	void SetSeparateStaticTree(bool flag);
+	bool GetSeparateStaticTree() const;
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -259,6 +360,29 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Save the state of the simulation to a buffer: bodies, fixtures,
+	/// joints, contacts with their warm starting impulses, the broad-phase
+	/// and all particles and particle groups. The buffer can be kept in
+	/// memory or written to a file for RestoreSnapshot().
+	/// @param buffer receives the snapshot. May be NULL to get the size.
+	/// @param capacity the size of buffer in bytes.
+	/// @return the size of the snapshot. If it is larger than capacity,
+	/// the contents of buffer are undefined.
+	int32 SaveSnapshot(void* buffer, int32 capacity) const;
+
+	/// Put the simulation back into the state saved with SaveSnapshot(),
+	/// so that stepping gives exactly the same results as it did after
+	/// saving. Only snapshots of this world can be restored, and only while
+	/// it has the same bodies, fixtures, joints and particle systems as
+	/// when saving. Contacts, particles and particle groups may have
+	/// changed. Contacts and particle groups are recreated and particle
+	/// handles released, so pointers to them are no longer valid. The user
+	/// data of bodies, fixtures and joints is left as it is. No contact or
+	/// destruction callbacks are made.
+	/// @return false if the snapshot doesn't match this world.
+	/// @warning This function is locked during callbacks.
+	bool RestoreSnapshot(const void* buffer, int32 size);
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -303,6 +427,21 @@ private:
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
+	void SolveParticleSystems(const b2TimeStep& step);
+	void GatherParticleFixtures(const b2AABB& aabb);
+	/// Report the gathered fixtures overlapping aabb. Returns false if they
+	/// don't cover aabb, see SetSharedParticleBroadphase().
+	bool QueryParticleFixtures(b2QueryCallback* callback,
+							   const b2AABB& aabb) const;
+
+	void BuildIsland(b2Body* seed, b2Body** stack, int32 stackSize,
+					 b2Island* island);
+	void SolveIslandsInParallel(const b2TimeStep& step, b2Island* island,
+								b2Body** stack, int32 stackSize);
+	static void SolveIslandsTask(void* context, int32 begin, int32 end,
+								 int32 threadIndex);
+	void DestroyThreadAllocators();
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
@@ -328,6 +467,11 @@ private:
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
 
+	b2TaskDispatcher* m_taskDispatcher;
+	// One stack allocator for each thread of m_taskDispatcher.
+	b2StackAllocator** m_threadAllocators;
+	int32 m_threadAllocatorCount;
+
 	// This is used to compute the time step ratio to
 	// support a variable time step.
 	float32 m_inv_dt0;
@@ -336,9 +480,34 @@ private:
 	bool m_warmStarting;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_wideContactSolver;
+	int32 m_toiBudget;
+
+	// Fixture proxies overlapping m_particleFixtureBounds, gathered for the
+	// current particle iteration when the particle broad-phase is shared.
+	struct ParticleFixture
+	{
+		b2AABB aabb;
+		b2Fixture* fixture;
+	};
+	struct ParticleFixtureGatherer;
+	bool m_sharedParticleBroadphase;
+	bool m_hasParticleFixtures;
+	b2AABB m_particleFixtureBounds;
+	b2GrowableBuffer<ParticleFixture> m_particleFixtures;
 
 	bool m_stepComplete;
 
+	// Incremented whenever a fixture of a static body is created, destroyed
+	// or moved. Particle systems use it to invalidate their baked static
+	// distance fields.
+	int32 m_staticGeometryVersion;
+
+	// Incremented whenever a body, fixture, joint or particle system is
+	// created or destroyed. A snapshot can only be restored at the version
+	// it was saved at.
+	int32 m_structureVersion;
+
 	b2Profile m_profile;
 
 	/// Used to reference b2_LiquidFunVersion so that it's not stripped from
@@ -446,7 +615,8 @@ inline const b2Profile& b2World::GetProfile() const
 }
 
 #if LIQUIDFUN_EXTERNAL_LANGUAGE_API
-inline b2World::b2World(float32 gravityX, float32 gravityY)
+inline b2World::b2World(float32 gravityX, float32 gravityY) :
+	m_particleFixtures(m_blockAllocator)
 {
 	Init(b2Vec2(gravityX, gravityY));
 }
@@ -296,4 +296,27 @@ public:
 	}
 };
 
+/// Callback for b2TaskDispatcher::ParallelFor. Processes the items in
+/// [begin, end). threadIndex identifies the thread running the callback.
+typedef void (*b2TaskFunction)(void* context, int32 begin, int32 end,
+							   int32 threadIndex);
+
+/// Implement this class to let b2World spread independent work over several
+/// threads. See b2World::SetTaskDispatcher.
+class b2TaskDispatcher
+{
+public:
+	virtual ~b2TaskDispatcher() {}
+
+	/// Get the number of threads tasks can run on. The thread index passed
+	/// to a task is always less than this.
+	virtual int32 GetThreadCount() const = 0;
+
+	/// Call task on ranges that cover [0, count) exactly once and return
+	/// when all of them are done. Ranges may run at the same time and in
+	/// any order, but a thread runs one range at a time.
+	virtual void ParallelFor(b2TaskFunction task, void* context,
+							 int32 count) = 0;
+};
+
 #endif
@@ -122,6 +122,52 @@ void b2ParticleGroup::DestroyParticles(bool callDestructionListener)
 	}
 }
 
+b2ParticleGroupTemplate::b2ParticleGroupTemplate()
+{
+
+	m_positionBuffer = NULL;
+	m_count = 0;
+
+	m_flags = 0;
+	m_groupFlags = 0;
+	m_linearVelocity = b2Vec2_zero;
+	m_angularVelocity = 0;
+	m_color = b2ParticleColor_zero;
+	m_strength = 1;
+	m_lifetime = 0.0f;
+	m_userData = NULL;
+	m_group = NULL;
+
+}
+
+void b2ParticleGroupTemplate::Clear()
+{
+	if (m_positionBuffer)
+	{
+		b2Free(m_positionBuffer);
+		m_positionBuffer = NULL;
+	}
+	m_count = 0;
+}
+
+void b2ParticleGroupTemplate::GetParticleGroupDef(
+	const b2Vec2& position, float32 angle, b2ParticleGroupDef* def) const
+{
+	def->flags = m_flags;
+	def->groupFlags = m_groupFlags;
+	def->position = position;
+	def->angle = angle;
+	def->linearVelocity = m_linearVelocity;
+	def->angularVelocity = m_angularVelocity;
+	def->color = m_color;
+	def->strength = m_strength;
+	def->particleCount = m_count;
+	def->positionData = m_positionBuffer;
+	def->lifetime = m_lifetime;
+	def->userData = m_userData;
+	def->group = m_group;
+}
+
 #if LIQUIDFUN_EXTERNAL_LANGUAGE_API
 void b2ParticleGroupDef::FreeShapesMemory() {
 	if (circleShapes)
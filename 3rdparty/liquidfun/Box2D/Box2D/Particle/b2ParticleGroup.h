@@ -168,6 +168,54 @@ struct b2ParticleGroupDef
 #endif // LIQUIDFUN_EXTERNAL_LANGUAGE_API
 };
 
+/// A particle group layout that has been sampled once so it can be
+/// instantiated many times without re-running the shape fill.
+/// b2ParticleSystem::CreateParticleGroupTemplate creates these and
+/// b2ParticleSystem::CreateParticleGroup instantiates them.
+class b2ParticleGroupTemplate
+{
+
+public:
+
+	b2ParticleGroupTemplate();
+	~b2ParticleGroupTemplate();
+
+	/// Get the number of particles created by each instance.
+	int32 GetParticleCount() const;
+
+	/// Get the particle positions relative to the group origin.
+	const b2Vec2* GetPositionBuffer() const;
+
+	/// Release the sampled layout. The template can be re-created afterwards.
+	void Clear();
+
+private:
+
+	friend class b2ParticleSystem;
+
+	b2ParticleGroupTemplate(const b2ParticleGroupTemplate&);
+	b2ParticleGroupTemplate& operator=(const b2ParticleGroupTemplate&);
+
+	/// Fill a group definition which creates the same particles as this
+	/// template at the given position and angle.
+	void GetParticleGroupDef(const b2Vec2& position, float32 angle,
+							 b2ParticleGroupDef* def) const;
+
+	b2Vec2* m_positionBuffer;
+	int32 m_count;
+
+	uint32 m_flags;
+	uint32 m_groupFlags;
+	b2Vec2 m_linearVelocity;
+	float32 m_angularVelocity;
+	b2ParticleColor m_color;
+	float32 m_strength;
+	float32 m_lifetime;
+	void* m_userData;
+	b2ParticleGroup* m_group;
+
+};
+
 /// A group of particles. b2ParticleGroup::CreateParticleGroup creates these.
 class b2ParticleGroup
 {
@@ -397,6 +445,21 @@ inline void b2ParticleGroup::DestroyParticles()
 	DestroyParticles(false);
 }
 
+inline b2ParticleGroupTemplate::~b2ParticleGroupTemplate()
+{
+	Clear();
+}
+
+inline int32 b2ParticleGroupTemplate::GetParticleCount() const
+{
+	return m_count;
+}
+
+inline const b2Vec2* b2ParticleGroupTemplate::GetPositionBuffer() const
+{
+	return m_positionBuffer;
+}
+
 #if LIQUIDFUN_EXTERNAL_LANGUAGE_API
 inline void b2ParticleGroupDef::SetPosition(float32 x, float32 y)
 {
@@ -20,6 +20,7 @@
 #include <Box2D/Particle/b2VoronoiDiagram.h>
 #include <Box2D/Particle/b2ParticleAssembly.h>
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2Body.h>
@@ -395,6 +396,8 @@ b2ParticleSystem::b2ParticleSystem(const b2ParticleSystemDef* def,
 {
 	b2Assert(def);
 	m_paused = false;
+	m_stageProfiling = false;
+	memset(&m_profile, 0, sizeof(m_profile));
 	m_timestamp = 0;
 	m_allParticleFlags = 0;
 	m_needsUpdateAllParticleFlags = false;
@@ -402,6 +405,9 @@ b2ParticleSystem::b2ParticleSystem(const b2ParticleSystemDef* def,
 	m_needsUpdateAllGroupFlags = false;
 	m_hasForce = false;
 	m_iterationIndex = 0;
+	// SetMaxParticleCount() checks the count.
+	m_count = 0;
+	m_internalAllocatedCapacity = 0;
 
 	SetStrictContactCheck(def->strictContactCheck);
 	SetDensity(def->density);
@@ -409,8 +415,6 @@ b2ParticleSystem::b2ParticleSystem(const b2ParticleSystemDef* def,
 	SetRadius(def->radius);
 	SetMaxParticleCount(def->maxCount);
 
-	m_count = 0;
-	m_internalAllocatedCapacity = 0;
 	m_forceBuffer = NULL;
 	m_weightBuffer = NULL;
 	m_staticPressureBuffer = NULL;
@@ -429,6 +433,9 @@ b2ParticleSystem::b2ParticleSystem(const b2ParticleSystemDef* def,
 
 	m_stuckThreshold = 0;
 
+	m_staticDistanceField.distances = NULL;
+	m_staticDistanceField.fixtures = NULL;
+
 	m_timeElapsed = 0;
 	m_expirationTimeBufferRequiresSorting = false;
 
@@ -460,6 +467,7 @@ b2ParticleSystem::~b2ParticleSystem()
 	FreeBuffer(&m_accumulation2Buffer, m_internalAllocatedCapacity);
 	FreeBuffer(&m_depthBuffer, m_internalAllocatedCapacity);
 	FreeBuffer(&m_groupBuffer, m_internalAllocatedCapacity);
+	ClearStaticDistanceField();
 }
 
 template <typename T> void b2ParticleSystem::FreeBuffer(T** b, int capacity)
@@ -871,15 +879,10 @@ int32 b2ParticleSystem::CreateParticleForGroup(
 	return CreateParticle(particleDef);
 }
 
-void b2ParticleSystem::CreateParticlesStrokeShapeForGroup(
-	const b2Shape *shape,
-	const b2ParticleGroupDef& groupDef, const b2Transform& xf)
+void b2ParticleSystem::SampleParticlesStrokeShape(
+	const b2Shape *shape, float32 stride,
+	b2GrowableBuffer<b2Vec2>* positions)
 {
-	float32 stride = groupDef.stride;
-	if (stride == 0)
-	{
-		stride = GetParticleStride();
-	}
 	float32 positionOnEdge = 0;
 	int32 childCount = shape->GetChildCount();
 	for (int32 childIndex = 0; childIndex < childCount; childIndex++)
@@ -898,23 +901,18 @@ void b2ParticleSystem::CreateParticlesStrokeShapeForGroup(
 		float32 edgeLength = d.Length();
 		while (positionOnEdge < edgeLength)
 		{
-			b2Vec2 p = edge.m_vertex1 + positionOnEdge / edgeLength * d;
-			CreateParticleForGroup(groupDef, xf, p);
+			positions->Append() =
+				edge.m_vertex1 + positionOnEdge / edgeLength * d;
 			positionOnEdge += stride;
 		}
 		positionOnEdge -= edgeLength;
 	}
 }
 
-void b2ParticleSystem::CreateParticlesFillShapeForGroup(
-	const b2Shape *shape,
-	const b2ParticleGroupDef& groupDef, const b2Transform& xf)
+void b2ParticleSystem::SampleParticlesFillShape(
+	const b2Shape *shape, float32 stride,
+	b2GrowableBuffer<b2Vec2>* positions)
 {
-	float32 stride = groupDef.stride;
-	if (stride == 0)
-	{
-		stride = GetParticleStride();
-	}
 	b2Transform identity;
 	identity.SetIdentity();
 	b2AABB aabb;
@@ -929,24 +927,24 @@ void b2ParticleSystem::CreateParticlesFillShapeForGroup(
 			b2Vec2 p(x, y);
 			if (shape->TestPoint(identity, p))
 			{
-				CreateParticleForGroup(groupDef, xf, p);
+				positions->Append() = p;
 			}
 		}
 	}
 }
 
-void b2ParticleSystem::CreateParticlesWithShapeForGroup(
-	const b2Shape* shape,
-	const b2ParticleGroupDef& groupDef, const b2Transform& xf)
+void b2ParticleSystem::SampleParticlesWithShape(
+	const b2Shape* shape, float32 stride,
+	b2GrowableBuffer<b2Vec2>* positions)
 {
 	switch (shape->GetType()) {
 	case b2Shape::e_edge:
 	case b2Shape::e_chain:
-		CreateParticlesStrokeShapeForGroup(shape, groupDef, xf);
+		SampleParticlesStrokeShape(shape, stride, positions);
 		break;
 	case b2Shape::e_polygon:
 	case b2Shape::e_circle:
-		CreateParticlesFillShapeForGroup(shape, groupDef, xf);
+		SampleParticlesFillShape(shape, stride, positions);
 		break;
 	default:
 		b2Assert(false);
@@ -954,9 +952,9 @@ void b2ParticleSystem::CreateParticlesWithShapeForGroup(
 	}
 }
 
-void b2ParticleSystem::CreateParticlesWithShapesForGroup(
-	const b2Shape* const* shapes, int32 shapeCount,
-	const b2ParticleGroupDef& groupDef, const b2Transform& xf)
+void b2ParticleSystem::SampleParticlesWithShapes(
+	const b2Shape* const* shapes, int32 shapeCount, float32 stride,
+	b2GrowableBuffer<b2Vec2>* positions)
 {
 	class CompositeShape : public b2Shape
 	{
@@ -1037,7 +1035,27 @@ void b2ParticleSystem::CreateParticlesWithShapesForGroup(
 		const b2Shape* const* m_shapes;
 		int32 m_shapeCount;
 	} compositeShape(shapes, shapeCount);
-	CreateParticlesFillShapeForGroup(&compositeShape, groupDef, xf);
+	SampleParticlesFillShape(&compositeShape, stride, positions);
+}
+
+void b2ParticleSystem::SampleParticleGroupShapes(
+	const b2ParticleGroupDef& groupDef,
+	b2GrowableBuffer<b2Vec2>* positions)
+{
+	float32 stride = groupDef.stride;
+	if (stride == 0)
+	{
+		stride = GetParticleStride();
+	}
+	if (groupDef.shape)
+	{
+		SampleParticlesWithShape(groupDef.shape, stride, positions);
+	}
+	if (groupDef.shapes)
+	{
+		SampleParticlesWithShapes(
+			groupDef.shapes, groupDef.shapeCount, stride, positions);
+	}
 }
 
 b2ParticleGroup* b2ParticleSystem::CreateParticleGroup(
@@ -1052,14 +1070,14 @@ b2ParticleGroup* b2ParticleSystem::CreateParticleGroup(
 	b2Transform transform;
 	transform.Set(groupDef.position, groupDef.angle);
 	int32 firstIndex = m_count;
-	if (groupDef.shape)
-	{
-		CreateParticlesWithShapeForGroup(groupDef.shape, groupDef, transform);
-	}
-	if (groupDef.shapes)
+	if (groupDef.shape || groupDef.shapes)
 	{
-		CreateParticlesWithShapesForGroup(
-					groupDef.shapes, groupDef.shapeCount, groupDef, transform);
+		b2GrowableBuffer<b2Vec2> positions(m_world->m_blockAllocator);
+		SampleParticleGroupShapes(groupDef, &positions);
+		for (int32 i = 0; i < positions.GetCount(); i++)
+		{
+			CreateParticleForGroup(groupDef, transform, positions[i]);
+		}
 	}
 	if (groupDef.particleCount)
 	{
@@ -1071,7 +1089,14 @@ b2ParticleGroup* b2ParticleSystem::CreateParticleGroup(
 		}
 	}
 	int32 lastIndex = m_count;
+	return CreateParticleGroupForRange(groupDef, transform, firstIndex,
+									   lastIndex);
+}
 
+b2ParticleGroup* b2ParticleSystem::CreateParticleGroupForRange(
+	const b2ParticleGroupDef& groupDef, const b2Transform& transform,
+	int32 firstIndex, int32 lastIndex)
+{
 	void* mem = m_world->m_blockAllocator.Allocate(sizeof(b2ParticleGroup));
 	b2ParticleGroup* group = new (mem) b2ParticleGroup();
 	group->m_system = this;
@@ -1108,6 +1133,164 @@ b2ParticleGroup* b2ParticleSystem::CreateParticleGroup(
 	return group;
 }
 
+void b2ParticleSystem::CreateParticleGroupTemplate(
+	const b2ParticleGroupDef& groupDef, b2ParticleGroupTemplate* tmpl)
+{
+	b2GrowableBuffer<b2Vec2> positions(m_world->m_blockAllocator);
+	SampleParticleGroupShapes(groupDef, &positions);
+	if (groupDef.particleCount)
+	{
+		b2Assert(groupDef.positionData);
+		for (int32 i = 0; i < groupDef.particleCount; i++)
+		{
+			positions.Append() = groupDef.positionData[i];
+		}
+	}
+
+	tmpl->Clear();
+	tmpl->m_count = positions.GetCount();
+	if (tmpl->m_count)
+	{
+		tmpl->m_positionBuffer =
+			(b2Vec2*) b2Alloc(sizeof(b2Vec2) * tmpl->m_count);
+		memcpy(tmpl->m_positionBuffer, positions.Data(),
+			   sizeof(b2Vec2) * tmpl->m_count);
+	}
+	tmpl->m_flags = groupDef.flags;
+	tmpl->m_groupFlags = groupDef.groupFlags;
+	tmpl->m_linearVelocity = groupDef.linearVelocity;
+	tmpl->m_angularVelocity = groupDef.angularVelocity;
+	tmpl->m_color = groupDef.color;
+	tmpl->m_strength = groupDef.strength;
+	tmpl->m_lifetime = groupDef.lifetime;
+	tmpl->m_userData = groupDef.userData;
+	tmpl->m_group = groupDef.group;
+}
+
+b2ParticleGroup* b2ParticleSystem::CreateParticleGroup(
+	const b2ParticleGroupTemplate& tmpl, const b2Vec2& position,
+	float32 angle)
+{
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked())
+	{
+		return 0;
+	}
+
+	const int32 count = tmpl.m_count;
+	const int32 firstIndex = m_count;
+	const int32 lastIndex = m_count + count;
+	if (lastIndex > m_internalAllocatedCapacity)
+	{
+		// Grow at least as much as CreateParticle would have.
+		int32 capacity =
+			m_count ? 2 * m_count : b2_minParticleSystemBufferCapacity;
+		ReallocateInternalAllocatedBuffers(b2Max(capacity, lastIndex));
+	}
+	if (lastIndex > m_internalAllocatedCapacity)
+	{
+		// The buffers are full, so particles may have to be destroyed one
+		// at a time to make room. Let the regular path handle that.
+		b2ParticleGroupDef groupDef;
+		tmpl.GetParticleGroupDef(position, angle, &groupDef);
+		return CreateParticleGroup(groupDef);
+	}
+
+	b2Transform transform;
+	transform.Set(position, angle);
+
+	// Transform the layout straight into the position and velocity buffers.
+	const b2Vec2* layout = tmpl.m_positionBuffer;
+	b2Vec2* positions = m_positionBuffer.data + firstIndex;
+	b2Vec2* velocities = m_velocityBuffer.data + firstIndex;
+	for (int32 i = 0; i < count; i++)
+	{
+		const b2Vec2 p = b2Mul(transform, layout[i]);
+		positions[i] = p;
+		velocities[i] = tmpl.m_linearVelocity +
+			b2Cross(tmpl.m_angularVelocity, p - position);
+	}
+
+	memset(m_flagsBuffer.data + firstIndex, 0, sizeof(uint32) * count);
+	if (m_lastBodyContactStepBuffer.data)
+	{
+		memset(m_lastBodyContactStepBuffer.data + firstIndex, 0,
+			   sizeof(int32) * count);
+	}
+	if (m_bodyContactCountBuffer.data)
+	{
+		memset(m_bodyContactCountBuffer.data + firstIndex, 0,
+			   sizeof(int32) * count);
+	}
+	if (m_consecutiveContactStepsBuffer.data)
+	{
+		memset(m_consecutiveContactStepsBuffer.data + firstIndex, 0,
+			   sizeof(int32) * count);
+	}
+	memset(m_weightBuffer + firstIndex, 0, sizeof(float32) * count);
+	memset(m_forceBuffer + firstIndex, 0, sizeof(b2Vec2) * count);
+	if (m_staticPressureBuffer)
+	{
+		memset(m_staticPressureBuffer + firstIndex, 0,
+			   sizeof(float32) * count);
+	}
+	if (m_depthBuffer)
+	{
+		memset(m_depthBuffer + firstIndex, 0, sizeof(float32) * count);
+	}
+	if (m_colorBuffer.data || !tmpl.m_color.IsZero())
+	{
+		m_colorBuffer.data = RequestBuffer(m_colorBuffer.data);
+		std::fill(m_colorBuffer.data + firstIndex,
+				  m_colorBuffer.data + lastIndex, tmpl.m_color);
+	}
+	if (m_userDataBuffer.data || tmpl.m_userData)
+	{
+		m_userDataBuffer.data = RequestBuffer(m_userDataBuffer.data);
+		std::fill(m_userDataBuffer.data + firstIndex,
+				  m_userDataBuffer.data + lastIndex, tmpl.m_userData);
+	}
+	if (m_handleIndexBuffer.data)
+	{
+		memset(m_handleIndexBuffer.data + firstIndex, 0,
+			   sizeof(b2ParticleHandle*) * count);
+	}
+	memset(m_groupBuffer + firstIndex, 0, sizeof(b2ParticleGroup*) * count);
+
+	m_proxyBuffer.Reserve(m_proxyBuffer.GetCount() + count);
+	for (int32 i = firstIndex; i < lastIndex; i++)
+	{
+		m_proxyBuffer.Append().index = i;
+	}
+	m_count = lastIndex;
+
+	// All particles share the same flags, so the bookkeeping in
+	// SetParticleFlags only needs to run once.
+	if (count)
+	{
+		SetParticleFlags(firstIndex, tmpl.m_flags);
+		std::fill(m_flagsBuffer.data + firstIndex + 1,
+				  m_flagsBuffer.data + lastIndex, tmpl.m_flags);
+	}
+
+	const bool finiteLifetime = tmpl.m_lifetime > 0;
+	if (m_expirationTimeBuffer.data || finiteLifetime)
+	{
+		const float32 lifetime = finiteLifetime ? tmpl.m_lifetime :
+			ExpirationTimeToLifetime(-GetQuantizedTimeElapsed());
+		for (int32 i = firstIndex; i < lastIndex; i++)
+		{
+			SetParticleLifetime(i, lifetime);
+			m_indexByExpirationTimeBuffer.data[i] = i;
+		}
+	}
+
+	b2ParticleGroupDef groupDef;
+	tmpl.GetParticleGroupDef(position, angle, &groupDef);
+	return CreateParticleGroupForRange(groupDef, transform, firstIndex,
+									   lastIndex);
+}
+
 void b2ParticleSystem::JoinParticleGroups(b2ParticleGroup* groupA,
 										  b2ParticleGroup* groupB)
 {
@@ -1662,6 +1845,243 @@ void b2ParticleSystem::DestroyParticleGroup(b2ParticleGroup* group)
 	m_world->m_blockAllocator.Free(group, sizeof(b2ParticleGroup));
 }
 
+// Optional buffers are written with a flag telling whether they exist.
+template <typename T> void b2ParticleSystem::SaveBuffer(
+	b2SnapshotWriter* writer, const T* buffer) const
+{
+	writer->Write(buffer != NULL);
+	if (buffer)
+	{
+		writer->Write(buffer, sizeof(T) * m_count);
+	}
+}
+
+template <typename T> void b2ParticleSystem::RestoreBuffer(
+	b2SnapshotReader* reader, T** buffer)
+{
+	if (reader->Read<bool>())
+	{
+		*buffer = RequestBuffer(*buffer);
+		reader->Read(*buffer, sizeof(T) * m_count);
+	}
+	else
+	{
+		FreeBuffer(buffer, m_internalAllocatedCapacity);
+	}
+}
+
+template <typename T> void b2ParticleSystem::RestoreBuffer(
+	b2SnapshotReader* reader, UserOverridableBuffer<T>* buffer)
+{
+	if (buffer->userSuppliedCapacity == 0)
+	{
+		RestoreBuffer(reader, &buffer->data);
+	}
+	else if (reader->Read<bool>())
+	{
+		reader->Read(buffer->data, sizeof(T) * m_count);
+	}
+	else
+	{
+		// User supplied buffers can't be freed.
+		memset(buffer->data, 0, sizeof(T) * m_count);
+	}
+}
+
+template <typename T> void b2ParticleSystem::SaveBuffer(
+	b2SnapshotWriter* writer, const b2GrowableBuffer<T>& buffer)
+{
+	writer->Write(buffer.GetCount());
+	writer->Write(buffer.Data(), sizeof(T) * buffer.GetCount());
+}
+
+template <typename T> void b2ParticleSystem::RestoreBuffer(
+	b2SnapshotReader* reader, b2GrowableBuffer<T>* buffer)
+{
+	int32 count = reader->Read<int32>();
+	buffer->Reserve(count);
+	reader->Read(buffer->Data(), sizeof(T) * count);
+	buffer->Shorten(buffer->Data() + count);
+}
+
+void b2ParticleSystem::Save(b2SnapshotWriter* writer) const
+{
+	writer->Write(m_paused);
+	writer->Write(m_timestamp);
+	writer->Write(m_allParticleFlags);
+	writer->Write(m_needsUpdateAllParticleFlags);
+	writer->Write(m_allGroupFlags);
+	writer->Write(m_needsUpdateAllGroupFlags);
+	writer->Write(m_hasForce);
+	writer->Write(m_iterationIndex);
+	writer->Write(m_timeElapsed);
+	writer->Write(m_expirationTimeBufferRequiresSorting);
+
+	// Groups from the end of the list, so that restoring them in order
+	// rebuilds the list as it is. Particles that belong to a group are
+	// exactly the ones in its index range.
+	writer->Write(m_groupCount);
+	const b2ParticleGroup* last = m_groupList;
+	while (last && last->m_next)
+	{
+		last = last->m_next;
+	}
+	for (const b2ParticleGroup* group = last; group; group = group->m_prev)
+	{
+		writer->Write(group->m_firstIndex);
+		writer->Write(group->m_lastIndex);
+		writer->Write(group->m_groupFlags);
+		writer->Write(group->m_strength);
+		writer->Write(group->m_timestamp);
+		writer->Write(group->m_mass);
+		writer->Write(group->m_inertia);
+		writer->Write(group->m_center);
+		writer->Write(group->m_linearVelocity);
+		writer->Write(group->m_angularVelocity);
+		writer->Write(group->m_transform);
+		writer->Write(group->m_userData);
+	}
+
+	writer->Write(m_count);
+	writer->Write(m_flagsBuffer.data, sizeof(uint32) * m_count);
+	writer->Write(m_positionBuffer.data, sizeof(b2Vec2) * m_count);
+	writer->Write(m_velocityBuffer.data, sizeof(b2Vec2) * m_count);
+	writer->Write(m_forceBuffer, sizeof(b2Vec2) * m_count);
+	writer->Write(m_weightBuffer, sizeof(float32) * m_count);
+	SaveBuffer(writer, m_staticPressureBuffer);
+	SaveBuffer(writer, m_depthBuffer);
+	SaveBuffer(writer, m_colorBuffer.data);
+	SaveBuffer(writer, m_userDataBuffer.data);
+	SaveBuffer(writer, m_lastBodyContactStepBuffer.data);
+	SaveBuffer(writer, m_bodyContactCountBuffer.data);
+	SaveBuffer(writer, m_consecutiveContactStepsBuffer.data);
+	SaveBuffer(writer, m_expirationTimeBuffer.data);
+	SaveBuffer(writer, m_indexByExpirationTimeBuffer.data);
+
+	SaveBuffer(writer, m_stuckParticleBuffer);
+	SaveBuffer(writer, m_proxyBuffer);
+	SaveBuffer(writer, m_contactBuffer);
+	SaveBuffer(writer, m_bodyContactBuffer);
+	SaveBuffer(writer, m_pairBuffer);
+	SaveBuffer(writer, m_triadBuffer);
+}
+
+bool b2ParticleSystem::ReserveForRestore(int32 count)
+{
+	if (count > m_internalAllocatedCapacity)
+	{
+		ReallocateInternalAllocatedBuffers(count);
+	}
+	return count <= m_internalAllocatedCapacity;
+}
+
+void b2ParticleSystem::Restore(b2SnapshotReader* reader)
+{
+	m_paused = reader->Read<bool>();
+	m_timestamp = reader->Read<int32>();
+	m_allParticleFlags = reader->Read<int32>();
+	m_needsUpdateAllParticleFlags = reader->Read<bool>();
+	m_allGroupFlags = reader->Read<int32>();
+	m_needsUpdateAllGroupFlags = reader->Read<bool>();
+	m_hasForce = reader->Read<bool>();
+	m_iterationIndex = reader->Read<int32>();
+	m_timeElapsed = reader->Read<int64>();
+	m_expirationTimeBufferRequiresSorting = reader->Read<bool>();
+
+	// Release the handles of the current particles.
+	if (m_handleIndexBuffer.data)
+	{
+		for (int32 i = 0; i < m_count; i++)
+		{
+			b2ParticleHandle* const handle = m_handleIndexBuffer.data[i];
+			if (handle)
+			{
+				handle->SetIndex(b2_invalidParticleIndex);
+				m_handleIndexBuffer.data[i] = NULL;
+				m_handleAllocator.Free(handle);
+			}
+		}
+	}
+
+	// Replace the groups without calling the destruction listener.
+	while (m_groupList)
+	{
+		b2ParticleGroup* group = m_groupList;
+		m_groupList = group->m_next;
+		group->~b2ParticleGroup();
+		m_world->m_blockAllocator.Free(group, sizeof(b2ParticleGroup));
+	}
+	m_groupCount = 0;
+	int32 groupCount = reader->Read<int32>();
+	for (int32 i = 0; i < groupCount; i++)
+	{
+		void* mem = m_world->m_blockAllocator.Allocate(sizeof(b2ParticleGroup));
+		b2ParticleGroup* group = new (mem) b2ParticleGroup();
+		group->m_system = this;
+		group->m_firstIndex = reader->Read<int32>();
+		group->m_lastIndex = reader->Read<int32>();
+		group->m_groupFlags = reader->Read<uint32>();
+		group->m_strength = reader->Read<float32>();
+		group->m_timestamp = reader->Read<int32>();
+		group->m_mass = reader->Read<float32>();
+		group->m_inertia = reader->Read<float32>();
+		group->m_center = reader->Read<b2Vec2>();
+		group->m_linearVelocity = reader->Read<b2Vec2>();
+		group->m_angularVelocity = reader->Read<float32>();
+		group->m_transform = reader->Read<b2Transform>();
+		group->m_userData = reader->Read<void*>();
+		group->m_prev = NULL;
+		group->m_next = m_groupList;
+		if (m_groupList)
+		{
+			m_groupList->m_prev = group;
+		}
+		m_groupList = group;
+		++m_groupCount;
+	}
+
+	// ReserveForRestore() made room for the particles.
+	m_count = reader->Read<int32>();
+	b2Assert(m_count <= m_internalAllocatedCapacity);
+	reader->Read(m_flagsBuffer.data, sizeof(uint32) * m_count);
+	reader->Read(m_positionBuffer.data, sizeof(b2Vec2) * m_count);
+	reader->Read(m_velocityBuffer.data, sizeof(b2Vec2) * m_count);
+	reader->Read(m_forceBuffer, sizeof(b2Vec2) * m_count);
+	reader->Read(m_weightBuffer, sizeof(float32) * m_count);
+	RestoreBuffer(reader, &m_staticPressureBuffer);
+	RestoreBuffer(reader, &m_depthBuffer);
+	RestoreBuffer(reader, &m_colorBuffer);
+	RestoreBuffer(reader, &m_userDataBuffer);
+	RestoreBuffer(reader, &m_lastBodyContactStepBuffer);
+	RestoreBuffer(reader, &m_bodyContactCountBuffer);
+	RestoreBuffer(reader, &m_consecutiveContactStepsBuffer);
+	RestoreBuffer(reader, &m_expirationTimeBuffer);
+	RestoreBuffer(reader, &m_indexByExpirationTimeBuffer);
+	if (m_handleIndexBuffer.data)
+	{
+		memset(m_handleIndexBuffer.data, 0,
+			   sizeof(b2ParticleHandle*) * m_count);
+	}
+	if (m_count)
+	{
+		memset(m_groupBuffer, 0, sizeof(b2ParticleGroup*) * m_count);
+	}
+	for (b2ParticleGroup* group = m_groupList; group; group = group->m_next)
+	{
+		for (int32 i = group->m_firstIndex; i < group->m_lastIndex; i++)
+		{
+			m_groupBuffer[i] = group;
+		}
+	}
+
+	RestoreBuffer(reader, &m_stuckParticleBuffer);
+	RestoreBuffer(reader, &m_proxyBuffer);
+	RestoreBuffer(reader, &m_contactBuffer);
+	RestoreBuffer(reader, &m_bodyContactBuffer);
+	RestoreBuffer(reader, &m_pairBuffer);
+	RestoreBuffer(reader, &m_triadBuffer);
+}
+
 void b2ParticleSystem::ComputeWeight()
 {
 	// calculates the sum of contact-weights for each particle
@@ -2520,6 +2940,11 @@ private:
 		{
 			return true;
 		}
+		// Baked fixtures are handled by sampling the distance field.
+		if (m_system->IsFixtureInStaticDistanceField(fixture))
+		{
+			return true;
+		}
 		const b2Shape* shape = fixture->GetShape();
 		int32 childCount = shape->GetChildCount();
 		for (int32 childIndex = 0; childIndex < childCount; childIndex++)
@@ -2698,7 +3123,12 @@ void b2ParticleSystem::UpdateBodyContacts()
 
 	b2AABB aabb;
 	ComputeAABB(&aabb);
-	m_world->QueryAABB(&callback, aabb);
+	QueryFixtures(&callback, aabb);
+
+	if (m_staticDistanceField.distances)
+	{
+		UpdateBodyContactsWithStaticDistanceField();
+	}
 
 	if (m_def.strictContactCheck)
 	{
@@ -2708,6 +3138,15 @@ void b2ParticleSystem::UpdateBodyContacts()
 	NotifyBodyContactListenerPostContact(fixtureSet);
 }
 
+void b2ParticleSystem::QueryFixtures(b2QueryCallback* callback,
+									 const b2AABB& aabb) const
+{
+	if (!m_world->QueryParticleFixtures(callback, aabb))
+	{
+		m_world->QueryAABB(callback, aabb);
+	}
+}
+
 void b2ParticleSystem::RemoveSpuriousBodyContacts()
 {
 	// At this point we have a list of contact candidates based on AABB
@@ -2829,7 +3268,260 @@ void b2ParticleSystem::SolveCollision(const b2TimeStep& step)
 			m_step = step;
 		}
 	} callback(this, step);
-	m_world->QueryAABB(&callback, aabb);
+	QueryFixtures(&callback, aabb);
+
+	if (m_staticDistanceField.distances)
+	{
+		SolveCollisionWithStaticDistanceField(step);
+	}
+}
+
+void b2ParticleSystem::UpdateBodyContactsWithStaticDistanceField()
+{
+	UpdateStaticDistanceField();
+	b2ContactFilter* const contactFilter = GetFixtureContactFilter();
+	const float32 invAm = GetParticleInvMass();
+	for (int32 a = 0; a < m_count; a++)
+	{
+		float32 d;
+		b2Vec2 n;
+		b2Fixture* fixture;
+		if (!SampleStaticDistanceField(m_positionBuffer.data[a], &d, &n,
+									   &fixture) ||
+			d >= m_particleDiameter || !fixture)
+		{
+			continue;
+		}
+		const uint32 flags = m_flagsBuffer.data[a];
+		if (contactFilter && (flags & b2_fixtureContactFilterParticle) &&
+			!contactFilter->ShouldCollide(fixture, this, a))
+		{
+			continue;
+		}
+		// Static bodies have no mass, so only the particle's mass counts.
+		float32 invM = flags & b2_wallParticle ? 0 : invAm;
+		b2ParticleBodyContact& contact = m_bodyContactBuffer.Append();
+		contact.index = a;
+		contact.body = fixture->GetBody();
+		contact.fixture = fixture;
+		contact.weight = 1 - d * m_inverseDiameter;
+		contact.normal = -n;
+		contact.mass = invM > 0 ? 1 / invM : 0;
+		DetectStuckParticle(a);
+	}
+}
+
+void b2ParticleSystem::SolveCollisionWithStaticDistanceField(
+	const b2TimeStep& step)
+{
+	// Baked fixtures never move, but a fast particle can cross a fixture
+	// thinner than its step and end up outside it. So the step is marched
+	// through the field at most one cell at a time, and the particle is
+	// pushed back out at the first sample inside a fixture.
+	UpdateStaticDistanceField();
+	const float32 inverseCellSize = m_staticDistanceField.inverseCellSize;
+	for (int32 a = 0; a < m_count; a++)
+	{
+		b2Vec2 ap = m_positionBuffer.data[a];
+		b2Vec2 av = m_velocityBuffer.data[a];
+		b2Vec2 delta = step.dt * av;
+		int32 sampleCount = (int32)ceilf(delta.Length() * inverseCellSize);
+		if (sampleCount < 1)
+		{
+			sampleCount = 1;
+		}
+		for (int32 i = 1; i <= sampleCount; i++)
+		{
+			b2Vec2 p2 = ap + ((float32)i / sampleCount) * delta;
+			float32 d;
+			b2Vec2 n;
+			b2Fixture* fixture;
+			if (!SampleStaticDistanceField(p2, &d, &n, &fixture) || d >= 0)
+			{
+				continue;
+			}
+			b2Vec2 p = p2 + (b2_linearSlop - d) * n;
+			b2Vec2 v = step.inv_dt * (p - ap);
+			m_velocityBuffer.data[a] = v;
+			b2Vec2 f = step.inv_dt * GetParticleMass() * (av - v);
+			ParticleApplyForce(a, f);
+			break;
+		}
+	}
+}
+
+void b2ParticleSystem::SetStaticDistanceField(const b2AABB& bounds,
+											  float32 cellSize)
+{
+	b2Assert(bounds.IsValid());
+	b2Assert(cellSize > 0);
+	ClearStaticDistanceField();
+
+	StaticDistanceField& field = m_staticDistanceField;
+	b2Vec2 extents = bounds.upperBound - bounds.lowerBound;
+	field.origin = bounds.lowerBound;
+	field.cellSize = cellSize;
+	field.inverseCellSize = 1 / cellSize;
+	field.width = (int32)ceilf(extents.x * field.inverseCellSize) + 1;
+	field.height = (int32)ceilf(extents.y * field.inverseCellSize) + 1;
+	// Contacts are created up to one particle diameter away; the extra
+	// cells keep the interpolated distance exact up to that point.
+	field.maxDistance = m_particleDiameter + 2 * cellSize;
+	int32 nodeCount = field.width * field.height;
+	field.distances = (float32*) b2Alloc(sizeof(float32) * nodeCount);
+	field.fixtures = (b2Fixture**) b2Alloc(sizeof(b2Fixture*) * nodeCount);
+	// Force a rebuild on first use.
+	field.version = m_world->m_staticGeometryVersion - 1;
+}
+
+void b2ParticleSystem::ClearStaticDistanceField()
+{
+	if (m_staticDistanceField.distances)
+	{
+		b2Free(m_staticDistanceField.distances);
+		b2Free(m_staticDistanceField.fixtures);
+		m_staticDistanceField.distances = NULL;
+		m_staticDistanceField.fixtures = NULL;
+	}
+}
+
+bool b2ParticleSystem::IsFixtureInStaticDistanceField(
+	const b2Fixture* fixture) const
+{
+	const StaticDistanceField& field = m_staticDistanceField;
+	if (!field.distances || fixture->IsSensor())
+	{
+		return false;
+	}
+	const b2Body* body = fixture->GetBody();
+	if (body->GetType() != b2_staticBody || !body->IsActive())
+	{
+		return false;
+	}
+	// Edges and chains have no inside, so they can't be baked as a signed
+	// distance.
+	b2Shape::Type type = fixture->GetType();
+	if (type != b2Shape::e_polygon && type != b2Shape::e_circle)
+	{
+		return false;
+	}
+	// Every point closer than maxDistance must be inside the grid.
+	const b2AABB& aabb = fixture->GetAABB(0);
+	b2Vec2 r(field.maxDistance, field.maxDistance);
+	b2Vec2 upper = field.origin + field.cellSize *
+		b2Vec2((float32)(field.width - 1), (float32)(field.height - 1));
+	return aabb.lowerBound.x - r.x >= field.origin.x &&
+		   aabb.lowerBound.y - r.y >= field.origin.y &&
+		   aabb.upperBound.x + r.x <= upper.x &&
+		   aabb.upperBound.y + r.y <= upper.y;
+}
+
+void b2ParticleSystem::UpdateStaticDistanceField()
+{
+	StaticDistanceField& field = m_staticDistanceField;
+	if (field.version == m_world->m_staticGeometryVersion)
+	{
+		return;
+	}
+	field.version = m_world->m_staticGeometryVersion;
+
+	const int32 nodeCount = field.width * field.height;
+	std::fill(field.distances, field.distances + nodeCount,
+			  field.maxDistance);
+	std::fill(field.fixtures, field.fixtures + nodeCount,
+			  (b2Fixture*) NULL);
+	for (b2Body* body = m_world->GetBodyList(); body;
+		 body = body->GetNext())
+	{
+		if (body->GetType() != b2_staticBody)
+		{
+			continue;
+		}
+		for (b2Fixture* fixture = body->GetFixtureList(); fixture;
+			 fixture = fixture->GetNext())
+		{
+			if (!IsFixtureInStaticDistanceField(fixture))
+			{
+				continue;
+			}
+			// Only the nodes near the fixture can be closer than
+			// maxDistance.
+			const b2AABB& aabb = fixture->GetAABB(0);
+			b2Vec2 lower = field.inverseCellSize *
+				(aabb.lowerBound - field.origin);
+			b2Vec2 upper = field.inverseCellSize *
+				(aabb.upperBound - field.origin);
+			float32 margin = field.maxDistance * field.inverseCellSize;
+			int32 x0 = b2Max((int32)floorf(lower.x - margin), 0);
+			int32 y0 = b2Max((int32)floorf(lower.y - margin), 0);
+			int32 x1 = b2Min((int32)ceilf(upper.x + margin), field.width - 1);
+			int32 y1 = b2Min((int32)ceilf(upper.y + margin),
+							 field.height - 1);
+			for (int32 y = y0; y <= y1; y++)
+			{
+				for (int32 x = x0; x <= x1; x++)
+				{
+					int32 i = y * field.width + x;
+					b2Vec2 p = field.origin +
+						field.cellSize * b2Vec2((float32)x, (float32)y);
+					float32 d;
+					b2Vec2 n;
+					fixture->ComputeDistance(p, &d, &n, 0);
+					if (d < field.distances[i])
+					{
+						field.distances[i] = d;
+						field.fixtures[i] = fixture;
+					}
+				}
+			}
+		}
+	}
+}
+
+bool b2ParticleSystem::SampleStaticDistanceField(
+	const b2Vec2& p, float32* distance, b2Vec2* normal,
+	b2Fixture** fixture) const
+{
+	const StaticDistanceField& field = m_staticDistanceField;
+	b2Vec2 g = field.inverseCellSize * (p - field.origin);
+	if (!(g.x >= 0 && g.y >= 0 &&
+		  g.x < (float32)(field.width - 1) &&
+		  g.y < (float32)(field.height - 1)))
+	{
+		return false;
+	}
+	int32 x = (int32)g.x;
+	int32 y = (int32)g.y;
+	float32 fx = g.x - (float32)x;
+	float32 fy = g.y - (float32)y;
+	int32 i00 = y * field.width + x;
+	int32 i10 = i00 + 1;
+	int32 i01 = i00 + field.width;
+	int32 i11 = i01 + 1;
+	float32 d00 = field.distances[i00];
+	float32 d10 = field.distances[i10];
+	float32 d01 = field.distances[i01];
+	float32 d11 = field.distances[i11];
+	float32 d0 = d00 + fx * (d10 - d00);
+	float32 d1 = d01 + fx * (d11 - d01);
+	*distance = d0 + fy * (d1 - d0);
+	// The gradient of the bilinear interpolation points away from the
+	// nearest surface.
+	b2Vec2 gradient(
+		(1 - fy) * (d10 - d00) + fy * (d11 - d01),
+		(1 - fx) * (d01 - d00) + fx * (d11 - d10));
+	if (gradient.Normalize() < b2_epsilon)
+	{
+		return false;
+	}
+	*normal = gradient;
+	// Report the fixture of the nearest corner.
+	int32 nearest = i00;
+	if (d10 < field.distances[nearest]) nearest = i10;
+	if (d01 < field.distances[nearest]) nearest = i01;
+	if (d11 < field.distances[nearest]) nearest = i11;
+	*fixture = field.fixtures[nearest];
+	return true;
 }
 
 void b2ParticleSystem::SolveBarrier(const b2TimeStep& step)
@@ -2953,18 +3645,38 @@ void b2ParticleSystem::SolveBarrier(const b2TimeStep& step)
 
 void b2ParticleSystem::Solve(const b2TimeStep& step)
 {
+	if (PrepareSolve(step))
+	{
+		for (int32 i = 0; i < step.particleIterations; i++)
+		{
+			SolveIteration(step, i);
+		}
+	}
+	FinishSolve();
+}
+
+bool b2ParticleSystem::PrepareSolve(const b2TimeStep& step)
+{
+	memset(&m_profile, 0, sizeof(m_profile));
 	if (m_count == 0)
 	{
-		return;
+		return false;
+	}
+	b2Timer timer;
+	if (m_stageProfiling)
+	{
+		m_stageTimer.Reset();
 	}
 	// If particle lifetimes are enabled, destroy particles that are too old.
 	if (m_expirationTimeBuffer.data)
 	{
 		SolveLifetimes(step);
+		EndStage(b2_particleStageLifetimes);
 	}
 	if (m_allParticleFlags & b2_zombieParticle)
 	{
 		SolveZombie();
+		EndStage(b2_particleStageZombie);
 	}
 	if (m_needsUpdateAllParticleFlags)
 	{
@@ -2974,105 +3686,199 @@ void b2ParticleSystem::Solve(const b2TimeStep& step)
 	{
 		UpdateAllGroupFlags();
 	}
-	if (m_paused)
+	m_profile.solve += timer.GetMilliseconds();
+	return !m_paused;
+}
+
+void b2ParticleSystem::SolveIteration(const b2TimeStep& step, int32 iteration)
+{
+	b2Timer timer;
+	m_iterationIndex = iteration;
+	++m_timestamp;
+	b2TimeStep subStep = step;
+	subStep.dt /= step.particleIterations;
+	subStep.inv_dt *= step.particleIterations;
+	if (m_stageProfiling)
 	{
-		return;
+		m_stageTimer.Reset();
 	}
-	for (m_iterationIndex = 0;
-		m_iterationIndex < step.particleIterations;
-		m_iterationIndex++)
+	UpdateContacts(false);
+	EndStage(b2_particleStageUpdateContacts);
+	UpdateBodyContacts();
+	EndStage(b2_particleStageUpdateBodyContacts);
+	ComputeWeight();
+	EndStage(b2_particleStageComputeWeight);
+	if (m_allGroupFlags & b2_particleGroupNeedsUpdateDepth)
 	{
-		++m_timestamp;
-		b2TimeStep subStep = step;
-		subStep.dt /= step.particleIterations;
-		subStep.inv_dt *= step.particleIterations;
-		UpdateContacts(false);
-		UpdateBodyContacts();
-		ComputeWeight();
-		if (m_allGroupFlags & b2_particleGroupNeedsUpdateDepth)
-		{
-			ComputeDepth();
-		}
-		if (m_allParticleFlags & b2_reactiveParticle)
-		{
-			UpdatePairsAndTriadsWithReactiveParticles();
-		}
-		if (m_hasForce)
-		{
-			SolveForce(subStep);
-		}
-		if (m_allParticleFlags & b2_viscousParticle)
-		{
-			SolveViscous();
-		}
-		if (m_allParticleFlags & b2_repulsiveParticle)
-		{
-			SolveRepulsive(subStep);
-		}
-		if (m_allParticleFlags & b2_powderParticle)
-		{
-			SolvePowder(subStep);
-		}
-		if (m_allParticleFlags & b2_tensileParticle)
-		{
-			SolveTensile(subStep);
-		}
-		if (m_allGroupFlags & b2_solidParticleGroup)
-		{
-			SolveSolid(subStep);
-		}
-		if (m_allParticleFlags & b2_colorMixingParticle)
-		{
-			SolveColorMixing();
-		}
-		SolveGravity(subStep);
-		if (m_allParticleFlags & b2_staticPressureParticle)
-		{
-			SolveStaticPressure(subStep);
-		}
-		SolvePressure(subStep);
-		SolveDamping(subStep);
-		if (m_allParticleFlags & k_extraDampingFlags)
-		{
-			SolveExtraDamping();
-		}
-		// SolveElastic and SolveSpring refer the current velocities for
-		// numerical stability, they should be called as late as possible.
-		if (m_allParticleFlags & b2_elasticParticle)
-		{
-			SolveElastic(subStep);
-		}
-		if (m_allParticleFlags & b2_springParticle)
-		{
-			SolveSpring(subStep);
-		}
-		LimitVelocity(subStep);
-		if (m_allGroupFlags & b2_rigidParticleGroup)
-		{
-			SolveRigidDamping();
-		}
-		if (m_allParticleFlags & b2_barrierParticle)
-		{
-			SolveBarrier(subStep);
-		}
-		// SolveCollision, SolveRigid and SolveWall should be called after
-		// other force functions because they may require particles to have
-		// specific velocities.
-		SolveCollision(subStep);
-		if (m_allGroupFlags & b2_rigidParticleGroup)
-		{
-			SolveRigid(subStep);
-		}
-		if (m_allParticleFlags & b2_wallParticle)
-		{
-			SolveWall();
-		}
-		// The particle positions can be updated only at the end of substep.
-		for (int32 i = 0; i < m_count; i++)
+		ComputeDepth();
+		EndStage(b2_particleStageComputeDepth);
+	}
+	if (m_allParticleFlags & b2_reactiveParticle)
+	{
+		UpdatePairsAndTriadsWithReactiveParticles();
+		EndStage(b2_particleStageReactive);
+	}
+	if (m_hasForce)
+	{
+		SolveForce(subStep);
+		EndStage(b2_particleStageForce);
+	}
+	if (m_allParticleFlags & b2_viscousParticle)
+	{
+		SolveViscous();
+		EndStage(b2_particleStageViscous);
+	}
+	if (m_allParticleFlags & b2_repulsiveParticle)
+	{
+		SolveRepulsive(subStep);
+		EndStage(b2_particleStageRepulsive);
+	}
+	if (m_allParticleFlags & b2_powderParticle)
+	{
+		SolvePowder(subStep);
+		EndStage(b2_particleStagePowder);
+	}
+	if (m_allParticleFlags & b2_tensileParticle)
+	{
+		SolveTensile(subStep);
+		EndStage(b2_particleStageTensile);
+	}
+	if (m_allGroupFlags & b2_solidParticleGroup)
+	{
+		SolveSolid(subStep);
+		EndStage(b2_particleStageSolid);
+	}
+	if (m_allParticleFlags & b2_colorMixingParticle)
+	{
+		SolveColorMixing();
+		EndStage(b2_particleStageColorMixing);
+	}
+	SolveGravity(subStep);
+	EndStage(b2_particleStageGravity);
+	if (m_allParticleFlags & b2_staticPressureParticle)
+	{
+		SolveStaticPressure(subStep);
+		EndStage(b2_particleStageStaticPressure);
+	}
+	SolvePressure(subStep);
+	EndStage(b2_particleStagePressure);
+	SolveDamping(subStep);
+	if (m_allParticleFlags & k_extraDampingFlags)
+	{
+		SolveExtraDamping();
+	}
+	EndStage(b2_particleStageDamping);
+	// SolveElastic and SolveSpring refer the current velocities for
+	// numerical stability, they should be called as late as possible.
+	if (m_allParticleFlags & b2_elasticParticle)
+	{
+		SolveElastic(subStep);
+		EndStage(b2_particleStageElastic);
+	}
+	if (m_allParticleFlags & b2_springParticle)
+	{
+		SolveSpring(subStep);
+		EndStage(b2_particleStageSpring);
+	}
+	LimitVelocity(subStep);
+	EndStage(b2_particleStageLimitVelocity);
+	if (m_allGroupFlags & b2_rigidParticleGroup)
+	{
+		SolveRigidDamping();
+		EndStage(b2_particleStageRigid);
+	}
+	if (m_allParticleFlags & b2_barrierParticle)
+	{
+		SolveBarrier(subStep);
+		EndStage(b2_particleStageBarrier);
+	}
+	// SolveCollision, SolveRigid and SolveWall should be called after
+	// other force functions because they may require particles to have
+	// specific velocities.
+	SolveCollision(subStep);
+	EndStage(b2_particleStageCollision);
+	if (m_allGroupFlags & b2_rigidParticleGroup)
+	{
+		SolveRigid(subStep);
+		EndStage(b2_particleStageRigid);
+	}
+	if (m_allParticleFlags & b2_wallParticle)
+	{
+		SolveWall();
+		EndStage(b2_particleStageWall);
+	}
+	// The particle positions can be updated only at the end of substep.
+	for (int32 i = 0; i < m_count; i++)
+	{
+		m_positionBuffer.data[i] += subStep.dt * m_velocityBuffer.data[i];
+	}
+	EndStage(b2_particleStageIntegrate);
+	m_profile.solve += timer.GetMilliseconds();
+}
+
+void b2ParticleSystem::FinishSolve()
+{
+	if (m_stageProfiling)
+	{
+		for (int32 i = 0; i < b2_particleStageCount; i++)
 		{
-			m_positionBuffer.data[i] += subStep.dt * m_velocityBuffer.data[i];
+			m_stageStats[i].Record(m_profile.stages[i]);
 		}
+		m_solveStat.Record(m_profile.solve);
+	}
+}
+
+void b2ParticleSystem::EndStage(b2ParticleStage stage)
+{
+	if (m_stageProfiling)
+	{
+		m_profile.stages[stage] += m_stageTimer.GetMilliseconds();
+		m_stageTimer.Reset();
+	}
+}
+
+void b2ParticleSystem::ClearStageStats()
+{
+	for (int32 i = 0; i < b2_particleStageCount; i++)
+	{
+		m_stageStats[i].Clear();
 	}
+	m_solveStat.Clear();
+}
+
+const char* b2ParticleSystem::GetStageName(b2ParticleStage stage)
+{
+	static const char* const names[b2_particleStageCount] =
+	{
+		"lifetimes",
+		"zombie",
+		"contacts",
+		"body contacts",
+		"weight",
+		"depth",
+		"reactive",
+		"force",
+		"viscous",
+		"repulsive",
+		"powder",
+		"tensile",
+		"solid",
+		"color mixing",
+		"gravity",
+		"static pressure",
+		"pressure",
+		"damping",
+		"elastic",
+		"spring",
+		"limit velocity",
+		"rigid",
+		"barrier",
+		"collision",
+		"wall",
+		"integrate",
+	};
+	b2Assert(0 <= stage && stage < b2_particleStageCount);
+	return names[stage];
 }
 
 void b2ParticleSystem::UpdateAllParticleFlags()
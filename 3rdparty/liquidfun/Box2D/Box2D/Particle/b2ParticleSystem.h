@@ -20,6 +20,8 @@
 
 #include <Box2D/Common/b2SlabAllocator.h>
 #include <Box2D/Common/b2GrowableBuffer.h>
+#include <Box2D/Common/b2Stat.h>
+#include <Box2D/Common/b2Timer.h>
 #include <Box2D/Particle/b2Particle.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -35,6 +37,7 @@ class b2World;
 class b2Body;
 class b2Shape;
 class b2ParticleGroup;
+class b2ParticleGroupTemplate;
 class b2BlockAllocator;
 class b2StackAllocator;
 class b2QueryCallback;
@@ -43,6 +46,8 @@ class b2Fixture;
 class b2ContactFilter;
 class b2ContactListener;
 class b2ParticlePairSet;
+class b2SnapshotReader;
+class b2SnapshotWriter;
 class FixtureParticleSet;
 struct b2ParticleGroupDef;
 struct b2Vec2;
@@ -352,6 +357,27 @@ public:
 	/// @warning This function is locked during callbacks.
 	b2ParticleGroup* CreateParticleGroup(const b2ParticleGroupDef& def);
 
+	/// Sample the particle layout of a group definition once so that it can
+	/// be instantiated repeatedly with CreateParticleGroup(tmpl, ...).
+	/// The shapes and position data of the definition are not retained.
+	/// @param def the group definition to sample. position and angle are
+	/// ignored; the layout is stored relative to the group origin.
+	/// @param tmpl receives the layout. Any previous layout is released.
+	void CreateParticleGroupTemplate(const b2ParticleGroupDef& def,
+									 b2ParticleGroupTemplate* tmpl);
+
+	/// Create a particle group from a template. The particles are appended
+	/// to the buffers in bulk instead of being created one at a time.
+	/// The template must have been created with this particle system's
+	/// stride in mind.
+	/// @param tmpl the sampled layout.
+	/// @param position the world position of the group origin.
+	/// @param angle the world angle of the group in radians.
+	/// @warning This function is locked during callbacks.
+	b2ParticleGroup* CreateParticleGroup(const b2ParticleGroupTemplate& tmpl,
+										 const b2Vec2& position,
+										 float32 angle);
+
 	/// Join two particle groups.
 	/// @param the first group. Expands to encompass the second group.
 	/// @param the second group. It is destroyed.
@@ -405,6 +431,32 @@ public:
 	/// Initially, true, then, the last value passed into SetPaused().
 	bool GetPaused() const;
 
+	/// Enable or disable timing each stage of the particle solver. The
+	/// times are in GetProfile() and b2World::GetProfile() and statistics
+	/// of them in GetStageStat(). Initially disabled.
+	void SetStageProfiling(bool enabled);
+
+	/// @return true if the stages of the particle solver are timed.
+	bool GetStageProfiling() const;
+
+	/// Get the time spent solving the particles during the last step.
+	const b2ParticleProfile& GetProfile() const;
+
+	/// Get the statistics of the time spent in a stage of the particle
+	/// solver per step, in milliseconds. Only steps with stage profiling
+	/// enabled are recorded.
+	const b2Stat& GetStageStat(b2ParticleStage stage) const;
+
+	/// Get the statistics of the total time spent in the particle solver per
+	/// step, recorded like GetStageStat().
+	const b2Stat& GetSolveStat() const;
+
+	/// Erase the statistics recorded for the particle solver stages.
+	void ClearStageStats();
+
+	/// Get a short name of a stage of the particle solver for display.
+	static const char* GetStageName(b2ParticleStage stage);
+
 	/// Change the particle density.
 	/// Particle density affects the mass of the particles, which in turn
 	/// affects how the particles interact with b2Bodies. Note that the density
@@ -587,6 +639,22 @@ public:
 	/// Get the status of the strict contact check.
 	bool GetStrictContactCheck() const;
 
+	/// Bake the signed distance to the fixtures of static bodies into a
+	/// grid, so particles collide with them by sampling the grid instead of
+	/// querying the world and calling b2Fixture::ComputeDistance.
+	/// Only non-sensor polygon and circle fixtures of active static bodies
+	/// that lie completely inside bounds are baked; all other fixtures are
+	/// collided with as before. The grid is rebuilt automatically when a
+	/// static fixture is created, destroyed or moved.
+	/// @param bounds the world-space area covered by the grid.
+	/// @param cellSize the grid spacing. Values around the particle radius
+	/// or smaller keep the sampled surface close to the real one.
+	void SetStaticDistanceField(const b2AABB& bounds, float32 cellSize);
+	/// Disable the static distance field and free its grid.
+	void ClearStaticDistanceField();
+	/// Whether a static distance field is enabled.
+	bool HasStaticDistanceField() const;
+
 	/// Set the lifetime (in seconds) of a particle relative to the current
 	/// time.  A lifetime of less than or equal to 0.0f results in the particle
 	/// living forever until it's manually destroyed by the application.
@@ -830,6 +898,28 @@ private:
 		const Proxy* m_last;
 	};
 
+	/// Signed distance to the static fixtures sampled at the nodes of a
+	/// regular grid. See SetStaticDistanceField().
+	struct StaticDistanceField
+	{
+		/// World position of node (0, 0).
+		b2Vec2 origin;
+		float32 cellSize;
+		float32 inverseCellSize;
+		/// Number of nodes in each direction.
+		int32 width, height;
+		/// Distances are only exact up to this value; nodes farther from
+		/// every baked fixture store it as is.
+		float32 maxDistance;
+		/// Signed distance to the nearest baked fixture at each node.
+		float32* distances;
+		/// Nearest baked fixture at each node or NULL if it is farther
+		/// than maxDistance.
+		b2Fixture** fixtures;
+		/// b2World::m_staticGeometryVersion the grid was baked from.
+		int32 version;
+	};
+
 	/// Node of linked lists of connected particles
 	struct ParticleListNode
 	{
@@ -883,21 +973,46 @@ private:
 	int32 CreateParticleForGroup(
 		const b2ParticleGroupDef& groupDef,
 		const b2Transform& xf, const b2Vec2& position);
-	void CreateParticlesStrokeShapeForGroup(
-		const b2Shape* shape,
-		const b2ParticleGroupDef& groupDef, const b2Transform& xf);
-	void CreateParticlesFillShapeForGroup(
-		const b2Shape* shape,
-		const b2ParticleGroupDef& groupDef, const b2Transform& xf);
-	void CreateParticlesWithShapeForGroup(
-		const b2Shape* shape,
-		const b2ParticleGroupDef& groupDef, const b2Transform& xf);
-	void CreateParticlesWithShapesForGroup(
-		const b2Shape* const* shapes, int32 shapeCount,
-		const b2ParticleGroupDef& groupDef, const b2Transform& xf);
+	b2ParticleGroup* CreateParticleGroupForRange(
+		const b2ParticleGroupDef& groupDef, const b2Transform& transform,
+		int32 firstIndex, int32 lastIndex);
+	void SampleParticlesStrokeShape(
+		const b2Shape* shape, float32 stride,
+		b2GrowableBuffer<b2Vec2>* positions);
+	void SampleParticlesFillShape(
+		const b2Shape* shape, float32 stride,
+		b2GrowableBuffer<b2Vec2>* positions);
+	void SampleParticlesWithShape(
+		const b2Shape* shape, float32 stride,
+		b2GrowableBuffer<b2Vec2>* positions);
+	void SampleParticlesWithShapes(
+		const b2Shape* const* shapes, int32 shapeCount, float32 stride,
+		b2GrowableBuffer<b2Vec2>* positions);
+	void SampleParticleGroupShapes(
+		const b2ParticleGroupDef& groupDef,
+		b2GrowableBuffer<b2Vec2>* positions);
 	int32 CloneParticle(int32 index, b2ParticleGroup* group);
 	void DestroyParticleGroup(b2ParticleGroup* group);
 
+	/// Write the particles and particle groups to a world snapshot.
+	void Save(b2SnapshotWriter* writer) const;
+	/// Make sure the buffers can hold count particles before restoring a
+	/// snapshot.
+	bool ReserveForRestore(int32 count);
+	/// Read back the particles written with Save(). The particle groups are
+	/// recreated and the particle handles released.
+	void Restore(b2SnapshotReader* reader);
+	template <typename T> void SaveBuffer(
+		b2SnapshotWriter* writer, const T* buffer) const;
+	template <typename T> void RestoreBuffer(
+		b2SnapshotReader* reader, T** buffer);
+	template <typename T> void RestoreBuffer(
+		b2SnapshotReader* reader, UserOverridableBuffer<T>* buffer);
+	template <typename T> static void SaveBuffer(
+		b2SnapshotWriter* writer, const b2GrowableBuffer<T>& buffer);
+	template <typename T> static void RestoreBuffer(
+		b2SnapshotReader* reader, b2GrowableBuffer<T>* buffer);
+
 	void UpdatePairsAndTriads(
 		int32 firstIndex, int32 lastIndex, const ConnectionFilter& filter);
 	void UpdatePairsAndTriadsWithReactiveParticles();
@@ -972,6 +1087,18 @@ private:
 	void UpdateBodyContacts();
 
 	void Solve(const b2TimeStep& step);
+	/// Solve the stages done once per step. Returns false if there are no
+	/// iterations to solve.
+	bool PrepareSolve(const b2TimeStep& step);
+	/// Solve one particle iteration (substep) of the step.
+	void SolveIteration(const b2TimeStep& step, int32 iteration);
+	/// Record the profile of the step to the stage statistics.
+	void FinishSolve();
+	/// Query the fixtures the world gathered for all particle systems, or
+	/// the world itself if they don't cover aabb. Particles aren't reported.
+	void QueryFixtures(b2QueryCallback* callback, const b2AABB& aabb) const;
+	/// Add the time since the last stage to the stage profile.
+	void EndStage(b2ParticleStage stage);
 	void SolveCollision(const b2TimeStep& step);
 	void LimitVelocity(const b2TimeStep& step);
 	void SolveGravity(const b2TimeStep& step);
@@ -1028,6 +1155,12 @@ private:
 	void SetGroupFlags(b2ParticleGroup* group, uint32 flags);
 
 	void RemoveSpuriousBodyContacts();
+	void UpdateBodyContactsWithStaticDistanceField();
+	void SolveCollisionWithStaticDistanceField(const b2TimeStep& step);
+	void UpdateStaticDistanceField();
+	bool IsFixtureInStaticDistanceField(const b2Fixture* fixture) const;
+	bool SampleStaticDistanceField(const b2Vec2& p, float32* distance,
+								   b2Vec2* normal, b2Fixture** fixture) const;
 	static bool BodyContactCompare(const b2ParticleBodyContact& lhs,
 								   const b2ParticleBodyContact& rhs);
 
@@ -1066,6 +1199,11 @@ private:
 		float32 impulse, const b2Vec2& normal);
 
 	bool m_paused;
+	bool m_stageProfiling;
+	b2ParticleProfile m_profile;
+	b2Timer m_stageTimer;
+	b2Stat m_stageStats[b2_particleStageCount];
+	b2Stat m_solveStat;
 	int32 m_timestamp;
 	int32 m_allParticleFlags;
 	bool m_needsUpdateAllParticleFlags;
@@ -1125,6 +1263,9 @@ private:
 	b2GrowableBuffer<b2ParticlePair> m_pairBuffer;
 	b2GrowableBuffer<b2ParticleTriad> m_triadBuffer;
 
+	/// Baked distance to static fixtures. distances is NULL when disabled.
+	StaticDistanceField m_staticDistanceField;
+
 	/// Time each particle should be destroyed relative to the last time
 	/// m_timeElapsed was initialized.  Each unit of time corresponds to
 	/// b2ParticleSystemDef::lifetimeGranularity seconds.
@@ -1210,6 +1351,33 @@ inline bool b2ParticleSystem::GetPaused() const
 	return m_paused;
 }
 
+inline void b2ParticleSystem::SetStageProfiling(bool enabled)
+{
+	m_stageProfiling = enabled;
+}
+
+inline bool b2ParticleSystem::GetStageProfiling() const
+{
+	return m_stageProfiling;
+}
+
+inline const b2ParticleProfile& b2ParticleSystem::GetProfile() const
+{
+	return m_profile;
+}
+
+inline const b2Stat& b2ParticleSystem::GetStageStat(
+	b2ParticleStage stage) const
+{
+	b2Assert(0 <= stage && stage < b2_particleStageCount);
+	return m_stageStats[stage];
+}
+
+inline const b2Stat& b2ParticleSystem::GetSolveStat() const
+{
+	return m_solveStat;
+}
+
 inline const b2ParticleContact* b2ParticleSystem::GetContacts() const
 {
 	return m_contactBuffer.Data();
@@ -1270,6 +1438,11 @@ inline int32 b2ParticleSystem::GetStuckCandidateCount() const
 	return m_stuckParticleBuffer.GetCount();
 }
 
+inline bool b2ParticleSystem::HasStaticDistanceField() const
+{
+	return m_staticDistanceField.distances != NULL;
+}
+
 inline void b2ParticleSystem::SetStrictContactCheck(bool enabled)
 {
 	m_def.strictContactCheck = enabled;
@@ -375,6 +375,67 @@ TEST_F(BodyContactTests, StuckParticleDetection)
 	}
 }
 
+// Verify that particles collide with static fixtures baked into a
+// distance field and that the field follows changes to them.
+TEST_F(BodyContactTests, StaticDistanceField)
+{
+	b2Fixture* ground = CreateGroundBox();
+	b2AABB bounds;
+	bounds.lowerBound.Set(-5.0f, -2.0f);
+	bounds.upperBound.Set(5.0f, 5.0f);
+	m_particleSystem->SetStaticDistanceField(
+		bounds, m_particleSystem->GetRadius() * 0.5f);
+	EXPECT_TRUE(m_particleSystem->HasStaticDistanceField());
+
+	DropParticle();
+	EXPECT_GT(m_contacts, 0) << "No contacts within timeout";
+	ASSERT_EQ(m_particleSystem->GetBodyContactCount(), 1);
+	EXPECT_EQ(m_particleSystem->GetBodyContacts()->fixture, ground);
+	const b2Vec2& position = m_particleSystem->GetPositionBuffer()[0];
+	EXPECT_GT(position.y, m_particleDiameter * 0.5f);
+	EXPECT_LT(position.y, m_particleDiameter * 2.0f);
+
+	// Removing the ground has to invalidate the field.
+	m_groundBody->DestroyFixture(ground);
+	RunStep(60.0f, 1.0f);
+	EXPECT_EQ(m_particleSystem->GetBodyContactCount(), 0);
+	EXPECT_LT(m_particleSystem->GetPositionBuffer()[0].y, 0.0f);
+
+	m_particleSystem->ClearStaticDistanceField();
+	EXPECT_FALSE(m_particleSystem->HasStaticDistanceField());
+}
+
+// Verify that a fast particle can't pass through a baked fixture that is
+// thinner than its step.
+TEST_F(BodyContactTests, StaticDistanceFieldThinFixture)
+{
+	b2PolygonShape shape;
+	shape.SetAsBox(10.0f * m_particleDiameter, m_particleDiameter * 0.25f);
+	m_groundBody->CreateFixture(&shape, 0.0f);
+	b2AABB bounds;
+	bounds.lowerBound.Set(-5.0f, -2.0f);
+	bounds.upperBound.Set(5.0f, 5.0f);
+	m_particleSystem->SetStaticDistanceField(
+		bounds, m_particleSystem->GetRadius() * 0.25f);
+	// Without damping only the collision solver can stop the particle.
+	m_particleSystem->SetDamping(0.0f);
+
+	// Whether the end of a step lands inside the fixture depends on where
+	// the particle starts from, so drop it from heights a step apart.
+	for (int32 i = 0; i < 10; i++)
+	{
+		DestroyAllParticles();
+		RunStep(60.0f, 0.0f);
+		b2ParticleDef pd;
+		pd.position.Set(0.0f, 3.3f + i * m_particleDiameter * 0.1f);
+		pd.velocity.Set(0.0f, -100.0f);
+		m_particleSystem->CreateParticle(pd);
+		RunStep(60.0f, 1.0f);
+		EXPECT_GT(m_particleSystem->GetPositionBuffer()[0].y, 0.0f)
+			<< "Particle dropped from " << pd.position.y << " passed through";
+	}
+}
+
 // Verify that it's possible to detect particle / body collisions using
 // a contact filter.
 TEST_F(BodyContactTests, FixtureParticleContactFilter)
@@ -0,0 +1,507 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "gtest/gtest.h"
+#include "Box2D/Box2D.h"
+#include "AndroidUtil/AndroidMainWrapper.h"
+
+#include <algorithm>
+#include <vector>
+
+// Collects the fixtures reported by b2World::QueryAABB.
+class FixtureCollector : public b2QueryCallback
+{
+public:
+	virtual bool ReportFixture(b2Fixture* fixture)
+	{
+		m_fixtures.push_back(fixture);
+		return true;
+	}
+
+	std::vector<b2Fixture*> m_fixtures;
+};
+
+// Collects the proxies reported by b2DynamicTree::Query.
+class ProxyCollector
+{
+public:
+	bool QueryCallback(int32 proxyId)
+	{
+		m_proxyIds.push_back(proxyId);
+		return true;
+	}
+
+	std::vector<int32> m_proxyIds;
+};
+
+// Finds the closest fixture along a ray.
+class ClosestRayCast : public b2RayCastCallback
+{
+public:
+	ClosestRayCast() : m_fixture(NULL), m_fraction(1.0f) {}
+
+	virtual float32 ReportFixture(b2Fixture* fixture, const b2Vec2& point,
+								  const b2Vec2& normal, float32 fraction)
+	{
+		B2_NOT_USED(point);
+		B2_NOT_USED(normal);
+		m_fixture = fixture;
+		m_fraction = fraction;
+		return fraction;
+	}
+
+	b2Fixture* m_fixture;
+	float32 m_fraction;
+};
+
+class BroadPhaseTests : public ::testing::Test {
+protected:
+	virtual void SetUp();
+	virtual void TearDown();
+
+	// Create a box body in the world.
+	b2Body* CreateBox(b2World* world, b2BodyType type,
+					  const b2Vec2& position, float32 halfSize);
+	// Create a level of static boxes with dynamic boxes above them.
+	void CreateScene(b2World* world, std::vector<b2Body*>* dynamicBodies);
+	// Create the same scene as CreateScene() with b2World::CreateBatch().
+	void CreateSceneBatch(b2World* world, std::vector<b2Body*>* dynamicBodies);
+	// Step the world.
+	void Step(b2World* world, float32 seconds);
+
+	b2World *m_world;
+};
+
+static const float32 k_timeStep = 1.0f / 60.0f;
+
+void
+BroadPhaseTests::SetUp()
+{
+	m_world = new b2World(b2Vec2(0.0f, -10.0f));
+	m_world->SetSeparateStaticTree(true);
+}
+
+void
+BroadPhaseTests::TearDown()
+{
+	delete m_world;
+}
+
+b2Body*
+BroadPhaseTests::CreateBox(b2World* world, b2BodyType type,
+						   const b2Vec2& position, float32 halfSize)
+{
+	b2BodyDef bd;
+	bd.type = type;
+	bd.position = position;
+	b2PolygonShape shape;
+	shape.SetAsBox(halfSize, halfSize);
+	b2Body* body = world->CreateBody(&bd);
+	body->CreateFixture(&shape, 1.0f);
+	return body;
+}
+
+void
+BroadPhaseTests::CreateScene(b2World* world,
+							 std::vector<b2Body*>* dynamicBodies)
+{
+	for (int32 i = 0; i < 20; ++i)
+	{
+		// Neighbouring static boxes overlap.
+		CreateBox(world, b2_staticBody, b2Vec2(-19.0f + 2.0f * i, 0.0f),
+				  1.2f);
+	}
+	for (int32 i = 0; i < 10; ++i)
+	{
+		dynamicBodies->push_back(CreateBox(
+			world, b2_dynamicBody, b2Vec2(-18.0f + 4.0f * i, 3.0f), 0.5f));
+	}
+}
+
+void
+BroadPhaseTests::CreateSceneBatch(b2World* world,
+								  std::vector<b2Body*>* dynamicBodies)
+{
+	b2PolygonShape staticShape;
+	staticShape.SetAsBox(1.2f, 1.2f);
+	b2PolygonShape dynamicShape;
+	dynamicShape.SetAsBox(0.5f, 0.5f);
+
+	b2BodyDef bodyDefs[30];
+	b2FixtureDef fixtureDefs[30];
+	int32 fixtureBodies[30];
+	for (int32 i = 0; i < 30; ++i)
+	{
+		const bool isStatic = i < 20;
+		bodyDefs[i].type = isStatic ? b2_staticBody : b2_dynamicBody;
+		bodyDefs[i].position = isStatic ?
+			b2Vec2(-19.0f + 2.0f * i, 0.0f) :
+			b2Vec2(-18.0f + 4.0f * (i - 20), 3.0f);
+		fixtureDefs[i].shape = isStatic ? &staticShape : &dynamicShape;
+		fixtureDefs[i].density = 1.0f;
+		fixtureBodies[i] = i;
+	}
+
+	b2BatchDef def;
+	def.bodies = bodyDefs;
+	def.bodyCount = 30;
+	def.fixtures = fixtureDefs;
+	def.fixtureBodies = fixtureBodies;
+	def.fixtureCount = 30;
+	b2Body* bodies[30];
+	world->CreateBatch(&def, bodies, NULL, NULL);
+	dynamicBodies->insert(dynamicBodies->end(), bodies + 20, bodies + 30);
+}
+
+void
+BroadPhaseTests::Step(b2World* world, float32 seconds)
+{
+	for (float32 t = 0.0f; t < seconds; t += k_timeStep)
+	{
+		world->Step(k_timeStep, 8, 3);
+	}
+}
+
+// Boxes land on static geometry the same way with and without the static
+// tree, and static boxes never get contacts with each other.
+TEST_F(BroadPhaseTests, SameContactsAsSingleTree) {
+	b2World singleTreeWorld(b2Vec2(0.0f, -10.0f));
+	std::vector<b2Body*> bodies, singleTreeBodies;
+	CreateScene(m_world, &bodies);
+	CreateScene(&singleTreeWorld, &singleTreeBodies);
+	Step(m_world, 2.0f);
+	Step(&singleTreeWorld, 2.0f);
+
+	EXPECT_EQ(singleTreeWorld.GetContactCount(), m_world->GetContactCount());
+	EXPECT_EQ(singleTreeWorld.GetProxyCount(), m_world->GetProxyCount());
+	for (const b2Contact* c = m_world->GetContactList(); c; c = c->GetNext())
+	{
+		EXPECT_FALSE(c->GetFixtureA()->GetBody()->GetType() == b2_staticBody &&
+					 c->GetFixtureB()->GetBody()->GetType() == b2_staticBody);
+	}
+	for (uint32 i = 0; i < bodies.size(); ++i)
+	{
+		// Resting on top of a static box.
+		EXPECT_NEAR(1.7f, bodies[i]->GetPosition().y, 0.05f);
+		EXPECT_NEAR(singleTreeBodies[i]->GetPosition().x,
+					bodies[i]->GetPosition().x, 1e-4f);
+		EXPECT_NEAR(singleTreeBodies[i]->GetPosition().y,
+					bodies[i]->GetPosition().y, 1e-4f);
+	}
+}
+
+// Queries and ray casts see the fixtures of both trees.
+TEST_F(BroadPhaseTests, QueryAndRayCast) {
+	b2Body* ground = CreateBox(m_world, b2_staticBody, b2Vec2(0.0f, 0.0f),
+							   1.0f);
+	b2Body* box = CreateBox(m_world, b2_dynamicBody, b2Vec2(0.0f, 5.0f),
+							1.0f);
+	m_world->Step(k_timeStep, 8, 3);
+
+	FixtureCollector collector;
+	b2AABB aabb;
+	aabb.lowerBound.Set(-2.0f, -2.0f);
+	aabb.upperBound.Set(2.0f, 8.0f);
+	m_world->QueryAABB(&collector, aabb);
+	ASSERT_EQ(2U, collector.m_fixtures.size());
+	EXPECT_NE(collector.m_fixtures[0], collector.m_fixtures[1]);
+
+	// Straight down hits the dynamic box first, straight up from below
+	// hits the ground first.
+	ClosestRayCast down;
+	m_world->RayCast(&down, b2Vec2(0.0f, 10.0f), b2Vec2(0.0f, -10.0f));
+	EXPECT_EQ(box->GetFixtureList(), down.m_fixture);
+	ClosestRayCast up;
+	m_world->RayCast(&up, b2Vec2(0.0f, -10.0f), b2Vec2(0.0f, 10.0f));
+	EXPECT_EQ(ground->GetFixtureList(), up.m_fixture);
+}
+
+// Changing a body to and from static moves its proxies between the trees.
+TEST_F(BroadPhaseTests, ChangeBodyType) {
+	CreateBox(m_world, b2_staticBody, b2Vec2(0.0f, 0.0f), 1.0f);
+	b2Body* box = CreateBox(m_world, b2_staticBody, b2Vec2(0.0f, 3.0f), 0.5f);
+	Step(m_world, 0.5f);
+	EXPECT_EQ(0, m_world->GetContactCount());
+
+	box->SetType(b2_dynamicBody);
+	Step(m_world, 1.0f);
+	EXPECT_EQ(1, m_world->GetContactCount());
+	EXPECT_NEAR(1.5f, box->GetPosition().y, 0.05f);
+
+	box->SetType(b2_staticBody);
+	Step(m_world, 0.5f);
+	EXPECT_EQ(0, m_world->GetContactCount());
+	EXPECT_EQ(2, m_world->GetProxyCount());
+}
+
+// The static tree can be turned on and off with bodies in the world.
+TEST_F(BroadPhaseTests, Toggle) {
+	std::vector<b2Body*> bodies;
+	m_world->SetSeparateStaticTree(false);
+	CreateScene(m_world, &bodies);
+	Step(m_world, 1.0f);
+	const int32 proxyCount = m_world->GetProxyCount();
+	const int32 contactCount = m_world->GetContactCount();
+
+	m_world->SetSeparateStaticTree(true);
+	EXPECT_TRUE(m_world->GetSeparateStaticTree());
+	EXPECT_EQ(proxyCount, m_world->GetProxyCount());
+	Step(m_world, 1.0f);
+	m_world->SetSeparateStaticTree(false);
+	EXPECT_FALSE(m_world->GetSeparateStaticTree());
+	Step(m_world, 1.0f);
+
+	EXPECT_EQ(proxyCount, m_world->GetProxyCount());
+	EXPECT_EQ(contactCount, m_world->GetContactCount());
+	for (uint32 i = 0; i < bodies.size(); ++i)
+	{
+		EXPECT_NEAR(1.7f, bodies[i]->GetPosition().y, 0.05f);
+	}
+}
+
+// Bodies created in a batch behave like bodies created one by one, with
+// and without the static tree.
+TEST_F(BroadPhaseTests, CreateBatch) {
+	b2World singleTreeWorld(b2Vec2(0.0f, -10.0f));
+	b2World referenceWorld(b2Vec2(0.0f, -10.0f));
+	std::vector<b2Body*> bodies, singleTreeBodies, referenceBodies;
+	CreateSceneBatch(m_world, &bodies);
+	CreateSceneBatch(&singleTreeWorld, &singleTreeBodies);
+	CreateScene(&referenceWorld, &referenceBodies);
+	EXPECT_EQ(referenceWorld.GetBodyCount(), m_world->GetBodyCount());
+	EXPECT_EQ(referenceWorld.GetProxyCount(), m_world->GetProxyCount());
+	EXPECT_EQ(referenceWorld.GetProxyCount(), singleTreeWorld.GetProxyCount());
+	Step(m_world, 2.0f);
+	Step(&singleTreeWorld, 2.0f);
+	Step(&referenceWorld, 2.0f);
+
+	EXPECT_EQ(referenceWorld.GetContactCount(), m_world->GetContactCount());
+	EXPECT_EQ(referenceWorld.GetContactCount(),
+			  singleTreeWorld.GetContactCount());
+	for (uint32 i = 0; i < bodies.size(); ++i)
+	{
+		EXPECT_EQ(referenceBodies[i]->GetMass(), bodies[i]->GetMass());
+		EXPECT_NEAR(referenceBodies[i]->GetPosition().x,
+					bodies[i]->GetPosition().x, 1e-4f);
+		EXPECT_NEAR(referenceBodies[i]->GetPosition().y,
+					bodies[i]->GetPosition().y, 1e-4f);
+		EXPECT_NEAR(referenceBodies[i]->GetPosition().y,
+					singleTreeBodies[i]->GetPosition().y, 1e-4f);
+	}
+}
+
+// Joints in a batch connect bodies of the batch, or bodies created earlier.
+TEST_F(BroadPhaseTests, CreateBatchJoints) {
+	b2Body* anchor = CreateBox(m_world, b2_staticBody, b2Vec2(0.0f, 10.0f),
+							   0.5f);
+
+	b2CircleShape shape;
+	shape.m_radius = 0.25f;
+	b2BodyDef bodyDefs[4];
+	b2FixtureDef fixtureDefs[4];
+	int32 fixtureBodies[4];
+	b2RevoluteJointDef revoluteDefs[4];
+	b2JointDef* jointDefs[4];
+	int32 jointBodiesA[4];
+	int32 jointBodiesB[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		bodyDefs[i].type = b2_dynamicBody;
+		bodyDefs[i].position.Set(1.0f + i, 10.0f);
+		fixtureDefs[i].shape = &shape;
+		fixtureDefs[i].density = 1.0f;
+		fixtureBodies[i] = i;
+		// Each link hangs from the previous one, the first from the anchor.
+		revoluteDefs[i].bodyA = anchor;
+		revoluteDefs[i].localAnchorA.Set(i == 0 ? 0.0f : 1.0f, 0.0f);
+		jointDefs[i] = revoluteDefs + i;
+		jointBodiesA[i] = i - 1;
+		jointBodiesB[i] = i;
+	}
+
+	b2BatchDef def;
+	def.bodies = bodyDefs;
+	def.bodyCount = 4;
+	def.fixtures = fixtureDefs;
+	def.fixtureBodies = fixtureBodies;
+	def.fixtureCount = 4;
+	def.joints = jointDefs;
+	def.jointBodiesA = jointBodiesA;
+	def.jointBodiesB = jointBodiesB;
+	def.jointCount = 4;
+	b2Body* bodies[4];
+	b2Fixture* fixtures[4];
+	b2Joint* joints[4];
+	m_world->CreateBatch(&def, bodies, fixtures, joints);
+
+	EXPECT_EQ(5, m_world->GetBodyCount());
+	EXPECT_EQ(4, m_world->GetJointCount());
+	EXPECT_EQ(anchor, joints[0]->GetBodyA());
+	for (int32 i = 0; i < 4; ++i)
+	{
+		EXPECT_EQ(bodies[i], fixtures[i]->GetBody());
+		EXPECT_EQ(bodies[i], joints[i]->GetBodyB());
+		if (i > 0)
+		{
+			EXPECT_EQ(bodies[i - 1], joints[i]->GetBodyA());
+		}
+	}
+
+	// The chain swings down but stays in one piece.
+	Step(m_world, 2.0f);
+	for (int32 i = 1; i < 4; ++i)
+	{
+		EXPECT_NEAR(1.0f, b2Distance(bodies[i - 1]->GetPosition(),
+									 bodies[i]->GetPosition()), 0.05f);
+	}
+	EXPECT_LT(bodies[3]->GetPosition().y, 10.0f);
+}
+
+// Deterministic pseudo random AABBs of different sizes.
+static void RandomAABBs(int32 count, std::vector<b2AABB>* aabbs)
+{
+	uint32 seed = 12345;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 v[4];
+		for (int32 j = 0; j < 4; ++j)
+		{
+			seed = seed * 1664525 + 1013904223;
+			v[j] = (float32)(seed >> 8) / (float32)(1 << 24);
+		}
+		b2AABB aabb;
+		aabb.lowerBound.Set(100.0f * v[0] - 50.0f, 100.0f * v[1] - 50.0f);
+		aabb.upperBound = aabb.lowerBound + b2Vec2(0.1f + 3.0f * v[2],
+												   0.1f + 3.0f * v[3]);
+		aabbs->push_back(aabb);
+	}
+}
+
+// Query a tree and compare the result against testing every proxy.
+static void ExpectSameAsBruteForce(const b2DynamicTree& tree,
+								   const std::vector<int32>& proxyIds,
+								   const b2AABB& aabb)
+{
+	ProxyCollector collector;
+	tree.Query(&collector, aabb);
+	std::vector<int32> expected;
+	for (uint32 i = 0; i < proxyIds.size(); ++i)
+	{
+		if (b2TestOverlap(tree.GetFatAABB(proxyIds[i]), aabb))
+		{
+			expected.push_back(proxyIds[i]);
+		}
+	}
+	std::sort(collector.m_proxyIds.begin(), collector.m_proxyIds.end());
+	std::sort(expected.begin(), expected.end());
+	EXPECT_EQ(expected, collector.m_proxyIds);
+}
+
+// Rebuilding a tree keeps the proxy ids and finds the same proxies, in a
+// tree no worse than the one built incrementally.
+TEST_F(BroadPhaseTests, RebuildTree) {
+	std::vector<b2AABB> aabbs;
+	RandomAABBs(500, &aabbs);
+	b2DynamicTree tree;
+	std::vector<int32> proxyIds;
+	for (uint32 i = 0; i < aabbs.size(); ++i)
+	{
+		proxyIds.push_back(tree.CreateProxy(aabbs[i], &aabbs[i]));
+	}
+	const float32 incrementalAreaRatio = tree.GetAreaRatio();
+
+	tree.Rebuild();
+	tree.Validate();
+	EXPECT_LE(tree.GetAreaRatio(), incrementalAreaRatio);
+	for (uint32 i = 0; i < proxyIds.size(); ++i)
+	{
+		EXPECT_EQ(&aabbs[i], tree.GetUserData(proxyIds[i]));
+	}
+	for (uint32 i = 0; i < 20; ++i)
+	{
+		b2AABB aabb = aabbs[i];
+		aabb.upperBound += b2Vec2(5.0f * i, 2.0f);
+		ExpectSameAsBruteForce(tree, proxyIds, aabb);
+	}
+
+	// The tree keeps working incrementally after the rebuild.
+	for (uint32 i = 0; i < proxyIds.size(); i += 2)
+	{
+		tree.DestroyProxy(proxyIds[i]);
+	}
+	tree.Validate();
+}
+
+// Creating proxies in bulk gives the same query results as creating them
+// one by one.
+TEST_F(BroadPhaseTests, CreateProxies) {
+	std::vector<b2AABB> aabbs;
+	RandomAABBs(300, &aabbs);
+	std::vector<void*> userData;
+	for (uint32 i = 0; i < aabbs.size(); ++i)
+	{
+		userData.push_back(&aabbs[i]);
+	}
+
+	b2DynamicTree tree;
+	std::vector<int32> proxyIds(aabbs.size());
+	tree.CreateProxies(&aabbs[0], &userData[0], 100, &proxyIds[0]);
+	tree.Validate();
+	// Adding more to a tree that already has proxies.
+	tree.CreateProxies(&aabbs[100], &userData[100], 200, &proxyIds[100]);
+	tree.Validate();
+
+	for (uint32 i = 0; i < proxyIds.size(); ++i)
+	{
+		EXPECT_EQ(userData[i], tree.GetUserData(proxyIds[i]));
+		EXPECT_TRUE(b2TestOverlap(tree.GetFatAABB(proxyIds[i]), aabbs[i]));
+	}
+	for (uint32 i = 0; i < 20; ++i)
+	{
+		b2AABB aabb = aabbs[10 * i];
+		aabb.lowerBound -= b2Vec2(2.0f, 1.0f * i);
+		ExpectSameAsBruteForce(tree, proxyIds, aabb);
+	}
+}
+
+// Degenerate trees: proxies that all share the same center.
+TEST_F(BroadPhaseTests, RebuildSameCenter) {
+	b2DynamicTree tree;
+	std::vector<int32> proxyIds;
+	for (int32 i = 0; i < 40; ++i)
+	{
+		b2AABB aabb;
+		aabb.lowerBound.Set(-1.0f - 0.1f * i, -1.0f);
+		aabb.upperBound.Set(1.0f + 0.1f * i, 1.0f);
+		proxyIds.push_back(tree.CreateProxy(aabb, NULL));
+	}
+	tree.Rebuild();
+	tree.Validate();
+	EXPECT_LE(tree.GetHeight(), 7);
+
+	b2AABB aabb;
+	aabb.lowerBound.Set(2.5f, 0.0f);
+	aabb.upperBound.Set(3.0f, 0.5f);
+	ExpectSameAsBruteForce(tree, proxyIds, aabb);
+}
+
+int
+main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,195 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "gtest/gtest.h"
+#include "Box2D/Box2D.h"
+#include "AndroidUtil/AndroidMainWrapper.h"
+
+#include <vector>
+
+// Compares the wide contact solver with the scalar one by running the same
+// scene in two worlds.
+class ContactSolverTests : public ::testing::Test {
+protected:
+	virtual void SetUp();
+	virtual void TearDown();
+
+	// Create a ground box in both worlds.
+	void CreateGround();
+	// Create a dynamic box in both worlds.
+	void CreateBox(const b2Vec2& position, float32 halfWidth,
+				   float32 halfHeight, float32 angle);
+	// Step both worlds.
+	void Step(float32 seconds);
+
+	b2World *m_scalarWorld;
+	b2World *m_wideWorld;
+	std::vector<b2Body*> m_scalarBodies;
+	std::vector<b2Body*> m_wideBodies;
+};
+
+static const float32 k_timeStep = 1.0f / 60.0f;
+
+void
+ContactSolverTests::SetUp()
+{
+	const b2Vec2 gravity(0.0f, -10.0f);
+	m_scalarWorld = new b2World(gravity);
+	m_wideWorld = new b2World(gravity);
+	m_wideWorld->SetWideContactSolver(true);
+}
+
+void
+ContactSolverTests::TearDown()
+{
+	delete m_scalarWorld;
+	delete m_wideWorld;
+}
+
+void
+ContactSolverTests::CreateGround()
+{
+	b2BodyDef bd;
+	b2PolygonShape shape;
+	shape.SetAsBox(40.0f, 1.0f, b2Vec2(0.0f, -1.0f), 0.0f);
+	m_scalarWorld->CreateBody(&bd)->CreateFixture(&shape, 0.0f);
+	m_wideWorld->CreateBody(&bd)->CreateFixture(&shape, 0.0f);
+}
+
+void
+ContactSolverTests::CreateBox(const b2Vec2& position, float32 halfWidth,
+							  float32 halfHeight, float32 angle)
+{
+	b2BodyDef bd;
+	bd.type = b2_dynamicBody;
+	bd.position = position;
+	bd.angle = angle;
+	b2PolygonShape shape;
+	shape.SetAsBox(halfWidth, halfHeight);
+	b2FixtureDef fd;
+	fd.shape = &shape;
+	fd.density = 5.0f;
+	fd.friction = 0.6f;
+
+	b2Body* scalarBody = m_scalarWorld->CreateBody(&bd);
+	scalarBody->CreateFixture(&fd);
+	m_scalarBodies.push_back(scalarBody);
+	b2Body* wideBody = m_wideWorld->CreateBody(&bd);
+	wideBody->CreateFixture(&fd);
+	m_wideBodies.push_back(wideBody);
+}
+
+void
+ContactSolverTests::Step(float32 seconds)
+{
+	for (float32 t = 0.0f; t < seconds; t += k_timeStep)
+	{
+		m_scalarWorld->Step(k_timeStep, 8, 3);
+		m_wideWorld->Step(k_timeStep, 8, 3);
+	}
+}
+
+// Boxes that only touch the ground have no constraints in common, so both
+// solvers should produce the same result.
+TEST_F(ContactSolverTests, IndependentContacts) {
+	CreateGround();
+	for (int32 i = 0; i < 10; ++i)
+	{
+		CreateBox(b2Vec2(-18.0f + 4.0f * i, 0.6f + 0.1f * i), 0.5f,
+				  0.5f + 0.05f * i, 0.02f * i);
+	}
+	Step(2.0f);
+
+	for (uint32 i = 0; i < m_scalarBodies.size(); ++i)
+	{
+		const b2Vec2& scalar = m_scalarBodies[i]->GetPosition();
+		const b2Vec2& wide = m_wideBodies[i]->GetPosition();
+		EXPECT_NEAR(scalar.x, wide.x, 1e-4f);
+		EXPECT_NEAR(scalar.y, wide.y, 1e-4f);
+		EXPECT_NEAR(m_scalarBodies[i]->GetAngle(),
+					m_wideBodies[i]->GetAngle(), 1e-4f);
+	}
+}
+
+// A pyramid of boxes should come to rest in the same place with both
+// solvers, even though they visit the constraints in a different order.
+TEST_F(ContactSolverTests, Pyramid) {
+	CreateGround();
+	const int32 rows = 15;
+	const float32 halfSize = 0.5f;
+	b2Vec2 x(-7.0f, 0.75f);
+	const b2Vec2 deltaX(0.5625f, 1.25f);
+	const b2Vec2 deltaY(1.125f, 0.0f);
+	for (int32 i = 0; i < rows; ++i)
+	{
+		b2Vec2 y = x;
+		for (int32 j = i; j < rows; ++j)
+		{
+			CreateBox(y, halfSize, halfSize, 0.0f);
+			y += deltaY;
+		}
+		x += deltaX;
+	}
+	Step(5.0f);
+
+	// The top of the pyramid hasn't fallen off in either world.
+	const float32 topHeight = halfSize + (rows - 1) * 2.0f * halfSize;
+	EXPECT_NEAR(topHeight, m_scalarBodies.back()->GetPosition().y, 0.5f);
+	EXPECT_NEAR(topHeight, m_wideBodies.back()->GetPosition().y, 0.5f);
+	for (uint32 i = 0; i < m_scalarBodies.size(); ++i)
+	{
+		const b2Vec2& scalar = m_scalarBodies[i]->GetPosition();
+		const b2Vec2& wide = m_wideBodies[i]->GetPosition();
+		EXPECT_NEAR(scalar.x, wide.x, 0.05f);
+		EXPECT_NEAR(scalar.y, wide.y, 0.05f);
+		EXPECT_NEAR(m_scalarBodies[i]->GetAngle(),
+					m_wideBodies[i]->GetAngle(), 0.05f);
+	}
+}
+
+// A tilted domino knocks over the whole row with both solvers.
+TEST_F(ContactSolverTests, Dominoes) {
+	CreateGround();
+	const int32 count = 20;
+	for (int32 i = 0; i < count; ++i)
+	{
+		CreateBox(b2Vec2(-15.0f + 1.0f * i, 1.0f), 0.1f, 1.0f,
+				  i == 0 ? -0.3f : 0.0f);
+	}
+	Step(8.0f);
+
+	for (uint32 i = 0; i < m_scalarBodies.size(); ++i)
+	{
+		// Fallen dominoes lean more than 45 degrees.
+		EXPECT_GT(b2Abs(m_scalarBodies[i]->GetAngle()), 0.25f * b2_pi);
+		EXPECT_GT(b2Abs(m_wideBodies[i]->GetAngle()), 0.25f * b2_pi);
+		EXPECT_FALSE(m_scalarBodies[i]->IsAwake() &&
+					 m_scalarBodies[i]->GetLinearVelocity().Length() > 1.0f);
+		EXPECT_FALSE(m_wideBodies[i]->IsAwake() &&
+					 m_wideBodies[i]->GetLinearVelocity().Length() > 1.0f);
+	}
+	// The last domino ends up in roughly the same place.
+	EXPECT_NEAR(m_scalarBodies.back()->GetPosition().x,
+				m_wideBodies.back()->GetPosition().x, 0.5f);
+}
+
+int
+main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
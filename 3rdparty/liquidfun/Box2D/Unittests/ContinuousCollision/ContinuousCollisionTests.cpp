@@ -0,0 +1,155 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "gtest/gtest.h"
+#include "Box2D/Box2D.h"
+#include "AndroidUtil/AndroidMainWrapper.h"
+
+static const float32 kWallX = 5.0f;
+static const float32 kTimeStep = 1.0f / 60.0f;
+// Starting this far from the wall the projectiles pass it in one step, at
+// the b2_maxTranslation limit.
+static const float32 kStartX = kWallX - 1.6f;
+static const float32 kSpeed = b2_maxTranslation / kTimeStep;
+
+class ContinuousCollisionTests : public ::testing::Test {
+protected:
+	virtual void SetUp();
+	virtual void TearDown();
+
+	// Create a small box that crosses the wall within one step, unless
+	// continuous collision stops it.
+	b2Body* CreateProjectile(float32 y, bool ccd, int32 ccdPriority);
+
+	b2World *m_world;
+};
+
+void
+ContinuousCollisionTests::SetUp()
+{
+	m_world = new b2World(b2Vec2(0.0f, 0.0f));
+
+	b2BodyDef bd;
+	b2Body* wall = m_world->CreateBody(&bd);
+	b2PolygonShape shape;
+	shape.SetAsBox(0.1f, 50.0f, b2Vec2(kWallX, 0.0f), 0.0f);
+	wall->CreateFixture(&shape, 0.0f);
+}
+
+void
+ContinuousCollisionTests::TearDown()
+{
+	delete m_world;
+}
+
+b2Body*
+ContinuousCollisionTests::CreateProjectile(float32 y, bool ccd,
+										   int32 ccdPriority)
+{
+	b2BodyDef bd;
+	bd.type = b2_dynamicBody;
+	bd.position.Set(kStartX, y);
+	bd.linearVelocity.Set(kSpeed, 0.0f);
+	bd.ccd = ccd;
+	bd.ccdPriority = ccdPriority;
+	b2Body* body = m_world->CreateBody(&bd);
+	b2PolygonShape shape;
+	shape.SetAsBox(0.2f, 0.2f);
+	body->CreateFixture(&shape, 1.0f);
+	return body;
+}
+
+TEST_F(ContinuousCollisionTests, Defaults) {
+	b2BodyDef bd;
+	EXPECT_TRUE(bd.ccd);
+	EXPECT_EQ(0, bd.ccdPriority);
+	EXPECT_EQ(0, m_world->GetTOIBudget());
+
+	b2Body* body = CreateProjectile(0.0f, true, 0);
+	EXPECT_TRUE(body->IsCCDEnabled());
+	body->SetCCDEnabled(false);
+	EXPECT_FALSE(body->IsCCDEnabled());
+	body->SetCCDPriority(2);
+	EXPECT_EQ(2, body->GetCCDPriority());
+}
+
+TEST_F(ContinuousCollisionTests, StopsAtWall) {
+	b2Body* body = CreateProjectile(0.0f, true, 0);
+	m_world->Step(kTimeStep, 8, 3);
+
+	EXPECT_LT(body->GetPosition().x, kWallX);
+	const b2Profile& profile = m_world->GetProfile();
+	EXPECT_EQ(1, profile.toiEvents);
+	EXPECT_GE(profile.toiIterations, 2);
+	EXPECT_GE(profile.toiComputations, 1);
+	EXPECT_EQ(0, profile.toiSkipped);
+}
+
+TEST_F(ContinuousCollisionTests, Disabled) {
+	b2Body* body = CreateProjectile(0.0f, false, 0);
+	m_world->Step(kTimeStep, 8, 3);
+
+	EXPECT_GT(body->GetPosition().x, kWallX);
+	EXPECT_EQ(0, m_world->GetProfile().toiEvents);
+	EXPECT_EQ(0, m_world->GetProfile().toiComputations);
+}
+
+TEST_F(ContinuousCollisionTests, Budget) {
+	static const int32 kCount = 8;
+	static const int32 kBudget = 3;
+	b2Body* bodies[kCount];
+	for (int32 i = 0; i < kCount; ++i)
+	{
+		bodies[i] = CreateProjectile(i * 2.0f, true, 0);
+	}
+	b2Body* priority = CreateProjectile(-2.0f, true, 1);
+
+	m_world->SetTOIBudget(kBudget);
+	m_world->Step(kTimeStep, 8, 3);
+
+	int32 stopped = 0;
+	for (int32 i = 0; i < kCount; ++i)
+	{
+		stopped += bodies[i]->GetPosition().x < kWallX ? 1 : 0;
+	}
+	const b2Profile& profile = m_world->GetProfile();
+	EXPECT_LT(priority->GetPosition().x, kWallX);
+	EXPECT_LE(stopped, kBudget);
+	EXPECT_LE(profile.toiEvents, kBudget + 1);
+	EXPECT_GE(profile.toiSkipped, kCount - stopped);
+
+	// Without a budget every projectile is stopped.
+	m_world->SetTOIBudget(0);
+	for (int32 i = 0; i < kCount; ++i)
+	{
+		bodies[i]->SetTransform(b2Vec2(kStartX, i * 2.0f), 0.0f);
+		bodies[i]->SetLinearVelocity(b2Vec2(kSpeed, 0.0f));
+	}
+	m_world->Step(kTimeStep, 8, 3);
+	for (int32 i = 0; i < kCount; ++i)
+	{
+		EXPECT_LT(bodies[i]->GetPosition().x, kWallX);
+	}
+	EXPECT_EQ(0, m_world->GetProfile().toiSkipped);
+}
+
+int
+main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -522,6 +522,84 @@ TEST_F(FunctionTests, CreateParticleGroupInExistingGroup) {
 	EXPECT_EQ(m_particleSystem->GetParticleGroupCount(), 1);
 }
 
+TEST_F(FunctionTests, CreateParticleGroupFromTemplate) {
+	b2CircleShape shape;
+	shape.m_radius = 0.1f;
+	b2ParticleGroupDef def;
+	def.shape = &shape;
+	def.flags = b2_viscousParticle;
+	def.color.Set(32, 25, 16, 255);
+	def.lifetime = 1.0f;
+	def.linearVelocity.Set(1.0f, 0.0f);
+	def.position.Set(0.5f, 0.25f);
+	def.angle = 0.3f;
+	b2ParticleGroup *reference = m_particleSystem->CreateParticleGroup(def);
+
+	b2ParticleGroupTemplate tmpl;
+	m_particleSystem->CreateParticleGroupTemplate(def, &tmpl);
+	EXPECT_EQ(tmpl.GetParticleCount(), reference->GetParticleCount());
+	b2ParticleGroup *group =
+		m_particleSystem->CreateParticleGroup(tmpl, def.position, def.angle);
+	ASSERT_EQ(group->GetParticleCount(), reference->GetParticleCount());
+	EXPECT_EQ(m_particleSystem->GetParticleGroupCount(), 2);
+	EXPECT_EQ(m_particleSystem->GetParticleCount(),
+			  2 * reference->GetParticleCount());
+
+	const b2Vec2 *positions = m_particleSystem->GetPositionBuffer();
+	const b2Vec2 *velocities = m_particleSystem->GetVelocityBuffer();
+	const uint32 *flags = m_particleSystem->GetFlagsBuffer();
+	const b2ParticleColor *colors = m_particleSystem->GetColorBuffer();
+	b2ParticleGroup * const *groups = m_particleSystem->GetGroupBuffer();
+	for (int32 i = 0; i < group->GetParticleCount(); i++)
+	{
+		const int32 a = reference->GetBufferIndex() + i;
+		const int32 b = group->GetBufferIndex() + i;
+		EXPECT_EQ(positions[a], positions[b]);
+		EXPECT_EQ(velocities[a], velocities[b]);
+		EXPECT_EQ(flags[a], flags[b]);
+		EXPECT_EQ(colors[a], colors[b]);
+		EXPECT_EQ(groups[b], group);
+		EXPECT_NEAR(m_particleSystem->GetParticleLifetime(a),
+					m_particleSystem->GetParticleLifetime(b),
+					m_particleSystemDef.lifetimeGranularity);
+	}
+	m_world->Step(0.001f, 1, 1);
+	EXPECT_EQ(m_particleSystem->GetParticleCount(),
+			  2 * reference->GetParticleCount());
+}
+
+// When the buffers are full the template falls back to creating particles
+// one at a time, so it must destroy the same particles as a regular group.
+TEST_F(FunctionTests, CreateParticleGroupFromTemplateAtCapacity) {
+	b2PolygonShape shape;
+	shape.SetAsBox(0.1f, 0.1f);
+	b2ParticleGroupDef def;
+	def.shape = &shape;
+	b2ParticleGroupTemplate tmpl;
+	m_particleSystem->CreateParticleGroupTemplate(def, &tmpl);
+	const int32 particleCount = tmpl.GetParticleCount();
+	ASSERT_GT(particleCount, 0);
+
+	b2ParticleSystem *system = m_world->CreateParticleSystem(
+		&m_particleSystemDef);
+	b2ParticleSystem *systems[] = { m_particleSystem, system };
+	for (int32 i = 0; i < 2; i++)
+	{
+		systems[i]->SetMaxParticleCount(particleCount + particleCount / 2);
+		systems[i]->SetDestructionByAge(true);
+	}
+	m_particleSystem->CreateParticleGroup(tmpl, b2Vec2_zero, 0);
+	b2ParticleGroup *group =
+		m_particleSystem->CreateParticleGroup(tmpl, b2Vec2(1, 0), 0);
+	system->CreateParticleGroup(def);
+	def.position.Set(1, 0);
+	b2ParticleGroup *expected = system->CreateParticleGroup(def);
+	EXPECT_EQ(group->GetParticleCount(), expected->GetParticleCount());
+	EXPECT_EQ(m_particleSystem->GetParticleCount(),
+			  system->GetParticleCount());
+	m_world->DestroyParticleSystem(system);
+}
+
 TEST_F(FunctionTests, DestroyParticleGroup) {
 	b2ParticleGroup *group = CreateBoxShapedParticleGroup(m_particleSystem);
 	group->DestroyParticles();
@@ -1648,6 +1726,59 @@ TEST_F(FunctionTests, ParticleGroupDefSetPositionColor) {
 	EXPECT_EQ(def2.color, def.color);
 }
 
+// Stages of the particle solver are only timed when enabled, and only the
+// stages that run get any time.
+TEST_F(FunctionTests, ParticleStageProfiling) {
+	b2PolygonShape shape;
+	shape.SetAsBox(0.1f, 0.1f);
+	b2ParticleGroupDef def;
+	def.shape = &shape;
+	def.flags = b2_viscousParticle;
+	m_particleSystem->CreateParticleGroup(def);
+	EXPECT_FALSE(m_particleSystem->GetStageProfiling());
+
+	static const int32 k_steps = 5;
+	for (int32 i = 0; i < k_steps; ++i)
+	{
+		m_world->Step(0.016f, 1, 1, 2);
+	}
+	EXPECT_EQ(0, m_particleSystem->GetSolveStat().GetCount());
+	for (int32 i = 0; i < b2_particleStageCount; ++i)
+	{
+		EXPECT_EQ(0.0f, m_particleSystem->GetProfile().stages[i]);
+	}
+
+	m_particleSystem->SetStageProfiling(true);
+	for (int32 i = 0; i < k_steps; ++i)
+	{
+		m_world->Step(0.016f, 1, 1, 2);
+	}
+	const b2ParticleProfile& profile = m_particleSystem->GetProfile();
+	const b2Profile& worldProfile = m_world->GetProfile();
+	EXPECT_EQ(profile.solve, worldProfile.particles.solve);
+	float32 stages = 0.0f;
+	for (int32 i = 0; i < b2_particleStageCount; ++i)
+	{
+		const b2ParticleStage stage = (b2ParticleStage)i;
+		EXPECT_EQ(profile.stages[i], worldProfile.particles.stages[i]);
+		EXPECT_EQ(k_steps, m_particleSystem->GetStageStat(stage).GetCount());
+		EXPECT_GE(m_particleSystem->GetStageStat(stage).GetMin(), 0.0f);
+		EXPECT_TRUE(b2ParticleSystem::GetStageName(stage) != NULL);
+		stages += profile.stages[i];
+	}
+	EXPECT_LE(stages, profile.solve * 1.01f);
+	EXPECT_EQ(0.0f, m_particleSystem->GetStageStat(
+		b2_particleStagePowder).GetMax());
+	EXPECT_EQ(0.0f, m_particleSystem->GetStageStat(
+		b2_particleStageWall).GetMax());
+	EXPECT_EQ(k_steps, m_particleSystem->GetSolveStat().GetCount());
+
+	m_particleSystem->ClearStageStats();
+	EXPECT_EQ(0, m_particleSystem->GetSolveStat().GetCount());
+	EXPECT_EQ(0, m_particleSystem->GetStageStat(
+		b2_particleStagePressure).GetCount());
+}
+
 TEST_F(FunctionTests, AreProxyBuffersTheSame) {
 	b2BlockAllocator blockAllocator;
 	b2GrowableBuffer<b2ParticleSystem::Proxy> a(blockAllocator);
@@ -0,0 +1,316 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "gtest/gtest.h"
+#include "Box2D/Box2D.h"
+#include "AndroidUtil/AndroidMainWrapper.h"
+
+#include <vector>
+
+// Runs every item as its own range, last item first, and cycles through the
+// thread indices. That is as different from the serial order as a real
+// thread pool could be while keeping the test single threaded.
+class ReverseTaskDispatcher : public b2TaskDispatcher
+{
+public:
+	ReverseTaskDispatcher() : m_calls(0) {}
+
+	virtual int32 GetThreadCount() const { return 3; }
+
+	virtual void ParallelFor(b2TaskFunction task, void* context, int32 count)
+	{
+		++m_calls;
+		for (int32 i = count - 1; i >= 0; --i)
+		{
+			task(context, i, i + 1, i % GetThreadCount());
+		}
+	}
+
+	int32 m_calls;
+};
+
+// Records the contact impulses reported to PostSolve and the order of the
+// other contact callbacks.
+class ContactRecorder : public b2ContactListener
+{
+public:
+	virtual void BeginContact(b2Contact* contact)
+	{
+		Record(1.0f, contact);
+	}
+
+	virtual void EndContact(b2Contact* contact)
+	{
+		Record(2.0f, contact);
+	}
+
+	virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold)
+	{
+		Record(3.0f + oldManifold->pointCount, contact);
+	}
+
+	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
+	{
+		B2_NOT_USED(contact);
+		m_normalImpulses.push_back(impulse->normalImpulses[0]);
+	}
+
+	void Record(float32 type, const b2Contact* contact)
+	{
+		m_events.push_back(type);
+		m_events.push_back(contact->GetFixtureA()->GetBody()->GetPosition().x);
+		m_events.push_back(contact->GetFixtureB()->GetBody()->GetPosition().x);
+	}
+
+	std::vector<float32> m_normalImpulses;
+	std::vector<float32> m_events;
+};
+
+// Runs the same scene in a world that solves its islands serially and in
+// one that uses a task dispatcher.
+class IslandSolverTests : public ::testing::Test {
+protected:
+	virtual void SetUp();
+	virtual void TearDown();
+
+	// Create a static ground box in both worlds.
+	void CreateGround();
+	// Create a stack of boxes in both worlds.
+	void CreateStack(float32 x, int32 count);
+	// Create a static sensor box in both worlds.
+	void CreateSensor(const b2Vec2& position, float32 halfSize);
+	// Create a chain of boxes hanging from a static anchor in both worlds.
+	void CreateChain(float32 x, int32 count);
+	// Step both worlds.
+	void Step(float32 seconds);
+	// Expect the bodies of both worlds to be in exactly the same state.
+	void ExpectSameState() const;
+
+	b2World *m_serialWorld;
+	b2World *m_parallelWorld;
+	ReverseTaskDispatcher m_dispatcher;
+	ContactRecorder m_serialRecorder;
+	ContactRecorder m_parallelRecorder;
+	std::vector<b2Body*> m_serialBodies;
+	std::vector<b2Body*> m_parallelBodies;
+};
+
+static const float32 k_timeStep = 1.0f / 60.0f;
+
+void
+IslandSolverTests::SetUp()
+{
+	const b2Vec2 gravity(0.0f, -10.0f);
+	m_serialWorld = new b2World(gravity);
+	m_serialWorld->SetContactListener(&m_serialRecorder);
+	m_parallelWorld = new b2World(gravity);
+	m_parallelWorld->SetContactListener(&m_parallelRecorder);
+	m_parallelWorld->SetTaskDispatcher(&m_dispatcher);
+}
+
+void
+IslandSolverTests::TearDown()
+{
+	delete m_serialWorld;
+	delete m_parallelWorld;
+}
+
+void
+IslandSolverTests::CreateGround()
+{
+	b2BodyDef bd;
+	b2PolygonShape shape;
+	shape.SetAsBox(60.0f, 1.0f, b2Vec2(0.0f, -1.0f), 0.0f);
+	m_serialWorld->CreateBody(&bd)->CreateFixture(&shape, 0.0f);
+	m_parallelWorld->CreateBody(&bd)->CreateFixture(&shape, 0.0f);
+}
+
+void
+IslandSolverTests::CreateStack(float32 x, int32 count)
+{
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.5f);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(x + 0.05f * i, 0.5f + 1.05f * i);
+		b2Body* serialBody = m_serialWorld->CreateBody(&bd);
+		serialBody->CreateFixture(&shape, 1.0f);
+		m_serialBodies.push_back(serialBody);
+		b2Body* parallelBody = m_parallelWorld->CreateBody(&bd);
+		parallelBody->CreateFixture(&shape, 1.0f);
+		m_parallelBodies.push_back(parallelBody);
+	}
+}
+
+void
+IslandSolverTests::CreateSensor(const b2Vec2& position, float32 halfSize)
+{
+	b2BodyDef bd;
+	bd.position = position;
+	b2PolygonShape shape;
+	shape.SetAsBox(halfSize, halfSize);
+	b2FixtureDef fd;
+	fd.shape = &shape;
+	fd.isSensor = true;
+	m_serialWorld->CreateBody(&bd)->CreateFixture(&fd);
+	m_parallelWorld->CreateBody(&bd)->CreateFixture(&fd);
+}
+
+void
+IslandSolverTests::CreateChain(float32 x, int32 count)
+{
+	b2World* worlds[] = { m_serialWorld, m_parallelWorld };
+	std::vector<b2Body*>* bodies[] = { &m_serialBodies, &m_parallelBodies };
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.125f);
+	for (int32 w = 0; w < 2; ++w)
+	{
+		b2BodyDef anchorDef;
+		anchorDef.position.Set(x, 20.0f);
+		b2Body* prev = worlds[w]->CreateBody(&anchorDef);
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(x + 0.5f + i, 20.0f);
+			b2Body* body = worlds[w]->CreateBody(&bd);
+			body->CreateFixture(&shape, 20.0f);
+			b2RevoluteJointDef jd;
+			jd.Initialize(prev, body, b2Vec2(x + i, 20.0f));
+			worlds[w]->CreateJoint(&jd);
+			bodies[w]->push_back(body);
+			prev = body;
+		}
+	}
+}
+
+void
+IslandSolverTests::Step(float32 seconds)
+{
+	for (float32 t = 0.0f; t < seconds; t += k_timeStep)
+	{
+		m_serialWorld->Step(k_timeStep, 8, 3);
+		m_parallelWorld->Step(k_timeStep, 8, 3);
+	}
+}
+
+void
+IslandSolverTests::ExpectSameState() const
+{
+	ASSERT_EQ(m_serialBodies.size(), m_parallelBodies.size());
+	for (uint32 i = 0; i < m_serialBodies.size(); ++i)
+	{
+		const b2Body* serial = m_serialBodies[i];
+		const b2Body* parallel = m_parallelBodies[i];
+		EXPECT_EQ(serial->GetPosition().x, parallel->GetPosition().x);
+		EXPECT_EQ(serial->GetPosition().y, parallel->GetPosition().y);
+		EXPECT_EQ(serial->GetAngle(), parallel->GetAngle());
+		EXPECT_EQ(serial->GetLinearVelocity().x,
+				  parallel->GetLinearVelocity().x);
+		EXPECT_EQ(serial->GetLinearVelocity().y,
+				  parallel->GetLinearVelocity().y);
+		EXPECT_EQ(serial->GetAngularVelocity(),
+				  parallel->GetAngularVelocity());
+		EXPECT_EQ(serial->IsAwake(), parallel->IsAwake());
+	}
+}
+
+// Stacks standing on a shared ground body are separate islands, so the
+// dispatcher solves them in a different order on different threads.
+TEST_F(IslandSolverTests, Stacks) {
+	CreateGround();
+	for (int32 i = 0; i < 8; ++i)
+	{
+		CreateStack(-40.0f + 10.0f * i, 1 + i);
+	}
+	Step(3.0f);
+
+	EXPECT_GT(m_dispatcher.m_calls, 0);
+	ExpectSameState();
+	// Contacts are reported in the same order with the same impulses.
+	ASSERT_EQ(m_serialRecorder.m_normalImpulses.size(),
+			  m_parallelRecorder.m_normalImpulses.size());
+	for (uint32 i = 0; i < m_serialRecorder.m_normalImpulses.size(); ++i)
+	{
+		EXPECT_EQ(m_serialRecorder.m_normalImpulses[i],
+				  m_parallelRecorder.m_normalImpulses[i]);
+	}
+}
+
+// Contacts computed ahead of the serial pass begin and end in the same
+// order, including sensor contacts and contacts of bodies woken up by
+// other contacts.
+TEST_F(IslandSolverTests, ContactEvents) {
+	CreateGround();
+	for (int32 i = 0; i < 6; ++i)
+	{
+		CreateSensor(b2Vec2(-25.0f + 10.0f * i, 4.0f), 1.5f);
+		CreateStack(-25.0f + 10.0f * i, 3 + i);
+	}
+	Step(1.0f);
+	// Drop a box on each sleeping stack.
+	for (int32 i = 0; i < 6; ++i)
+	{
+		CreateStack(-24.8f + 10.0f * i, 1);
+	}
+	Step(3.0f);
+
+	ExpectSameState();
+	EXPECT_FALSE(m_serialRecorder.m_events.empty());
+	ASSERT_EQ(m_serialRecorder.m_events.size(),
+			  m_parallelRecorder.m_events.size());
+	for (uint32 i = 0; i < m_serialRecorder.m_events.size(); ++i)
+	{
+		EXPECT_EQ(m_serialRecorder.m_events[i],
+				  m_parallelRecorder.m_events[i]);
+	}
+}
+
+// Joints to static bodies and islands falling asleep at different times.
+TEST_F(IslandSolverTests, ChainsAndSleep) {
+	CreateGround();
+	for (int32 i = 0; i < 4; ++i)
+	{
+		CreateChain(-30.0f + 15.0f * i, 4 + 2 * i);
+		CreateStack(-25.0f + 15.0f * i, 2 + i);
+	}
+	Step(2.0f);
+	ExpectSameState();
+	Step(8.0f);
+	ExpectSameState();
+}
+
+// Islands can be solved in parallel again after the dispatcher is removed.
+TEST_F(IslandSolverTests, RemoveDispatcher) {
+	CreateGround();
+	CreateStack(0.0f, 5);
+	Step(0.5f);
+	m_parallelWorld->SetTaskDispatcher(NULL);
+	const int32 calls = m_dispatcher.m_calls;
+	Step(0.5f);
+	EXPECT_EQ(calls, m_dispatcher.m_calls);
+	ExpectSameState();
+}
+
+int
+main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -18,6 +18,7 @@
 #include "gtest/gtest.h"
 #include "Box2D/Box2D.h"
 #include "AndroidUtil/AndroidMainWrapper.h"
+#include <vector>
 
 static const int kNumParticleSystems = 3;
 static const int kNumParticlesPerSystem = 3;
@@ -159,6 +160,46 @@ TEST_F(MultipleParticleSystemsTests, IdenticalSimulations) {
 	}
 }
 
+// Ensure that stepping the particle systems through a shared broad-phase
+// query gives the same result as letting each system query the world, when
+// no dynamic bodies are involved.
+TEST_F(MultipleParticleSystemsTests, SharedBroadphase) {
+	const float32 timeStep = 1.0f / 60.0f;
+	const int32 steps = 300;
+	const int32 particleCount = m_particleSystems[0]->GetParticleCount();
+
+	std::vector<b2Vec2> expected;
+	std::vector<int32> expectedContacts;
+	for (int i = 0; i < steps; ++i) {
+		m_world->Step(timeStep, 6, 2);
+	}
+	for (int j = 0; j < kNumParticleSystems; ++j) {
+		const b2Vec2* positions = m_particleSystems[j]->GetPositionBuffer();
+		expected.insert(expected.end(), positions, positions + particleCount);
+		expectedContacts.push_back(
+			m_particleSystems[j]->GetBodyContactCount());
+	}
+	delete m_world;
+
+	SetUp();
+	m_world->SetSharedParticleBroadphase(true);
+	EXPECT_TRUE(m_world->GetSharedParticleBroadphase());
+	for (int i = 0; i < steps; ++i) {
+		m_world->Step(timeStep, 6, 2);
+	}
+	for (int j = 0; j < kNumParticleSystems; ++j) {
+		ASSERT_EQ(particleCount, m_particleSystems[j]->GetParticleCount());
+		const b2Vec2* positions = m_particleSystems[j]->GetPositionBuffer();
+		for (int k = 0; k < particleCount; ++k) {
+			EXPECT_EQ(expected[j * particleCount + k], positions[k])
+				<< "Positions differ";
+		}
+		EXPECT_EQ(expectedContacts[j],
+				  m_particleSystems[j]->GetBodyContactCount());
+	}
+	delete m_world;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -0,0 +1,309 @@
+/*
+* Copyright (c) 2014 Google, Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "gtest/gtest.h"
+#include "Box2D/Box2D.h"
+#include "AndroidUtil/AndroidMainWrapper.h"
+
+#include <vector>
+
+// Saves a world, steps it, restores it and steps it again. The second run
+// should give exactly the same results as the first.
+class SnapshotTests : public ::testing::Test {
+protected:
+	virtual void SetUp();
+	virtual void TearDown();
+
+	// Create a static ground box.
+	void CreateGround();
+	// Create a stack of boxes.
+	void CreateStack(float32 x, int32 count);
+	// Create a chain of boxes hanging from a static anchor.
+	void CreateChain(float32 x, int32 count);
+	// Create a particle system with a group of particles above the ground.
+	void CreateParticles();
+	// Save the world into m_snapshot.
+	void Save();
+	// Step the world.
+	void Step(float32 seconds);
+	// Get the state of the bodies and particles.
+	std::vector<float32> GetState() const;
+
+	b2World *m_world;
+	b2ParticleSystem *m_particleSystem;
+	std::vector<b2Body*> m_bodies;
+	std::vector<uint8> m_snapshot;
+};
+
+static const float32 k_timeStep = 1.0f / 60.0f;
+
+void
+SnapshotTests::SetUp()
+{
+	const b2Vec2 gravity(0.0f, -10.0f);
+	m_world = new b2World(gravity);
+	m_particleSystem = NULL;
+}
+
+void
+SnapshotTests::TearDown()
+{
+	delete m_world;
+}
+
+void
+SnapshotTests::CreateGround()
+{
+	b2BodyDef bd;
+	b2PolygonShape shape;
+	shape.SetAsBox(30.0f, 1.0f, b2Vec2(0.0f, -1.0f), 0.0f);
+	m_world->CreateBody(&bd)->CreateFixture(&shape, 0.0f);
+}
+
+void
+SnapshotTests::CreateStack(float32 x, int32 count)
+{
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.5f);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(x + 0.05f * i, 0.5f + 1.05f * i);
+		b2Body* body = m_world->CreateBody(&bd);
+		body->CreateFixture(&shape, 1.0f);
+		m_bodies.push_back(body);
+	}
+}
+
+void
+SnapshotTests::CreateChain(float32 x, int32 count)
+{
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.125f);
+	b2BodyDef anchorDef;
+	anchorDef.position.Set(x, 15.0f);
+	b2Body* prev = m_world->CreateBody(&anchorDef);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(x + 0.5f + i, 15.0f);
+		b2Body* body = m_world->CreateBody(&bd);
+		body->CreateFixture(&shape, 20.0f);
+		b2RevoluteJointDef jd;
+		jd.Initialize(prev, body, b2Vec2(x + i, 15.0f));
+		m_world->CreateJoint(&jd);
+		m_bodies.push_back(body);
+		prev = body;
+	}
+}
+
+void
+SnapshotTests::CreateParticles()
+{
+	b2ParticleSystemDef def;
+	def.radius = 0.1f;
+	m_particleSystem = m_world->CreateParticleSystem(&def);
+	b2PolygonShape shape;
+	shape.SetAsBox(2.0f, 1.0f, b2Vec2(10.0f, 4.0f), 0.0f);
+	b2ParticleGroupDef gd;
+	gd.shape = &shape;
+	gd.flags = b2_elasticParticle;
+	gd.groupFlags = b2_solidParticleGroup;
+	m_particleSystem->CreateParticleGroup(gd);
+	// Loose particles, some of which expire after saving.
+	for (int32 i = 0; i < 50; ++i)
+	{
+		b2ParticleDef pd;
+		pd.flags = b2_waterParticle;
+		pd.position.Set(15.0f + 0.15f * (i % 10), 1.0f + 0.15f * (i / 10));
+		pd.lifetime = i % 2 ? 0.5f : 0.0f;
+		m_particleSystem->CreateParticle(pd);
+	}
+}
+
+void
+SnapshotTests::Save()
+{
+	const int32 size = m_world->SaveSnapshot(NULL, 0);
+	m_snapshot.resize(size);
+	EXPECT_EQ(size, m_world->SaveSnapshot(&m_snapshot[0], size));
+}
+
+void
+SnapshotTests::Step(float32 seconds)
+{
+	for (float32 t = 0.0f; t < seconds; t += k_timeStep)
+	{
+		m_world->Step(k_timeStep, 8, 3);
+	}
+}
+
+std::vector<float32>
+SnapshotTests::GetState() const
+{
+	std::vector<float32> state;
+	for (uint32 i = 0; i < m_bodies.size(); ++i)
+	{
+		const b2Body* body = m_bodies[i];
+		state.push_back(body->GetPosition().x);
+		state.push_back(body->GetPosition().y);
+		state.push_back(body->GetAngle());
+		state.push_back(body->GetLinearVelocity().x);
+		state.push_back(body->GetLinearVelocity().y);
+		state.push_back(body->GetAngularVelocity());
+		state.push_back(body->IsAwake() ? 1.0f : 0.0f);
+	}
+	state.push_back((float32)m_world->GetContactCount());
+	if (m_particleSystem)
+	{
+		const int32 count = m_particleSystem->GetParticleCount();
+		state.push_back((float32)count);
+		state.push_back((float32)m_particleSystem->GetParticleGroupCount());
+		const b2Vec2* positions = m_particleSystem->GetPositionBuffer();
+		const b2Vec2* velocities = m_particleSystem->GetVelocityBuffer();
+		for (int32 i = 0; i < count; ++i)
+		{
+			state.push_back(positions[i].x);
+			state.push_back(positions[i].y);
+			state.push_back(velocities[i].x);
+			state.push_back(velocities[i].y);
+		}
+	}
+	return state;
+}
+
+// Bodies resting on each other and hanging from joints continue exactly as
+// they did after saving, including the warm starting impulses.
+TEST_F(SnapshotTests, Bodies) {
+	CreateGround();
+	CreateStack(-10.0f, 6);
+	CreateStack(-5.0f, 3);
+	CreateChain(0.0f, 6);
+	Step(1.0f);
+	Save();
+	Step(2.0f);
+	const std::vector<float32> expected = GetState();
+
+	ASSERT_TRUE(m_world->RestoreSnapshot(&m_snapshot[0],
+										 (int32)m_snapshot.size()));
+	Step(2.0f);
+	EXPECT_EQ(expected, GetState());
+}
+
+// A snapshot can be restored more than once, and the state right after
+// restoring is the saved one.
+TEST_F(SnapshotTests, RestoreTwice) {
+	CreateGround();
+	CreateStack(0.0f, 4);
+	Step(0.5f);
+	const std::vector<float32> saved = GetState();
+	Save();
+	Step(1.0f);
+	const std::vector<float32> expected = GetState();
+
+	for (int32 i = 0; i < 2; ++i)
+	{
+		ASSERT_TRUE(m_world->RestoreSnapshot(&m_snapshot[0],
+											 (int32)m_snapshot.size()));
+		EXPECT_EQ(saved, GetState());
+		Step(1.0f);
+		EXPECT_EQ(expected, GetState());
+	}
+}
+
+// Particles and groups come back, including particles that were destroyed
+// after saving.
+TEST_F(SnapshotTests, Particles) {
+	CreateGround();
+	CreateStack(12.0f, 2);
+	CreateParticles();
+	Step(0.25f);
+	const int32 savedCount = m_particleSystem->GetParticleCount();
+	Save();
+	Step(1.0f);
+	const std::vector<float32> expected = GetState();
+	EXPECT_LT(m_particleSystem->GetParticleCount(), savedCount);
+
+	ASSERT_TRUE(m_world->RestoreSnapshot(&m_snapshot[0],
+										 (int32)m_snapshot.size()));
+	EXPECT_EQ(savedCount, m_particleSystem->GetParticleCount());
+	EXPECT_EQ(1, m_particleSystem->GetParticleGroupCount());
+	Step(1.0f);
+	EXPECT_EQ(expected, GetState());
+}
+
+// A particle system without particles round-trips, and particles created
+// after saving are gone after restoring.
+TEST_F(SnapshotTests, EmptyParticleSystem) {
+	CreateGround();
+	CreateStack(0.0f, 2);
+	b2ParticleSystemDef def;
+	def.radius = 0.1f;
+	m_particleSystem = m_world->CreateParticleSystem(&def);
+	Save();
+	Step(0.5f);
+	const std::vector<float32> expected = GetState();
+
+	b2ParticleDef pd;
+	pd.position.Set(5.0f, 1.0f);
+	m_particleSystem->CreateParticle(pd);
+	ASSERT_TRUE(m_world->RestoreSnapshot(&m_snapshot[0],
+										 (int32)m_snapshot.size()));
+	EXPECT_EQ(0, m_particleSystem->GetParticleCount());
+	Step(0.5f);
+	EXPECT_EQ(expected, GetState());
+}
+
+// Snapshots only fit the world they were saved from, with the same bodies,
+// fixtures, joints and particle systems.
+TEST_F(SnapshotTests, Mismatch) {
+	CreateGround();
+	CreateStack(0.0f, 2);
+	Save();
+	const int32 size = (int32)m_snapshot.size();
+
+	EXPECT_FALSE(m_world->RestoreSnapshot(&m_snapshot[0], size - 1));
+
+	b2World other(b2Vec2(0.0f, -10.0f));
+	EXPECT_FALSE(other.RestoreSnapshot(&m_snapshot[0], size));
+
+	b2BodyDef bd;
+	b2Body* body = m_world->CreateBody(&bd);
+	EXPECT_FALSE(m_world->RestoreSnapshot(&m_snapshot[0], size));
+	m_world->DestroyBody(body);
+	EXPECT_FALSE(m_world->RestoreSnapshot(&m_snapshot[0], size));
+}
+
+// Saving into a buffer that is too small reports the size needed.
+TEST_F(SnapshotTests, BufferTooSmall) {
+	CreateGround();
+	CreateStack(0.0f, 3);
+	CreateParticles();
+	const int32 size = m_world->SaveSnapshot(NULL, 0);
+	EXPECT_GT(size, 0);
+	uint8 buffer[16];
+	EXPECT_EQ(size, m_world->SaveSnapshot(buffer, sizeof(buffer)));
+}
+
+int
+main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,77 @@
+
+#include "B2Allocator.h"
+
+#include "rob/application/Game.h"
+#include "rob/Assert.h"
+#include "rob/Log.h"
+
+#include <SDL2/SDL.h>
+
+namespace duck
+{
+
+    using namespace rob;
+
+    PhysicsAllocator::PhysicsAllocator()
+        : m_alloc()
+        , m_mutex(nullptr)
+        , m_installed(false)
+    { m_mutex = ::SDL_CreateMutex(); }
+
+    PhysicsAllocator::~PhysicsAllocator()
+    {
+        Release();
+        ::SDL_DestroyMutex(m_mutex);
+    }
+
+    void PhysicsAllocator::Install(void *memory, size_t size)
+    {
+        ROB_ASSERT(!m_installed);
+        ROB_ASSERT(::b2GetNumAllocs() == 0);
+        if (memory == nullptr)
+        {
+            log::Warning("No memory for the physics allocator, using the heap");
+            size = 0;
+        }
+        m_alloc.SetMemory(memory, size);
+        ::b2SetAllocFreeCallbacks(&PhysicsAllocator::Alloc, &PhysicsAllocator::Free, this);
+        m_installed = true;
+    }
+
+    void PhysicsAllocator::Release()
+    {
+        if (!m_installed)
+            return;
+        m_alloc.Reset();
+        ::b2SetNumAllocs(0);
+        ::b2SetAllocFreeCallbacks(nullptr, nullptr, nullptr);
+        m_installed = false;
+    }
+
+    void PhysicsAllocator::ReportMemoryUsage() const
+    {
+        rob::ReportMemoryUsage("Physics", m_alloc.GetUsedSize(), m_alloc.GetTotalSize());
+        log::Info("  live:  ", m_alloc.GetAllocationCount(), " allocations, ",
+                  m_alloc.GetAllocatedSize(), " B");
+        if (m_alloc.GetHeapSize() > 0)
+            log::Info("  heap:  ", m_alloc.GetHeapSize(), " B did not fit");
+    }
+
+    void* PhysicsAllocator::Alloc(int32 size, void *callbackData)
+    {
+        PhysicsAllocator *allocator = static_cast<PhysicsAllocator*>(callbackData);
+        ::SDL_LockMutex(allocator->m_mutex);
+        void *ptr = allocator->m_alloc.Allocate(static_cast<size_t>(size));
+        ::SDL_UnlockMutex(allocator->m_mutex);
+        return ptr;
+    }
+
+    void PhysicsAllocator::Free(void *mem, void *callbackData)
+    {
+        PhysicsAllocator *allocator = static_cast<PhysicsAllocator*>(callbackData);
+        ::SDL_LockMutex(allocator->m_mutex);
+        allocator->m_alloc.Deallocate(mem);
+        ::SDL_UnlockMutex(allocator->m_mutex);
+    }
+
+} // duck
@@ -0,0 +1,49 @@
+
+#ifndef H_DUCK_B2_ALLOCATOR_H
+#define H_DUCK_B2_ALLOCATOR_H
+
+#include "rob/memory/SizeClassAllocator.h"
+#include "Box2D/Box2D.h"
+
+struct SDL_mutex;
+
+namespace duck
+{
+
+    /// Routes b2Alloc and b2Free to a size class allocator, so that all
+    /// memory of a world comes from one block and can be dropped at once.
+    class PhysicsAllocator
+    {
+    public:
+        PhysicsAllocator();
+        PhysicsAllocator(const PhysicsAllocator&) = delete;
+        PhysicsAllocator& operator = (const PhysicsAllocator&) = delete;
+        ~PhysicsAllocator();
+
+        /// Installs the b2Alloc and b2Free callbacks. Nothing may have been
+        /// allocated through b2Alloc before.
+        void Install(void *memory, rob::size_t size);
+        /// Frees everything allocated through b2Alloc at once and restores
+        /// the default callbacks. Any Box2D objects left are gone without
+        /// their destructors being called.
+        void Release();
+
+        const rob::SizeClassAllocator& GetAllocator() const
+        { return m_alloc; }
+
+        void ReportMemoryUsage() const;
+
+    private:
+        static void* Alloc(int32 size, void *callbackData);
+        static void Free(void *mem, void *callbackData);
+
+    private:
+        rob::SizeClassAllocator m_alloc;
+        // Worker threads allocate when their stack allocators overflow.
+        SDL_mutex *m_mutex;
+        bool m_installed;
+    };
+
+} // duck
+
+#endif // H_DUCK_B2_ALLOCATOR_H
@@ -0,0 +1,27 @@
+
+#include "B2TaskDispatcher.h"
+#include "rob/thread/TaskPool.h"
+
+namespace duck
+{
+
+    using namespace rob;
+
+    TaskDispatcher::TaskDispatcher(TaskPool *pool)
+        : m_pool(pool)
+    { }
+
+    TaskDispatcher::~TaskDispatcher()
+    { }
+
+    int32 TaskDispatcher::GetThreadCount() const
+    {
+        return m_pool->GetThreadCount();
+    }
+
+    void TaskDispatcher::ParallelFor(b2TaskFunction task, void* context, int32 count)
+    {
+        m_pool->ParallelFor(task, context, count);
+    }
+
+} // duck
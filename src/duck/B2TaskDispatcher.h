@@ -0,0 +1,30 @@
+
+#ifndef H_DUCK_B2_TASK_DISPATCHER_H
+#define H_DUCK_B2_TASK_DISPATCHER_H
+
+#include "Box2D/Box2D.h"
+
+namespace rob
+{
+    class TaskPool;
+} // rob
+
+namespace duck
+{
+
+    class TaskDispatcher : public b2TaskDispatcher
+    {
+    public:
+        explicit TaskDispatcher(rob::TaskPool *pool);
+        virtual ~TaskDispatcher();
+
+        int32 GetThreadCount() const;
+        void ParallelFor(b2TaskFunction task, void* context, int32 count);
+
+    private:
+        rob::TaskPool *m_pool;
+    };
+
+} // duck
+
+#endif // H_DUCK_B2_TASK_DISPATCHER_H
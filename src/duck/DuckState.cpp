@@ -1,7 +1,9 @@
 
 #include "DuckState.h"
 #include "GameState.h"
+#include "B2Allocator.h"
 #include "B2DebugDraw.h"
+#include "B2TaskDispatcher.h"
 
 #include "Logic.h"
 
@@ -44,13 +46,37 @@ namespace duck
 
     static const size_t MAX_OBJECTS = 1000;
 
+    static const size_t PHYSICS_MEMORY_SIZE = 2 * 1024 * 1024;
+
     static const float SCORE_TIME = 1.0f; // seconds
 
+    /// Resource ids used while playing, hashed at compile time.
+    static constexpr ResourceID TEX_BG         = "bg.tex";
+    static constexpr ResourceID TEX_OVEN_LIGHT = "oven_light.tex";
+    static constexpr ResourceID TEX_WHEEL      = "wheel.tex";
+    static constexpr ResourceID TEX_CONTAINER  = "container2.tex";
+    static constexpr ResourceID TEX_FLAME      = "flame.tex";
+    static constexpr ResourceID TEX_FLAME_GLOW = "flame_glow.tex";
+    static constexpr ResourceID TEX_BIRD_BODY  = "bird_body.tex";
+    static constexpr ResourceID TEX_BIRD_HEAD  = "bird_head.tex";
+    static constexpr ResourceID TEX_BIRD_NECK  = "bird_neck.tex";
+    static constexpr ResourceID TEX_BIRD_LEG   = "bird_leg.tex";
+
+    static constexpr ResourceID g_prefetchList[] = {
+        TEX_BG, TEX_OVEN_LIGHT, TEX_WHEEL, TEX_CONTAINER,
+        TEX_FLAME, TEX_FLAME_GLOW,
+        TEX_BIRD_BODY, TEX_BIRD_HEAD, TEX_BIRD_NECK, TEX_BIRD_LEG,
+        "exp_flame2.wav", "splash.wav", "wash.wav", "Powerup122.wav",
+        "kraah3.wav", "kraah2.wav", "Pickup_Coin.wav"
+    };
+
     DuckState::DuckState(GameData &gameData)
         : m_gameData(gameData)
         , m_view()
+        , m_physicsAlloc()
         , m_world(nullptr)
         , m_debugDraw(nullptr)
+        , m_taskDispatcher(nullptr)
         , m_drawBox2D(false)
         , m_inUpdate(false)
         , m_worldBody(nullptr)
@@ -71,39 +97,104 @@ namespace duck
         , m_waterSensor()
         , m_fadeEffect(Color(0.04f, 0.01f, 0.01f))
         , m_scoreTimer(0.0f)
+        , m_birdTimer(0.0f)
+        , m_birdTimerAdd(10.0f)
+        , m_wasteTimer(0.0f)
+        , m_wasteTimerAdd(8.0f)
+        , m_seed(0)
         , m_random()
+        , m_step(0)
+        , m_recorder()
     {
         m_gameData.m_birdsKilled = 0;
         m_gameData.m_birdsSaved = 0;
         m_gameData.m_score = 0;
-        m_random.Seed(GetTicks());
+        SetSeed(GetTicks());
     }
 
     DuckState::~DuckState()
     {
-        DestroyAllObjects();
-        GetAllocator().del_object(m_world);
+        if (IsHeadless())
+        {
+            DestroyAllObjects();
+            GetAllocator().del_object(m_world);
+        }
+        else
+        {
+            // Everything in the world lives in the physics memory, which is
+            // released at once instead of destroying the bodies one by one.
+            for (size_t i = 0; i < m_objectCount; i++)
+                m_objectPool.Return(m_objects[i]);
+            m_objectCount = 0;
+            m_world = nullptr;
+            // Members that hold b2Alloc'd memory must be cleared before the
+            // physics memory is dropped. Their destructors would b2Free it
+            // after Release has restored the default free.
+            m_wasteTemplate.Clear();
+            m_physicsAlloc.Release();
+        }
+        GetAllocator().del_object(m_taskDispatcher);
         GetAllocator().del_object(m_debugDraw);
-        GetAudio().StopAllSounds();
-        GetAudio().Update();
+        if (!IsHeadless())
+        {
+            GetAudio().StopAllSounds();
+            GetAudio().Update();
+            GetCache().Release(g_prefetchList, sizeof(g_prefetchList) / sizeof(g_prefetchList[0]));
+        }
+    }
+
+    void DuckState::SetSeed(uint32_t seed)
+    {
+        m_seed = seed;
+        m_random.Seed(seed);
+    }
+
+    const ResourceID* DuckState::GetPrefetchList(size_t &count) const
+    {
+        count = sizeof(g_prefetchList) / sizeof(g_prefetchList[0]);
+        return g_prefetchList;
     }
 
     bool DuckState::Initialize()
     {
+        // The objects keep their texture and sound handles, so the resources
+        // must stay loaded while the state lives.
+        if (!IsHeadless())
+            GetCache().Acquire(g_prefetchList, sizeof(g_prefetchList) / sizeof(g_prefetchList[0]));
+
         m_objectPool.SetMemory(GetAllocator().AllocateArray<GameObject>(MAX_OBJECTS), GetArraySize<GameObject>(MAX_OBJECTS));
         m_objects = GetAllocator().AllocateArray<GameObject*>(MAX_OBJECTS);
 
-        m_debugDraw = GetAllocator().new_object<DebugDraw>(&GetRenderer());
-        int32 flags = 0;
-        flags += b2Draw::e_shapeBit;
-        flags += b2Draw::e_jointBit;
-        flags += b2Draw::e_aabbBit;
-        flags += b2Draw::e_centerOfMassBit;
-        flags += b2Draw::e_particleBit;
-        m_debugDraw->SetFlags(flags);
+        m_debugDraw = IsHeadless() ? nullptr : GetAllocator().new_object<DebugDraw>(&GetRenderer());
+        if (m_debugDraw)
+        {
+            int32 flags = 0;
+            flags += b2Draw::e_shapeBit;
+            flags += b2Draw::e_jointBit;
+            flags += b2Draw::e_aabbBit;
+            flags += b2Draw::e_centerOfMassBit;
+            flags += b2Draw::e_particleBit;
+            m_debugDraw->SetFlags(flags);
+        }
 
+        // Headless sessions run side by side on different threads, so they
+        // can't share the process wide b2Alloc callbacks.
+        if (!IsHeadless())
+            m_physicsAlloc.Install(GetAllocator().Allocate(PHYSICS_MEMORY_SIZE, 16), PHYSICS_MEMORY_SIZE);
         m_world = GetAllocator().new_object<b2World>(b2Vec2(0.0, -9.81f));
         m_world->SetDebugDraw(m_debugDraw);
+        m_world->SetSeparateStaticTree(true);
+        // The waste and the bubbles share the containers.
+        m_world->SetSharedParticleBroadphase(true);
+        // Birds flung with the mouse joint can cause long TOI cascades
+        // against the slide and the walls.
+        m_world->SetTOIBudget(32);
+
+        if (!IsHeadless())
+        {
+            m_taskDispatcher = GetAllocator().new_object<TaskDispatcher>(&GetTaskPool());
+            m_world->SetTaskDispatcher(m_taskDispatcher);
+        }
 
         m_world->SetContactListener(&m_sensorListener);
 
@@ -121,6 +212,7 @@ namespace duck
         wasteDef.viscousStrength = 1.5f;
         wasteDef.ejectionStrength = 0.05f;
         m_waste = m_world->CreateParticleSystem(&wasteDef);
+        CreateWasteTemplate();
 
         b2ParticleSystemDef bubblesDef;
         bubblesDef.radius = 0.2f;
@@ -139,9 +231,19 @@ namespace duck
         m_killSensor.SetDuckState(this);
         m_waterSensor.SetDuckState(this);
 
-        m_sounds.Init(GetAudio(), GetCache());
+        if (!IsHeadless())
+            m_sounds.Init(GetAudio(), GetCache());
+
+        if (!IsHeadless() && m_gameData.m_recordFile)
+            m_recorder.Open(m_gameData.m_recordFile, m_seed);
 
         CreateWorld();
+
+        // Bake the level geometry for the particles, so they don't need
+        // to query the walls, floor and containers every substep.
+        const b2AABB levelBounds = GetStaticGeometryBounds();
+        m_waste->SetStaticDistanceField(levelBounds, wasteDef.radius);
+        m_bubbles->SetStaticDistanceField(levelBounds, bubblesDef.radius);
 //        CreateBird(vec2f::Zero);
 //        CreateBird(vec2f(-2.0f, 0.0f));
 //        CreateBird(vec2f(-1.0f, 0.0f));
@@ -152,22 +254,48 @@ namespace duck
         return true;
     }
 
+    b2AABB DuckState::GetStaticGeometryBounds() const
+    {
+        // The particle distance fields are baked up to a particle diameter and
+        // two cells away from the geometry, so the bounds are padded by more.
+        const float margin = 2.0f;
+
+        b2AABB bounds;
+        bounds.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+        bounds.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+        for (const b2Body *body = m_world->GetBodyList(); body; body = body->GetNext())
+        {
+            if (body->GetType() != b2_staticBody)
+                continue;
+            for (const b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+            {
+                if (!fixture->IsSensor())
+                    bounds.Combine(fixture->GetAABB(0));
+            }
+        }
+        bounds.lowerBound -= b2Vec2(margin, margin);
+        bounds.upperBound += b2Vec2(margin, margin);
+        return bounds;
+    }
+
     void DuckState::CreateWorld()
     {
         const float wallSize = 1.25f;
         // Conveyor belt
-        const float wheelR = 0.5f;
+        static constexpr float wheelR = 0.5f;
+        static constexpr int wheelsPerRow = 30 / int(wheelR * 2.0f);
+        vec2f wheelPositions[2 * wheelsPerRow];
+        int wheelCount = 0;
 //        for (int i = 0; i < 60 / int(wheelR * 2.0f); i++)
-        for (int i = 0; i < 30 / int(wheelR * 2.0f); i++)
+        for (int i = 0; i < wheelsPerRow; i++)
         {
-//            CreateWheel(vec2f(-30.0f + 0.25f + float(i) * 0.5f, PLAY_AREA_BOTTOM), 0.25f, 15.0f;);
-//            CreateWheel(vec2f(-30.0f + float(i) * wheelR * 2.0f, PLAY_AREA_BOTTOM), wheelR, 15.0f;);
-            CreateWheel(vec2f(-30.0f + float(i) * wheelR * 2.0f, PLAY_AREA_BOTTOM), wheelR, 5.0f);
+            wheelPositions[wheelCount++] = vec2f(-30.0f + float(i) * wheelR * 2.0f, PLAY_AREA_BOTTOM);
         }
-        for (int i = 0; i < 30 / int(wheelR * 2.0f); i++)
+        for (int i = 0; i < wheelsPerRow; i++)
         {
-            CreateWheel(vec2f(-30.0f + wheelR + float(i) * wheelR * 2.0f, PLAY_AREA_BOTTOM), wheelR, 5.0f);
+            wheelPositions[wheelCount++] = vec2f(-30.0f + wheelR + float(i) * wheelR * 2.0f, PLAY_AREA_BOTTOM);
         }
+        CreateWheels(wheelPositions, wheelCount, wheelR, 5.0f);
         // Floor
         CreateStaticBox(vec2f(-16.0f, PLAY_AREA_BOTTOM - 4.0f), 0.0f, 16.0f, 4.0f);
         // Left wall at the start of conveyor belt
@@ -213,37 +341,68 @@ namespace duck
         return object;
     }
 
-    GameObject* DuckState::CreateWheel(const vec2f &position, const float radius, const float speed)
+    void DuckState::CreateWheels(const vec2f *positions, const int count, const float radius, const float speed)
     {
-        GameObject *wheel = CreateObject();
-
-        b2BodyDef bodyDef;
-        bodyDef.type = b2_dynamicBody;
-        bodyDef.position = ToB2(position);
-        b2Body *body = m_world->CreateBody(&bodyDef);
-        wheel->SetBody(body);
-        TextureHandle texture = GetCache().GetTexture("wheel.tex");
-        wheel->SetTexture(texture);
-        wheel->SetTextureScale(1.3f);
+        // Created in one batch, so that the broad-phase is built once
+        // instead of inserting every wheel separately.
+        static const int MAX_WHEELS = 64;
+        ROB_ASSERT(count <= MAX_WHEELS);
 
         b2CircleShape shape;
         shape.m_radius = radius;
-        b2Fixture *fix = body->CreateFixture(&shape, 200.0f);
-        b2Filter filter;
-        filter.categoryBits = WheelBits;
-        filter.maskBits &= ~StaticBits;
-        filter.maskBits &= ~WheelBits;
-        fix->SetFilterData(filter);
-        fix->SetFriction(2.0f);
 
-        b2RevoluteJointDef revDef;
-        revDef.Initialize(body, m_worldBody, body->GetWorldCenter());
-        revDef.enableMotor = true;
-        revDef.motorSpeed = speed;
-        revDef.maxMotorTorque = 1000.0f;
-        m_world->CreateJoint(&revDef);
+        b2BodyDef bodyDefs[MAX_WHEELS];
+        b2FixtureDef fixtureDefs[MAX_WHEELS];
+        int32 fixtureBodies[MAX_WHEELS];
+        b2RevoluteJointDef revDefs[MAX_WHEELS];
+        b2JointDef *jointDefs[MAX_WHEELS];
+        int32 jointBodies[MAX_WHEELS];
+        for (int i = 0; i < count; i++)
+        {
+            bodyDefs[i].type = b2_dynamicBody;
+            bodyDefs[i].position = ToB2(positions[i]);
+
+            fixtureDefs[i].shape = &shape;
+            fixtureDefs[i].density = 200.0f;
+            fixtureDefs[i].friction = 2.0f;
+            fixtureDefs[i].filter.categoryBits = WheelBits;
+            fixtureDefs[i].filter.maskBits &= ~StaticBits;
+            fixtureDefs[i].filter.maskBits &= ~WheelBits;
+            fixtureBodies[i] = i;
+
+            // Same as Initialize(wheel, m_worldBody, wheel center), which
+            // needs the wheel body to exist.
+            revDefs[i].bodyB = m_worldBody;
+            revDefs[i].localAnchorB = m_worldBody->GetLocalPoint(bodyDefs[i].position);
+            revDefs[i].referenceAngle = m_worldBody->GetAngle();
+            revDefs[i].enableMotor = true;
+            revDefs[i].motorSpeed = speed;
+            revDefs[i].maxMotorTorque = 1000.0f;
+            jointDefs[i] = &revDefs[i];
+            jointBodies[i] = i;
+        }
 
-        return wheel;
+        b2BatchDef def;
+        def.bodies = bodyDefs;
+        def.bodyCount = count;
+        def.fixtures = fixtureDefs;
+        def.fixtureBodies = fixtureBodies;
+        def.fixtureCount = count;
+        def.joints = jointDefs;
+        def.jointBodiesA = jointBodies;
+        def.jointCount = count;
+
+        b2Body *bodies[MAX_WHEELS];
+        m_world->CreateBatch(&def, bodies, nullptr, nullptr);
+
+        TextureHandle texture = GetTexture(TEX_WHEEL);
+        for (int i = 0; i < count; i++)
+        {
+            GameObject *wheel = CreateObject();
+            wheel->SetBody(bodies[i]);
+            wheel->SetTexture(texture);
+            wheel->SetTextureScale(1.3f);
+        }
     }
 
     GameObject* DuckState::CreateWaterContainer(const vec2f &position, float w, float h)
@@ -277,7 +436,7 @@ namespace duck
         body->CreateFixture(&shapeRight, 1.0f);
 
         object->SetBody(body);
-        TextureHandle texture = GetCache().GetTexture("container2.tex");
+        TextureHandle texture = GetTexture(TEX_CONTAINER);
         object->SetTexture(texture);
         object->SetLayer(2);
         object->SetColor(Color(1.0f, 1.0f, 1.0f, 0.8f));
@@ -322,8 +481,8 @@ namespace duck
 
     GameObject* DuckState::CreateBird(const vec2f &position)
     {
-        TextureHandle flameTexture = GetCache().GetTexture("flame.tex");
-        TextureHandle flameGlowTexture = GetCache().GetTexture("flame_glow.tex");
+        TextureHandle flameTexture = GetTexture(TEX_FLAME);
+        TextureHandle flameGlowTexture = GetTexture(TEX_FLAME_GLOW);
 
         b2BodyDef bodyDef;
         b2CircleShape shape;
@@ -344,7 +503,7 @@ namespace duck
         body->CreateFixture(&fixDef);
 
         bird->SetBody(body);
-        TextureHandle texture = GetCache().GetTexture("bird_body.tex");
+        TextureHandle texture = GetTexture(TEX_BIRD_BODY);
         bird->SetTexture(texture);
         bird->SetFlameTexture(flameTexture);
         bird->SetFlameGlowTexture(flameGlowTexture);
@@ -365,7 +524,7 @@ namespace duck
         headBody->CreateFixture(&fixDef);
 
         head->SetBody(headBody);
-        texture = GetCache().GetTexture("bird_head.tex");
+        texture = GetTexture(TEX_BIRD_HEAD);
         head->SetTexture(texture);
         head->SetFlameTexture(flameTexture);
         head->SetFlameGlowTexture(flameGlowTexture);
@@ -376,7 +535,7 @@ namespace duck
         // Neck
         b2PolygonShape neckShape;
         neckShape.SetAsBox(0.4f, 0.25f);
-        TextureHandle neckTex = GetCache().GetTexture("bird_neck.tex");
+        TextureHandle neckTex = GetTexture(TEX_BIRD_NECK);
         const float neckJlen = 0.25f;
 
         b2RevoluteJointDef neckJoint;
@@ -441,7 +600,7 @@ namespace duck
 
         // Legs
         {
-            const TextureHandle legTex = GetCache().GetTexture("bird_leg.tex");
+            const TextureHandle legTex = GetTexture(TEX_BIRD_LEG);
             b2BodyDef legDef;
             legDef.type = b2_dynamicBody;
             legDef.position = ToB2(position - vec2f(0.5f, 0.5f));
@@ -703,7 +862,7 @@ namespace duck
             CreateBird(vec2f(PLAY_AREA_LEFT * 2.0f, PLAY_AREA_BOTTOM + 4.0f));
     }
 
-    void DuckState::CreateWaste()
+    void DuckState::CreateWasteTemplate()
     {
         b2CircleShape shape;
         shape.m_radius = 2.0f;
@@ -711,10 +870,14 @@ namespace duck
         b2ParticleGroupDef groupDef;
         groupDef.shape = &shape;
         groupDef.color.Set(32, 25, 16, 255);
-        groupDef.position.Set(PLAY_AREA_LEFT * 2.0f, 2.0f);
         groupDef.flags = b2_viscousParticle; // | b2_fixtureContactListenerParticle;
         groupDef.lifetime = 30.0f;
-        m_waste->CreateParticleGroup(groupDef);
+        m_waste->CreateParticleGroupTemplate(groupDef, &m_wasteTemplate);
+    }
+
+    void DuckState::CreateWaste()
+    {
+        m_waste->CreateParticleGroup(m_wasteTemplate, b2Vec2(PLAY_AREA_LEFT * 2.0f, 2.0f), 0.0f);
     }
 
     void DuckState::CreateBubbles(const vec2f &position, float oilyness)
@@ -745,27 +908,25 @@ namespace duck
     {
         const float deltaTime = gameTime.GetDeltaSeconds();
 
-        static float birdTimer = 0.0f;
-        static float birdTimerAdd = 10.0f;
-        birdTimer -= deltaTime;
-        if (birdTimer < 0.0f)
+        m_birdTimer -= deltaTime;
+        if (m_birdTimer < 0.0f)
         {
             NewBird();
-            birdTimer += birdTimerAdd;
-            rob::log::Info(birdTimerAdd, " ", gameTime.GetTotalSeconds());
+            m_birdTimer += m_birdTimerAdd;
+            if (!IsHeadless())
+                rob::log::Info(m_birdTimerAdd, " ", gameTime.GetTotalSeconds());
         }
-        birdTimerAdd = 10.0f - rob::Log10(gameTime.GetTotalSeconds()) * 2.0f;
+        m_birdTimerAdd = 10.0f - rob::Log10(gameTime.GetTotalSeconds()) * 2.0f;
 
-        static float wasteTimer = 0.0f;
-        static float wasteTimerAdd = 8.0f;
-        wasteTimer -= deltaTime;
-        if (wasteTimer < 0.0f)
+        m_wasteTimer -= deltaTime;
+        if (m_wasteTimer < 0.0f)
         {
             CreateWaste();
-            wasteTimer += wasteTimerAdd;
-            rob::log::Info(wasteTimerAdd, " ", gameTime.GetTotalSeconds());
+            m_wasteTimer += m_wasteTimerAdd;
+            if (!IsHeadless())
+                rob::log::Info(m_wasteTimerAdd, " ", gameTime.GetTotalSeconds());
         }
-        wasteTimerAdd = 10.0f - rob::Log10(gameTime.GetTotalSeconds());
+        m_wasteTimerAdd = 10.0f - rob::Log10(gameTime.GetTotalSeconds());
 
         if (m_scoreTimer > 0.0f)
         {
@@ -838,6 +999,10 @@ namespace duck
         if (m_splashSoundTimer > 0.0f) m_splashSoundTimer -= deltaTime;
 
         m_inUpdate = false;
+
+        if (m_recorder.IsOpen())
+            m_recorder.WriteStep(m_step, GetStateHash());
+        m_step++;
     }
 
     void DuckState::RenderGameOver()
@@ -902,7 +1067,7 @@ namespace duck
 //        renderer.DrawFilledRectangle(PLAY_AREA_LEFT, PLAY_AREA_BOTTOM, PLAY_AREA_RIGHT, PLAY_AREA_TOP);
 
         renderer.SetModel(mat4f::Identity);
-        renderer.GetGraphics()->BindTexture(0, GetCache().GetTexture("bg.tex"));
+        renderer.GetGraphics()->BindTexture(0, GetCache().GetTexture(TEX_BG));
         renderer.GetGraphics()->SetUniform(renderer.GetGlobals().texture0, 0);
         renderer.SetColor(Color(1.0f, 1.0f, 1.0f, 1.0f));
         renderer.BindTextureShader();
@@ -949,7 +1114,7 @@ namespace duck
         renderer.GetGraphics()->SetBlendAdditive();
 //        renderer.SetColor(Color(1.0f, 1.0f, 1.0f, 0.8f));
         renderer.SetColor(Color(1.0f, 1.0f, 1.0f, ovenLightAlpha));
-        renderer.GetGraphics()->BindTexture(0, GetCache().GetTexture("oven_light.tex"));
+        renderer.GetGraphics()->BindTexture(0, GetCache().GetTexture(TEX_OVEN_LIGHT));
         renderer.DrawTexturedRectangle(PLAY_AREA_LEFT, PLAY_AREA_BOTTOM, PLAY_AREA_RIGHT, PLAY_AREA_TOP);
         renderer.GetGraphics()->SetBlendAlpha();
 
@@ -987,7 +1152,7 @@ namespace duck
 
         // Draw bird heads
         {
-            const TextureHandle birdHead = GetCache().GetTexture("bird_head.tex");
+            const TextureHandle birdHead = GetCache().GetTexture(TEX_BIRD_HEAD);
             renderer.BindTextureShader();
             renderer.GetGraphics()->BindTexture(0, birdHead);
             float bhX = 10.0f;
@@ -1049,6 +1214,11 @@ namespace duck
                 ChangeState(STATE_MainMenu);
                 break;
             }
+            case Keyboard::Key::F11:
+            {
+                ToggleParticleProfiling();
+                break;
+            }
             default: break;
         }
 
@@ -1122,7 +1292,43 @@ namespace duck
 
     void DuckState::OnMouseDown(MouseButton button, int x, int y)
     {
-        m_mouseWorld = ScreenToWorld(m_view, x, y);
+        const vec2f pos = ScreenToWorld(m_view, x, y);
+        if (m_recorder.IsOpen())
+            m_recorder.WriteInput(ReplayRecord::MouseDown, m_step, int(button), pos);
+        MouseDown(button, pos);
+    }
+
+    void DuckState::OnMouseUp(MouseButton button, int x, int y)
+    {
+        const vec2f pos = ScreenToWorld(m_view, x, y);
+        if (m_recorder.IsOpen())
+            m_recorder.WriteInput(ReplayRecord::MouseUp, m_step, int(button), pos);
+        MouseUp(button, pos);
+    }
+
+    void DuckState::OnMouseMove(int x, int y)
+    {
+        const vec2f pos = ScreenToWorld(m_view, x, y);
+        if (m_recorder.IsOpen())
+            m_recorder.WriteInput(ReplayRecord::MouseMove, m_step, 0, pos);
+        MouseMove(pos);
+    }
+
+    void DuckState::ReplayInput(const ReplayRecord &record)
+    {
+        const vec2f pos(record.m_x, record.m_y);
+        switch (record.m_type)
+        {
+        case ReplayRecord::MouseDown:   MouseDown(MouseButton(record.m_value), pos); break;
+        case ReplayRecord::MouseUp:     MouseUp(MouseButton(record.m_value), pos); break;
+        case ReplayRecord::MouseMove:   MouseMove(pos); break;
+        default: break;
+        }
+    }
+
+    void DuckState::MouseDown(MouseButton button, const vec2f &pos)
+    {
+        m_mouseWorld = pos;
 
         if (IsGameOver())
             return;
@@ -1172,15 +1378,15 @@ namespace duck
         }
     }
 
-    void DuckState::OnMouseUp(MouseButton button, int x, int y)
+    void DuckState::MouseUp(MouseButton button, const vec2f &pos)
     {
         DestroyMouseJoint();
         m_washing = false;
     }
 
-    void DuckState::OnMouseMove(int x, int y)
+    void DuckState::MouseMove(const vec2f &pos)
     {
-        m_mouseWorld = ScreenToWorld(m_view, x, y);
+        m_mouseWorld = pos;
         if (m_mouseJoint)
         {
             if (g_playArea.IsInside(m_mouseWorld))
@@ -1230,4 +1436,79 @@ namespace duck
         }
     }
 
+    static uint32_t HashBytes(uint32_t hash, const void *data, size_t size)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= seed1;
+        }
+        return hash;
+    }
+
+    uint32_t DuckState::GetStateHash() const
+    {
+        uint32_t hash = seed2;
+        for (const b2Body *body = m_world->GetBodyList(); body; body = body->GetNext())
+        {
+            const b2Transform &xf = body->GetTransform();
+            const b2Vec2 &v = body->GetLinearVelocity();
+            const float32 w = body->GetAngularVelocity();
+            hash = HashBytes(hash, &xf, sizeof(xf));
+            hash = HashBytes(hash, &v, sizeof(v));
+            hash = HashBytes(hash, &w, sizeof(w));
+        }
+        for (const b2ParticleSystem *ps = m_world->GetParticleSystemList(); ps; ps = ps->GetNext())
+        {
+            const uint32_t count = uint32_t(ps->GetParticleCount());
+            hash = HashBytes(hash, &count, sizeof(count));
+            hash = HashBytes(hash, ps->GetPositionBuffer(), count * sizeof(b2Vec2));
+            hash = HashBytes(hash, ps->GetVelocityBuffer(), count * sizeof(b2Vec2));
+        }
+        return hash;
+    }
+
+    TextureHandle DuckState::GetTexture(ResourceID name)
+    { return IsHeadless() ? InvalidHandle : GetCache().GetTexture(name); }
+
+    void DuckState::ReportMemoryUsage()
+    { m_physicsAlloc.ReportMemoryUsage(); }
+
+    static void ReportParticleProfile(const char *name, const b2ParticleSystem *ps)
+    {
+        const b2Stat &solve = ps->GetSolveStat();
+        if (solve.GetCount() == 0)
+            return;
+        log::Info(name, " particles, ", solve.GetCount(), " steps, min / mean / max ms:");
+        log::Info("  solve: ", solve.GetMin(), " / ", solve.GetMean(), " / ", solve.GetMax());
+        for (int i = 0; i < b2_particleStageCount; i++)
+        {
+            const b2ParticleStage stage = static_cast<b2ParticleStage>(i);
+            const b2Stat &stat = ps->GetStageStat(stage);
+            if (stat.GetMax() <= 0.0f)
+                continue;
+            log::Info("  ", b2ParticleSystem::GetStageName(stage), ": ",
+                      stat.GetMin(), " / ", stat.GetMean(), " / ", stat.GetMax());
+        }
+    }
+
+    void DuckState::ToggleParticleProfiling()
+    {
+        const bool enable = !m_waste->GetStageProfiling();
+        if (!enable)
+        {
+            ReportParticleProfile("Waste", m_waste);
+            ReportParticleProfile("Bubble", m_bubbles);
+        }
+        else
+        {
+            log::Info("Particle profiling started");
+        }
+        m_waste->ClearStageStats();
+        m_waste->SetStageProfiling(enable);
+        m_bubbles->ClearStageStats();
+        m_bubbles->SetStageProfiling(enable);
+    }
+
 } // duck
@@ -8,10 +8,12 @@
 #include "rob/memory/Pool.h"
 #include "rob/math/Random.h"
 
+#include "B2Allocator.h"
 #include "GameData.h"
 #include "GameObject.h"
 #include "Sensors.h"
 #include "FadeEffect.h"
+#include "Replay.h"
 #include "SoundPlayer.h"
 
 namespace duck
@@ -21,6 +23,7 @@ namespace duck
     using rob::GameTime;
 
     class DebugDraw;
+    class TaskDispatcher;
 
     class DuckState : public rob::GameState
     {
@@ -28,12 +31,17 @@ namespace duck
         DuckState(GameData &gameData);
         ~DuckState();
 
+        /// Seeds the random generator. Must be called before Initialize.
+        void SetSeed(rob::uint32_t seed);
+
+        const rob::ResourceID* GetPrefetchList(rob::size_t &count) const override;
         bool Initialize() override;
         void CreateWorld();
+        b2AABB GetStaticGeometryBounds() const;
 
         GameObject* CreateObject(GameObject *prevLink = nullptr);
         GameObject* CreateStaticBox(const vec2f &position, float angle, float w, float h);
-        GameObject* CreateWheel(const vec2f &position, const float radius, const float speed);
+        void CreateWheels(const vec2f *positions, const int count, const float radius, const float speed);
         GameObject* CreateWaterContainer(const vec2f &position, float w, float h);
         GameObject* CreateBird(const vec2f &position);
         void CreateOven();
@@ -61,6 +69,7 @@ namespace duck
         void RealtimeUpdate(const Time_t deltaMicroseconds) override;
 
         void NewBird();
+        void CreateWasteTemplate();
         void CreateWaste();
         void CreateBubbles(const vec2f &position, float oilyness);
 
@@ -76,13 +85,34 @@ namespace duck
         void OnMouseUp(rob::MouseButton button, int x, int y) override;
         void OnMouseMove(int x, int y) override;
 
+        void MouseDown(rob::MouseButton button, const vec2f &pos);
+        void MouseUp(rob::MouseButton button, const vec2f &pos);
+        void MouseMove(const vec2f &pos);
+
+        /// Feeds a recorded input to the state, see ReplayRecord.
+        void ReplayInput(const ReplayRecord &record);
+        /// Hashes the positions and velocities of all bodies and particles.
+        rob::uint32_t GetStateHash() const;
+
+        void ReportMemoryUsage() override;
+        /// Starts timing the particle solver stages, or reports the times
+        /// and stops if already started.
+        void ToggleParticleProfiling();
+
+    private:
+        /// Returns InvalidHandle when headless.
+        rob::TextureHandle GetTexture(rob::ResourceID name);
+
     private:
         GameData &m_gameData;
         rob::View m_view;
+        PhysicsAllocator m_physicsAlloc;
         b2World *m_world;
         b2ParticleSystem *m_waste;
         b2ParticleSystem *m_bubbles;
+        b2ParticleGroupTemplate m_wasteTemplate;
         DebugDraw *m_debugDraw;
+        TaskDispatcher *m_taskDispatcher;
         bool m_drawBox2D;
 
         bool m_inUpdate;
@@ -115,8 +145,17 @@ namespace duck
         float m_scoreTimer;
         int m_lastPoints;
 
+        float m_birdTimer;
+        float m_birdTimerAdd;
+        float m_wasteTimer;
+        float m_wasteTimerAdd;
+
         SoundPlayer m_sounds;
+        rob::uint32_t m_seed;
         rob::Random m_random;
+
+        rob::uint32_t m_step;
+        ReplayWriter m_recorder;
     };
 
 } // duck
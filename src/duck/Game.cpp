@@ -249,6 +249,8 @@ namespace duck
                 }
                 m_textW *= 0.5f;
             }
+            // The world is built while the player reads the brief.
+            PrepareState(STATE_Game);
             return true;
         }
 
@@ -309,6 +311,14 @@ namespace duck
     };
 
 
+    Game::Game()
+        : rob::Game()
+        , m_gameData()
+    { }
+
+    void Game::SetRecordFile(const char *filename)
+    { m_gameData.m_recordFile = filename; }
+
     bool Game::Initialize()
     {
         std::srand(std::time(0));
@@ -329,6 +339,9 @@ namespace duck
 
     void Game::HandleStateChange(int state)
     {
+        if (ChangeToPreparedState(state))
+            return;
+
         switch (state)
         {
         case STATE_NoChange:    break;
@@ -343,4 +356,15 @@ namespace duck
         }
     }
 
+    void Game::HandleStatePrepare(int state)
+    {
+        switch (state)
+        {
+        case STATE_Game:        PrepareState<DuckState>(STATE_Game, m_gameData); break;
+        default:
+            rob::log::Error("Invalid state to prepare (", state, ")");
+            break;
+        }
+    }
+
 } // duck
@@ -12,9 +12,15 @@ namespace duck
     class Game : public rob::Game
     {
     public:
+        Game();
         bool Initialize() override;
+
+        /// Records game sessions to the given replay file. Each new session
+        /// overwrites the previous one.
+        void SetRecordFile(const char *filename);
     protected:
         void HandleStateChange(int state) override;
+        void HandleStatePrepare(int state) override;
     private:
         GameData m_gameData;
     };
@@ -13,6 +13,8 @@ namespace duck
         int             m_birdsSaved;
         int             m_score;
         HighScoreList   m_highScores;
+        /// When set, every game session is recorded to this replay file.
+        const char     *m_recordFile;
     };
 
 } // duck
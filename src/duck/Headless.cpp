@@ -0,0 +1,122 @@
+
+#include "Headless.h"
+#include "DuckState.h"
+#include "Replay.h"
+
+#include "rob/time/MicroTicker.h"
+#include "rob/Log.h"
+
+#include <fstream>
+
+namespace duck
+{
+
+    using namespace rob;
+
+    static const size_t SESSION_MEMORY_SIZE = 2 * 1024 * 1024;
+
+    HeadlessHost::HeadlessHost(size_t sessionCount)
+        : rob::HeadlessHost((sessionCount < MAX_SESSIONS) ? sessionCount : MAX_SESSIONS,
+                            SESSION_MEMORY_SIZE)
+        , m_gameData()
+    { }
+
+    GameState* HeadlessHost::CreateSession(LinearAllocator &alloc, size_t index)
+    {
+        DuckState *state = alloc.new_object<DuckState>(m_gameData[index]);
+        state->OnResize(800, 600);
+        return state;
+    }
+
+    bool RunReplay(const char *replayFile, const char *timingFile)
+    {
+        ReplayReader reader;
+        if (!reader.Open(replayFile))
+            return false;
+
+        std::ofstream timing;
+        if (timingFile)
+        {
+            timing.open(timingFile);
+            if (timing.is_open())
+                timing << "step,microseconds,hash\n";
+            else
+                log::Warning("Could not open timing file: ", timingFile);
+        }
+
+        GameData gameData = GameData();
+        LinearAllocator alloc(SESSION_MEMORY_SIZE);
+        DuckState *state = alloc.new_object<DuckState>(gameData);
+        state->SetSeed(reader.GetSeed());
+        state->SetAllocator(alloc);
+        state->OnResize(800, 600);
+        if (!state->Initialize())
+        {
+            log::Error("Could not initialize replay session");
+            alloc.del_object(state);
+            return false;
+        }
+
+        MicroTicker ticker;
+        ticker.Init();
+
+        uint32_t step = 0;
+        uint32_t diverged = 0;
+        bool inSync = true;
+        Time_t totalTime = 0, minTime = ~Time_t(0), maxTime = 0;
+
+        ReplayRecord record;
+        while (reader.Read(record))
+        {
+            if (record.m_type != ReplayRecord::Step)
+            {
+                state->ReplayInput(record);
+                continue;
+            }
+            if (record.m_step != step)
+            {
+                log::Error("Corrupt replay, expected step ", step, " but got ", record.m_step);
+                break;
+            }
+
+            const Time_t start = ticker.GetTicks();
+            state->DoFixedUpdate();
+            const Time_t time = ticker.GetTicks() - start;
+
+            const uint32_t hash = state->GetStateHash();
+            if (inSync && hash != record.m_value)
+            {
+                log::Error("Replay diverged at step ", step);
+                diverged = step;
+                inSync = false;
+            }
+            if (timing.is_open())
+                timing << step << ',' << time << ',' << hash << '\n';
+
+            totalTime += time;
+            minTime = (time < minTime) ? time : minTime;
+            maxTime = (time > maxTime) ? time : maxTime;
+            step++;
+        }
+
+        alloc.del_object(state);
+
+        if (step == 0)
+        {
+            log::Warning("Replay had no steps: ", replayFile);
+            return false;
+        }
+
+        const double seconds = double(totalTime) / 1e6;
+        log::Info("Replayed ", step, " steps in ", seconds, " s, ",
+                  (seconds > 0.0) ? double(step) / seconds : 0.0, " steps per second");
+        log::Info("Step time in microseconds (min / mean / max): ",
+                  minTime, " / ", totalTime / step, " / ", maxTime);
+        if (inSync)
+            log::Info("World state matched the recording on every step");
+        else
+            log::Info("World state diverged from the recording at step ", diverged);
+        return inSync;
+    }
+
+} // duck
@@ -0,0 +1,35 @@
+
+#ifndef H_DUCK_HEADLESS_H
+#define H_DUCK_HEADLESS_H
+
+#include "rob/application/HeadlessHost.h"
+#include "GameData.h"
+
+namespace duck
+{
+
+    /// Runs many game sessions without graphics or audio, for measuring how
+    /// the simulation scales.
+    class HeadlessHost : public rob::HeadlessHost
+    {
+    public:
+        static const rob::size_t MAX_SESSIONS = 64;
+
+        explicit HeadlessHost(rob::size_t sessionCount);
+
+    protected:
+        rob::GameState* CreateSession(rob::LinearAllocator &alloc, rob::size_t index) override;
+
+    private:
+        GameData m_gameData[MAX_SESSIONS];
+    };
+
+    /// Runs a recorded game session again as fast as possible without
+    /// graphics or audio. Checks the world state hash after every step
+    /// against the recorded one and writes the time taken by every step
+    /// to the timing file, if one is given.
+    bool RunReplay(const char *replayFile, const char *timingFile);
+
+} // duck
+
+#endif // H_DUCK_HEADLESS_H
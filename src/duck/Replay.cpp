@@ -0,0 +1,94 @@
+
+#include "Replay.h"
+
+#include "rob/math/Vector2.h"
+#include "rob/Log.h"
+
+namespace duck
+{
+
+    static const uint32_t REPLAY_MAGIC = 0x50455244; // "DREP"
+    static const uint32_t REPLAY_VERSION = 1;
+
+    bool ReplayWriter::Open(const char *filename, uint32_t seed)
+    {
+        Close();
+        m_out.open(filename, std::ios::binary | std::ios::trunc);
+        if (!m_out.is_open())
+        {
+            rob::log::Error("Could not open replay file for writing: ", filename);
+            return false;
+        }
+        const uint32_t header[] = { REPLAY_MAGIC, REPLAY_VERSION, seed };
+        m_out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        rob::log::Info("Recording replay to ", filename, " with seed ", seed);
+        return true;
+    }
+
+    void ReplayWriter::Close()
+    {
+        if (m_out.is_open())
+            m_out.close();
+    }
+
+    bool ReplayWriter::IsOpen() const
+    { return m_out.is_open(); }
+
+    void ReplayWriter::WriteInput(ReplayRecord::Type type, uint32_t step, int button, const vec2f &pos)
+    {
+        ReplayRecord record;
+        record.m_type = type;
+        record.m_step = step;
+        record.m_value = uint32_t(button);
+        record.m_x = pos.x;
+        record.m_y = pos.y;
+        Write(record);
+    }
+
+    void ReplayWriter::WriteStep(uint32_t step, uint32_t stateHash)
+    {
+        ReplayRecord record;
+        record.m_type = ReplayRecord::Step;
+        record.m_step = step;
+        record.m_value = stateHash;
+        record.m_x = record.m_y = 0.0f;
+        Write(record);
+    }
+
+    void ReplayWriter::Write(const ReplayRecord &record)
+    {
+        m_out.write(reinterpret_cast<const char*>(&record), sizeof(ReplayRecord));
+    }
+
+    bool ReplayReader::Open(const char *filename)
+    {
+        m_in.open(filename, std::ios::binary);
+        if (!m_in.is_open())
+        {
+            rob::log::Error("Could not open replay file: ", filename);
+            return false;
+        }
+
+        uint32_t header[3];
+        m_in.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!m_in || header[0] != REPLAY_MAGIC)
+        {
+            rob::log::Error("Not a replay file: ", filename);
+            return false;
+        }
+        if (header[1] != REPLAY_VERSION)
+        {
+            rob::log::Error("Unsupported replay version ", header[1], ": ", filename);
+            return false;
+        }
+        m_seed = header[2];
+        return true;
+    }
+
+    bool ReplayReader::Read(ReplayRecord &record)
+    {
+        m_in.read(reinterpret_cast<char*>(&record), sizeof(ReplayRecord));
+        return bool(m_in);
+    }
+
+} // duck
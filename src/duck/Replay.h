@@ -0,0 +1,69 @@
+
+#ifndef H_DUCK_REPLAY_H
+#define H_DUCK_REPLAY_H
+
+#include "rob/math/Types.h"
+#include "rob/Types.h"
+
+#include <fstream>
+
+namespace duck
+{
+
+    using rob::uint32_t;
+    using rob::vec2f;
+
+    /// One entry of a replay file. Inputs are stamped with the index of the
+    /// fixed step they happened before, and every step is followed by a step
+    /// entry holding the world state hash after it.
+    struct ReplayRecord
+    {
+        enum Type
+        {
+            Step,
+            MouseDown,
+            MouseUp,
+            MouseMove
+        };
+
+        uint32_t m_type;
+        uint32_t m_step;
+        uint32_t m_value;   // Mouse button or world state hash
+        float m_x, m_y;     // Mouse position in world coordinates
+    };
+
+    class ReplayWriter
+    {
+    public:
+        /// Starts a new replay file of a session with the given random seed.
+        bool Open(const char *filename, uint32_t seed);
+        void Close();
+        bool IsOpen() const;
+
+        void WriteInput(ReplayRecord::Type type, uint32_t step, int button, const vec2f &pos);
+        void WriteStep(uint32_t step, uint32_t stateHash);
+
+    private:
+        void Write(const ReplayRecord &record);
+
+    private:
+        std::ofstream m_out;
+    };
+
+    class ReplayReader
+    {
+    public:
+        bool Open(const char *filename);
+        uint32_t GetSeed() const { return m_seed; }
+
+        /// Returns false at the end of the file.
+        bool Read(ReplayRecord &record);
+
+    private:
+        std::ifstream m_in;
+        uint32_t m_seed;
+    };
+
+} // duck
+
+#endif // H_DUCK_REPLAY_H
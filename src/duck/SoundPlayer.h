@@ -82,6 +82,7 @@ namespace duck
     private:
         void PlaySound(SoundHandle sound, float volume, const vec2f &pos)
         {
+            if (!m_audio) return; // Headless
             float x = pos.x * PositionScale;
             float y = pos.y * PositionScale;
             m_audio->PlaySound(sound, volume, x, y, m_currentTime);
@@ -6,6 +6,7 @@
 #include "../audio/AudioSystem.h"
 #include "../resource/MasterCache.h"
 #include "../renderer/Renderer.h"
+#include "../thread/TaskPool.h"
 
 #include "../Log.h"
 
@@ -14,7 +15,11 @@
 namespace rob
 {
 
-    static const size_t STATIC_MEMORY_SIZE = 4 * 1024 * 1024;
+    /// The memory left after the systems is split between the current and
+    /// the prepared state.
+    static const size_t STATIC_MEMORY_SIZE = 10 * 1024 * 1024;
+    /// Microseconds per frame for uploading resources loaded in the background.
+    static const Time_t RESOURCE_UPLOAD_BUDGET = 2000;
 
     Game::Game()
         : m_staticAlloc(STATIC_MEMORY_SIZE)
@@ -23,8 +28,13 @@ namespace rob
         , m_audio(nullptr)
         , m_cache(nullptr)
         , m_renderer(nullptr)
+        , m_taskPool(nullptr)
         , m_state(nullptr)
-        , m_stateAlloc()
+        , m_preparedState(nullptr)
+        , m_preparedStateId(0)
+        , m_stateAllocs()
+        , m_stateAlloc(&m_stateAllocs[0])
+        , m_preparedAlloc(&m_stateAllocs[1])
     {
         ::SDL_Init(SDL_INIT_EVERYTHING);
 
@@ -33,18 +43,23 @@ namespace rob
         m_audio = m_staticAlloc.new_object<AudioSystem>(m_staticAlloc);
         m_cache = m_staticAlloc.new_object<MasterCache>(m_graphics, m_audio, m_staticAlloc);
         m_renderer = m_staticAlloc.new_object<Renderer>(m_graphics, m_cache, m_staticAlloc);
+        m_taskPool = m_staticAlloc.new_object<TaskPool>();
 
         log::Info("GL debug output: ", (m_graphics->HasDebugOutput()?"yes":"no"));
 
         const size_t freeMemory = STATIC_MEMORY_SIZE - m_staticAlloc.GetAllocatedSize();
         log::Info("Static memory used: ", m_staticAlloc.GetAllocatedSize(), " B from ",
                   STATIC_MEMORY_SIZE, " B total", " (", freeMemory ," B free)");
-        m_stateAlloc.SetMemory(m_staticAlloc.Allocate(freeMemory), freeMemory);
+        const size_t stateMemory = freeMemory / 2;
+        m_stateAllocs[0].SetMemory(m_staticAlloc.Allocate(stateMemory), stateMemory);
+        m_stateAllocs[1].SetMemory(m_staticAlloc.Allocate(stateMemory), stateMemory);
     }
 
     Game::~Game()
     {
-        m_stateAlloc.del_object(m_state);
+        DiscardPreparedState();
+        m_stateAlloc->del_object(m_state);
+        m_staticAlloc.del_object(m_taskPool);
         m_staticAlloc.del_object(m_renderer);
         m_staticAlloc.del_object(m_cache);
         m_staticAlloc.del_object(m_audio);
@@ -76,18 +91,55 @@ namespace rob
         return true;
     }
 
-    void Game::InitState()
+    void Game::InitState(GameState *state, LinearAllocator &alloc)
     {
-        m_state->SetAllocator(m_stateAlloc);
-        m_state->SetAudio(m_audio);
-        m_state->SetCache(m_cache);
-        m_state->SetRenderer(m_renderer);
-        m_state->SetWindow(m_window);
-        m_state->Initialize();
+        state->SetAllocator(alloc);
+        state->SetAudio(m_audio);
+        state->SetCache(m_cache);
+        state->SetRenderer(m_renderer);
+        state->SetTaskPool(m_taskPool);
+        state->SetWindow(m_window);
 
+        size_t prefetchCount = 0;
+        const ResourceID *prefetch = state->GetPrefetchList(prefetchCount);
+        m_cache->Prefetch(prefetch, prefetchCount);
+
+        state->Initialize();
+
+        int w, h;
+        m_window->GetSize(&w, &h);
+        state->Resize(w, h);
+    }
+
+    bool Game::ChangeToPreparedState(int state)
+    {
+        if (!m_preparedState || m_preparedStateId != state)
+            return false;
+
+        m_stateAlloc->del_object(m_state);
+        m_stateAlloc->Reset();
+
+        LinearAllocator *alloc = m_stateAlloc;
+        m_stateAlloc = m_preparedAlloc;
+        m_preparedAlloc = alloc;
+
+        m_state = m_preparedState;
+        m_preparedState = nullptr;
+        m_preparedStateId = 0;
+
+        // The window may have been resized after the state was prepared.
         int w, h;
         m_window->GetSize(&w, &h);
         OnResize(w, h);
+        return true;
+    }
+
+    void Game::DiscardPreparedState()
+    {
+        m_preparedAlloc->del_object(m_preparedState);
+        m_preparedAlloc->Reset();
+        m_preparedState = nullptr;
+        m_preparedStateId = 0;
     }
 
     void Game::Run()
@@ -100,6 +152,7 @@ namespace rob
             m_graphics->Clear();
 
             m_audio->Update();
+            m_cache->Update(RESOURCE_UPLOAD_BUDGET);
 
             m_state->DoUpdate();
             m_state->DoRender();
@@ -109,6 +162,8 @@ namespace rob
             if (m_state->IsQuiting())
                 break;
 
+            if (const int state = m_state->TakePrepareState())
+                HandleStatePrepare(state);
             HandleStateChange(m_state->NextState());
         }
     }
@@ -128,10 +183,10 @@ namespace rob
         kB -= MB * 1024;
     }
 
-    void ReportMemoryUsage(const size_t used, const size_t total)
+    void ReportMemoryUsage(const char *title, const size_t used, const size_t total)
     {
         const size_t free = total - used;
-        log::Info("State memory usage:");
+        log::Info(title, " memory usage:");
         size_t MB, kB, B;
         Memory(used, MB, kB, B);
         log::Info("  used:  ", MB, " MB ", kB, " kB ", B, " B");
@@ -144,7 +199,12 @@ namespace rob
     void Game::OnKeyPress(Keyboard::Key key, Keyboard::Scancode scancode, uint32_t mods)
     {
         if (key == Keyboard::Key::F12)
-            ReportMemoryUsage(m_stateAlloc.GetAllocatedSize(), m_stateAlloc.GetTotalSize());
+        {
+            ReportMemoryUsage("State", m_stateAlloc->GetAllocatedSize(), m_stateAlloc->GetTotalSize());
+            if (m_preparedState)
+                ReportMemoryUsage("Prepared state", m_preparedAlloc->GetAllocatedSize(), m_preparedAlloc->GetTotalSize());
+            m_state->ReportMemoryUsage();
+        }
         m_state->OnKeyPress(key, scancode, mods);
     }
 
@@ -14,8 +14,12 @@ namespace rob
     class AudioSystem;
     class MasterCache;
     class Renderer;
+    class TaskPool;
     class GameState;
 
+    /// Logs the used, free and total size of a block of memory.
+    void ReportMemoryUsage(const char *title, const size_t used, const size_t total);
+
     class Game
     {
     public:
@@ -39,19 +43,40 @@ namespace rob
 
     protected:
         virtual void HandleStateChange(int state) { }
+        /// Gets called when the current state asks for a state to be prepared,
+        /// see GameState::PrepareState and Game::PrepareState.
+        virtual void HandleStatePrepare(int state) { }
 
         template <class State, class... Args>
         void ChangeState(Args&& ...args)
         {
-            m_stateAlloc.del_object(m_state);
-            m_stateAlloc.Reset();
-            m_state = m_stateAlloc.new_object<State>(std::forward<Args&&>(args)...);
-            InitState();
+            DiscardPreparedState();
+            m_stateAlloc->del_object(m_state);
+            m_stateAlloc->Reset();
+            m_state = m_stateAlloc->new_object<State>(std::forward<Args&&>(args)...);
+            InitState(m_state, *m_stateAlloc);
+        }
+
+        /// Constructs and initializes a state in the second state memory, while
+        /// the current state keeps running. ChangeToPreparedState then makes it
+        /// the current state without constructing or initializing it again.
+        template <class State, class... Args>
+        void PrepareState(int state, Args&& ...args)
+        {
+            DiscardPreparedState();
+            m_preparedState = m_preparedAlloc->new_object<State>(std::forward<Args&&>(args)...);
+            m_preparedStateId = state;
+            InitState(m_preparedState, *m_preparedAlloc);
         }
 
+        /// Destroys the current state and makes the state prepared for the
+        /// state id current. Returns false if no state was prepared for it.
+        bool ChangeToPreparedState(int state);
+        void DiscardPreparedState();
+
     private:
         bool Setup();
-        void InitState();
+        void InitState(GameState *state, LinearAllocator &alloc);
 
     protected:
         LinearAllocator m_staticAlloc;
@@ -60,9 +85,16 @@ namespace rob
         AudioSystem *m_audio;
         MasterCache *m_cache;
         Renderer *m_renderer;
+        TaskPool *m_taskPool;
 
         GameState *m_state;
-        LinearAllocator m_stateAlloc;
+        GameState *m_preparedState;
+        int m_preparedStateId;
+        /// The current and the prepared state use one of the allocators each,
+        /// and swap them when the prepared state becomes current.
+        LinearAllocator m_stateAllocs[2];
+        LinearAllocator *m_stateAlloc;
+        LinearAllocator *m_preparedAlloc;
     };
 
 } // rob
@@ -16,10 +16,14 @@ namespace rob
         , m_time(m_ticker)
         , m_gameTime()
         , m_alloc(nullptr)
+        , m_audio(nullptr)
         , m_cache(nullptr)
         , m_renderer(nullptr)
+        , m_taskPool(nullptr)
+        , m_window(nullptr)
         , m_quit(false)
         , m_nextState(0)
+        , m_prepareState(0)
         , m_fps(0)
         , m_frames(0)
         , m_lastTime(0)
@@ -51,6 +55,12 @@ namespace rob
         }
     }
 
+    void GameState::DoFixedUpdate()
+    {
+        m_gameTime.ForceStep();
+        Update(m_gameTime);
+    }
+
     void GameState::DoRender()
     {
         if (m_time.IsPaused())
@@ -20,6 +20,8 @@ namespace rob
     class LinearAllocator;
     class AudioSystem;
     class MasterCache;
+    class ResourceID;
+    class TaskPool;
 //    class Renderer;
     class Window;
 
@@ -43,6 +45,9 @@ namespace rob
         void SetRenderer(Renderer *renderer) { m_renderer = renderer; }
         Renderer& GetRenderer() { return *m_renderer; }
 
+        void SetTaskPool(TaskPool *taskPool) { m_taskPool = taskPool; }
+        TaskPool& GetTaskPool() { return *m_taskPool; }
+
         void SetWindow(Window *window) { m_window = window; }
         Window& GetWindow() { return *m_window; }
 
@@ -52,9 +57,25 @@ namespace rob
         void DoUpdate();
         /// Gets called from Game. Calls virtual method Render.
         void DoRender();
+        /// Gets called from HeadlessHost. Calls virtual method Update once
+        /// with the fixed time step, regardless of the real time.
+        void DoFixedUpdate();
+
+        /// A headless state has no window, renderer, audio or resource cache
+        /// and no task pool, see HeadlessHost.
+        bool IsHeadless() const { return m_renderer == nullptr; }
 
         void Resize(int w, int h);
 
+        /// Gets called from Game after reporting the state memory usage, for
+        /// reporting memory the state manages itself.
+        virtual void ReportMemoryUsage() { }
+
+
+        /// Returns the textures and sounds that Game requests from the cache
+        /// before Initialize, so that they load in the background.
+        virtual const ResourceID* GetPrefetchList(size_t &count) const
+        { count = 0; return nullptr; }
 
         virtual bool Initialize() { return true; }
 
@@ -81,6 +102,17 @@ namespace rob
         void ChangeState(int state) { m_nextState = state; }
         int NextState() const { return m_nextState; }
 
+        /// Asks Game to construct and initialize the state while this state
+        /// keeps running, so that a later ChangeState to it is fast.
+        void PrepareState(int state) { m_prepareState = state; }
+        /// Gets called from Game. Returns the state asked by PrepareState once.
+        int TakePrepareState()
+        {
+            const int state = m_prepareState;
+            m_prepareState = 0;
+            return state;
+        }
+
     private:
         MicroTicker m_ticker;
     protected:
@@ -92,9 +124,11 @@ namespace rob
         AudioSystem *       m_audio;
         MasterCache *       m_cache;
         Renderer *          m_renderer;
+        TaskPool *          m_taskPool;
         Window *            m_window;
         bool m_quit;
         int m_nextState;
+        int m_prepareState;
 
         View m_defaultView;
 
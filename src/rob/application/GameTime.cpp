@@ -26,6 +26,9 @@ namespace rob
         return false;
     }
 
+    void GameTime::ForceStep()
+    { m_time += m_deltaTime; }
+
     Time_t GameTime::GetDeltaMicroseconds() const
     { return m_deltaTime; }
 
@@ -13,6 +13,8 @@ namespace rob
         GameTime();
         void Update(const Time_t frameTime);
         bool Step();
+        /// Takes a step without using the accumulated frame time.
+        void ForceStep();
         Time_t GetDeltaMicroseconds() const;
         double GetDeltaSeconds() const;
         Time_t GetTotalMicroseconds() const;
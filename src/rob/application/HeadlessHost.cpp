@@ -0,0 +1,100 @@
+
+#include "HeadlessHost.h"
+#include "GameState.h"
+
+#include "../memory/PtrAlign.h"
+#include "../Log.h"
+
+#include <algorithm>
+
+namespace rob
+{
+
+    HeadlessHost::HeadlessHost(size_t sessionCount, size_t sessionMemory)
+        : m_taskPool()
+        , m_sessions(nullptr)
+        , m_sessionCount(sessionCount)
+        , m_sessionMemory(sessionMemory)
+        , m_step(0)
+    { }
+
+    HeadlessHost::~HeadlessHost()
+    { }
+
+    void HeadlessHost::Run(const int stepCount)
+    {
+        const size_t alignment = 16;
+        const size_t sessionSize = align(m_sessionMemory, alignment) + alignment +
+            GetArraySize<uint32_t>(stepCount);
+        LinearAllocator alloc(GetArraySize<Session>(m_sessionCount) + alignof(Session) +
+                              m_sessionCount * sessionSize);
+
+        m_sessions = alloc.AllocateArray<Session>(m_sessionCount);
+        for (size_t i = 0; i < m_sessionCount; i++)
+        {
+            Session *session = new (&m_sessions[i]) Session();
+            session->frameTimes = alloc.AllocateArray<uint32_t>(stepCount);
+            session->alloc.SetMemory(alloc.Allocate(m_sessionMemory, alignment), m_sessionMemory);
+            session->ticker.Init();
+            session->state = CreateSession(session->alloc, i);
+            session->state->SetAllocator(session->alloc);
+            if (!session->state->Initialize())
+                log::Error("Could not initialize headless session ", i);
+        }
+
+        log::Info("Running ", m_sessionCount, " headless sessions for ", stepCount,
+                  " steps on ", m_taskPool.GetThreadCount(), " threads");
+
+        MicroTicker ticker;
+        ticker.Init();
+        const Time_t startTime = ticker.GetTicks();
+        for (m_step = 0; m_step < stepCount; m_step++)
+        {
+            m_taskPool.ParallelFor(&HeadlessHost::StepSessions, this, int(m_sessionCount));
+        }
+        const Time_t totalTime = ticker.GetTicks() - startTime;
+
+        Report(stepCount, totalTime);
+
+        for (size_t i = 0; i < m_sessionCount; i++)
+        {
+            Session &session = m_sessions[i];
+            session.alloc.del_object(session.state);
+            session.~Session();
+        }
+        m_sessions = nullptr;
+    }
+
+    void HeadlessHost::StepSessions(void *context, int begin, int end, int threadIndex)
+    {
+        HeadlessHost *host = static_cast<HeadlessHost*>(context);
+        for (int i = begin; i < end; i++)
+        {
+            Session &session = host->m_sessions[i];
+            const Time_t start = session.ticker.GetTicks();
+            session.state->DoFixedUpdate();
+            session.frameTimes[host->m_step] = uint32_t(session.ticker.GetTicks() - start);
+        }
+    }
+
+    void HeadlessHost::Report(const int stepCount, const Time_t totalTime)
+    {
+        const double seconds = double(totalTime) / 1e6;
+        const double steps = double(stepCount) * double(m_sessionCount);
+        log::Info("Headless sessions took ", seconds, " s, ",
+                  (seconds > 0.0) ? steps / seconds : 0.0, " steps per second");
+        if (stepCount <= 0)
+            return;
+
+        log::Info("Frame times in microseconds (p50 / p90 / p99 / max):");
+        for (size_t i = 0; i < m_sessionCount; i++)
+        {
+            uint32_t *times = m_sessions[i].frameTimes;
+            std::sort(times, times + stepCount);
+            const int last = stepCount - 1;
+            log::Info("  session ", i, ": ", times[last * 50 / 100], " / ", times[last * 90 / 100],
+                      " / ", times[last * 99 / 100], " / ", times[last]);
+        }
+    }
+
+} // rob
@@ -0,0 +1,55 @@
+
+#ifndef H_ROB_HEADLESS_HOST_H
+#define H_ROB_HEADLESS_HOST_H
+
+#include "../memory/LinearAllocator.h"
+#include "../thread/TaskPool.h"
+#include "../time/MicroTicker.h"
+
+namespace rob
+{
+
+    class GameState;
+
+    /// Runs many independent game states at once without a window, renderer
+    /// or audio. Every session has its own state allocator and the sessions
+    /// are stepped in parallel on a task pool with the fixed time step.
+    class HeadlessHost
+    {
+    public:
+        HeadlessHost(size_t sessionCount, size_t sessionMemory);
+        HeadlessHost(const HeadlessHost&) = delete;
+        HeadlessHost& operator = (const HeadlessHost&) = delete;
+        virtual ~HeadlessHost();
+
+        /// Creates the sessions, steps them the given number of times and
+        /// logs the steps per second and the frame time percentiles.
+        void Run(const int stepCount);
+
+    protected:
+        /// Creates the state of a session using its own allocator.
+        virtual GameState* CreateSession(LinearAllocator &alloc, size_t index) = 0;
+
+    private:
+        struct Session
+        {
+            LinearAllocator alloc;
+            GameState *state;
+            MicroTicker ticker;
+            uint32_t *frameTimes;
+        };
+
+        static void StepSessions(void *context, int begin, int end, int threadIndex);
+        void Report(const int stepCount, const Time_t totalTime);
+
+    private:
+        TaskPool m_taskPool;
+        Session *m_sessions;
+        size_t m_sessionCount;
+        size_t m_sessionMemory;
+        int m_step;
+    };
+
+} // rob
+
+#endif // H_ROB_HEADLESS_HOST_H
@@ -15,10 +15,14 @@ namespace rob
     struct Sound
     {
         ALuint buffer;
+        uint32_t size;
+        bool hasData;
 
         Sound()
         {
             buffer = 0;
+            size = 0;
+            hasData = false;
             alGenBuffers(1, &buffer);
             AL_CHECK;
         }
@@ -74,6 +78,16 @@ namespace rob
         void Stop()
         { alSourceStop(source); }
 
+        /// Stops the sound and detaches its buffer from the source.
+        void Release()
+        {
+            alSourceStop(source);
+            AL_CHECK;
+            alSourcei(source, AL_BUFFER, 0);
+            AL_CHECK;
+            playingSound = nullptr;
+        }
+
         void Update()
         {
             if (playingSound == nullptr) return;
@@ -177,40 +191,97 @@ namespace rob
     }
 
     SoundHandle AudioSystem::LoadSound(const char * const filename)
+    {
+        SoundData data;
+        if (!DecodeSound(filename, data))
+            return InvalidSound;
+
+        const SoundHandle sound = CreateSound();
+        UploadSound(sound, data);
+        FreeSoundData(data);
+
+        return sound;
+    }
+
+    static bool DecodeWav(SDL_RWops *src, const char *name, SoundData &data)
     {
         SDL_AudioSpec spec;
         Uint32 len;
         Uint8 *wav;
 
-        if (SDL_LoadWAV(filename, &spec, &wav, &len) == nullptr)
+        data.m_samples = nullptr;
+
+        if (SDL_LoadWAV_RW(src, 1, &spec, &wav, &len) == nullptr)
         {
-            log::Error("Could not load sound ", filename, ": ", SDL_GetError());
-            return InvalidSound;
+            log::Error("Could not load sound ", name, ": ", SDL_GetError());
+            return false;
         }
 
         ALenum format = GetALFormat(spec);
         if (format == 0)
         {
-            log::Error("Could not load sound ", filename, ": Unsupported data format");
+            log::Error("Could not load sound ", name, ": Unsupported data format");
             SDL_FreeWAV(wav);
-            return InvalidSound;
+            return false;
         }
 
-        Sound *sound = m_sounds.Obtain();
+        data.m_samples = wav;
+        data.m_size = len;
+        data.m_format = format;
+        data.m_frequency = spec.freq;
+        return true;
+    }
 
-        alBufferData(sound->buffer, format, wav, len, spec.freq);
-        AL_CHECK;
+    bool AudioSystem::DecodeSound(const char * const filename, SoundData &data)
+    {
+        return DecodeWav(SDL_RWFromFile(filename, "rb"), filename, data);
+    }
 
-        SDL_FreeWAV(wav);
+    bool AudioSystem::DecodeSound(const char *file, size_t size, SoundData &data)
+    {
+        return DecodeWav(SDL_RWFromConstMem(file, int(size)), "from memory", data);
+    }
+
+    void AudioSystem::FreeSoundData(SoundData &data)
+    {
+        if (data.m_samples) SDL_FreeWAV(data.m_samples);
+        data.m_samples = nullptr;
+    }
 
+    SoundHandle AudioSystem::CreateSound()
+    {
+        Sound *sound = m_sounds.Obtain();
         return m_sounds.IndexOf(sound);
     }
 
+    void AudioSystem::UploadSound(SoundHandle sound, const SoundData &data)
+    {
+        if (sound == InvalidSound) return;
+
+        Sound *s = m_sounds.Get(sound);
+        alBufferData(s->buffer, data.m_format, data.m_samples, data.m_size, data.m_frequency);
+        AL_CHECK;
+        s->size = data.m_size;
+        s->hasData = true;
+    }
+
+    size_t AudioSystem::GetSoundSize(SoundHandle sound) const
+    {
+        if (sound == InvalidSound) return 0;
+        return m_sounds.Get(sound)->size;
+    }
+
     void AudioSystem::UnloadSound(SoundHandle sound)
     {
         if (sound == InvalidSound) return;
 
         Sound *s = m_sounds.Get(sound);
+        // The buffer can't be deleted while a source uses it.
+        for (size_t i = 0; i < MAX_CHANNELS; i++)
+        {
+            if (m_channels[i]->playingSound == s)
+                m_channels[i]->Release();
+        }
         m_sounds.Return(s);
     }
 
@@ -234,6 +305,7 @@ namespace rob
     {
         if (IsMuted()) return;
         if (sound == InvalidSound) return;
+        if (!m_sounds.Get(sound)->hasData) return;
 
         uint32_t timeMillis = currentTime / 1000ull;
 
@@ -19,6 +19,15 @@ namespace rob
 
     static const size_t MAX_CHANNELS = 16;
 
+    /// Decoded samples of a sound file, see AudioSystem::DecodeSound.
+    struct SoundData
+    {
+        uint8_t *m_samples;
+        uint32_t m_size;
+        int m_format;
+        int m_frequency;
+    };
+
     class AudioSystem
     {
     public:
@@ -28,6 +37,21 @@ namespace rob
         SoundHandle LoadSound(const char * const filename);
         void UnloadSound(SoundHandle sound);
 
+        /// Reads and decodes a sound file. Doesn't use the audio context, so it
+        /// can be called from any thread. The data must be released with
+        /// FreeSoundData.
+        static bool DecodeSound(const char * const filename, SoundData &data);
+        /// Decodes the sound file contents in memory.
+        static bool DecodeSound(const char *file, size_t size, SoundData &data);
+        static void FreeSoundData(SoundData &data);
+
+        /// Creates a sound without samples. It plays nothing until the samples
+        /// are given with UploadSound.
+        SoundHandle CreateSound();
+        void UploadSound(SoundHandle sound, const SoundData &data);
+        /// Returns the bytes of samples uploaded for the sound.
+        size_t GetSoundSize(SoundHandle sound) const;
+
         void SetMasterVolume(float volume);
 
         void SetMute(bool mute);
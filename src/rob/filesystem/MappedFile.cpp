@@ -0,0 +1,110 @@
+
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rob
+{
+
+    MappedFile::MappedFile()
+        : m_data(nullptr)
+        , m_size(0)
+#if defined(_WIN32)
+        , m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+#endif
+    { }
+
+    MappedFile::~MappedFile()
+    { Close(); }
+
+#if defined(_WIN32)
+
+    bool MappedFile::Open(const char * const filename)
+    {
+        Close();
+
+        m_file = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        const DWORD size = ::GetFileSize(m_file, nullptr);
+        if (size == INVALID_FILE_SIZE || size == 0)
+        {
+            Close();
+            return false;
+        }
+
+        m_mapping = ::CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping)
+        {
+            Close();
+            return false;
+        }
+
+        m_data = static_cast<const char*>(::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data)
+        {
+            Close();
+            return false;
+        }
+        m_size = size;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data) ::UnmapViewOfFile(m_data);
+        if (m_mapping) ::CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) ::CloseHandle(m_file);
+        m_data = nullptr;
+        m_size = 0;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+#else
+
+    bool MappedFile::Open(const char * const filename)
+    {
+        Close();
+
+        const int fd = ::open(filename, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct ::stat s;
+        if (::fstat(fd, &s) != 0 || s.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void *data = ::mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        m_data = static_cast<const char*>(data);
+        m_size = s.st_size;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data) ::munmap(const_cast<char*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+#endif
+
+} // rob
@@ -0,0 +1,37 @@
+
+#ifndef H_ROB_MAPPED_FILE_H
+#define H_ROB_MAPPED_FILE_H
+
+#include "../Types.h"
+
+namespace rob
+{
+
+    /// A read-only memory mapping of a whole file.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator = (const MappedFile&) = delete;
+        ~MappedFile();
+
+        bool Open(const char * const filename);
+        void Close();
+
+        bool IsOpen() const { return m_data != nullptr; }
+        const char* GetData() const { return m_data; }
+        size_t GetSize() const { return m_size; }
+
+    private:
+        const char *m_data;
+        size_t m_size;
+#if defined(_WIN32)
+        void *m_file;
+        void *m_mapping;
+#endif
+    };
+
+} // rob
+
+#endif // H_ROB_MAPPED_FILE_H
@@ -0,0 +1,128 @@
+
+#include "S3tc.h"
+
+namespace rob
+{
+
+    static void Unpack565(uint16_t c, uint8_t *rgb)
+    {
+        const uint32_t r = (c >> 11) & 0x1f;
+        const uint32_t g = (c >> 5) & 0x3f;
+        const uint32_t b = c & 0x1f;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    /// Decodes the color part of a block to 16 RGBA pixels. The color block
+    /// of BC3 is always in four color mode.
+    static void DecodeColorBlock(const uint8_t *block, bool fourColors, uint8_t (&pixels)[16][4])
+    {
+        const uint16_t c0 = block[0] | (block[1] << 8);
+        const uint16_t c1 = block[2] | (block[3] << 8);
+
+        uint8_t palette[4][4];
+        Unpack565(c0, palette[0]);
+        Unpack565(c1, palette[1]);
+        palette[0][3] = palette[1][3] = 255;
+        if (fourColors || c0 > c1)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+                palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+            }
+            palette[2][3] = palette[3][3] = 255;
+        }
+        else
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+                palette[3][i] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 0;
+        }
+
+        const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+        for (size_t p = 0; p < 16; p++)
+        {
+            const uint8_t *color = palette[(indices >> (p * 2)) & 3];
+            for (size_t i = 0; i < 4; i++)
+                pixels[p][i] = color[i];
+        }
+    }
+
+    static void DecodeAlphaBlock(const uint8_t *block, uint8_t (&pixels)[16][4])
+    {
+        const uint32_t a0 = block[0];
+        const uint32_t a1 = block[1];
+
+        uint8_t palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1)
+        {
+            for (uint32_t i = 1; i < 7; i++)
+                palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; i++)
+                palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (size_t i = 0; i < 6; i++)
+            indices |= uint64_t(block[2 + i]) << (i * 8);
+        for (size_t p = 0; p < 16; p++)
+            pixels[p][3] = palette[(indices >> (p * 3)) & 7];
+    }
+
+    static void WriteBlock(const uint8_t (&pixels)[16][4], size_t bx, size_t by,
+                           size_t w, size_t h, uint8_t *rgba)
+    {
+        for (size_t y = 0; y < 4 && by + y < h; y++)
+        {
+            for (size_t x = 0; x < 4 && bx + x < w; x++)
+            {
+                uint8_t *dest = rgba + ((by + y) * w + bx + x) * 4;
+                for (size_t i = 0; i < 4; i++)
+                    dest[i] = pixels[y * 4 + x][i];
+            }
+        }
+    }
+
+    void DecompressBC1(const uint8_t *blocks, size_t w, size_t h, uint8_t *rgba)
+    {
+        uint8_t pixels[16][4];
+        for (size_t by = 0; by < h; by += 4)
+        {
+            for (size_t bx = 0; bx < w; bx += 4)
+            {
+                DecodeColorBlock(blocks, false, pixels);
+                WriteBlock(pixels, bx, by, w, h, rgba);
+                blocks += BC1_BLOCK_SIZE;
+            }
+        }
+    }
+
+    void DecompressBC3(const uint8_t *blocks, size_t w, size_t h, uint8_t *rgba)
+    {
+        uint8_t pixels[16][4];
+        for (size_t by = 0; by < h; by += 4)
+        {
+            for (size_t bx = 0; bx < w; bx += 4)
+            {
+                DecodeColorBlock(blocks + 8, true, pixels);
+                DecodeAlphaBlock(blocks, pixels);
+                WriteBlock(pixels, bx, by, w, h, rgba);
+                blocks += BC3_BLOCK_SIZE;
+            }
+        }
+    }
+
+} // rob
@@ -0,0 +1,22 @@
+
+#ifndef H_ROB_S3TC_H
+#define H_ROB_S3TC_H
+
+#include "../Types.h"
+
+namespace rob
+{
+
+    /// Bytes of a BC1 (DXT1) or BC3 (DXT5) block of 4x4 pixels.
+    static const size_t BC1_BLOCK_SIZE = 8;
+    static const size_t BC3_BLOCK_SIZE = 16;
+
+    /// Decompresses a BC1 image of w x h pixels to RGBA. The image has
+    /// (w + 3) / 4 * (h + 3) / 4 blocks, and rgba has room for w * h pixels.
+    void DecompressBC1(const uint8_t *blocks, size_t w, size_t h, uint8_t *rgba);
+    /// Decompresses a BC3 image like DecompressBC1.
+    void DecompressBC3(const uint8_t *blocks, size_t w, size_t h, uint8_t *rgba);
+
+} // rob
+
+#endif // H_ROB_S3TC_H
@@ -44,6 +44,8 @@ namespace rob
 
     bool ShaderProgram::Link()
     {
+        if (HasBinarySupport())
+            ::glProgramParameteri(m_object, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         ::glLinkProgram(m_object);
         GLint linked = GL_FALSE;
         ::glGetProgramiv(m_object, GL_LINK_STATUS, &linked);
@@ -53,6 +55,40 @@ namespace rob
     bool ShaderProgram::IsLinked() const
     { return m_linked; }
 
+    bool ShaderProgram::HasBinarySupport()
+    {
+        if (!GLEW_ARB_get_program_binary)
+            return false;
+        GLint formats = 0;
+        ::glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    size_t ShaderProgram::GetBinarySize() const
+    {
+        if (!m_linked) return 0;
+        GLint len = 0;
+        ::glGetProgramiv(m_object, GL_PROGRAM_BINARY_LENGTH, &len);
+        return static_cast<size_t>(len);
+    }
+
+    bool ShaderProgram::GetBinary(void *buffer, size_t bufferSize, uint32_t &format) const
+    {
+        GLsizei len = 0;
+        GLenum binaryFormat = 0;
+        ::glGetProgramBinary(m_object, bufferSize, &len, &binaryFormat, buffer);
+        format = binaryFormat;
+        return len > 0 && static_cast<size_t>(len) == bufferSize;
+    }
+
+    bool ShaderProgram::LoadBinary(const void *binary, size_t size, uint32_t format)
+    {
+        ::glProgramBinary(m_object, format, binary, size);
+        GLint linked = GL_FALSE;
+        ::glGetProgramiv(m_object, GL_LINK_STATUS, &linked);
+        return m_linked = (linked == GL_TRUE) ? true : false;
+    }
+
     size_t ShaderProgram::GetLinkInfoSize() const
     {
         GLint len = 0;
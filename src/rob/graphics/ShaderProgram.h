@@ -26,6 +26,17 @@ namespace rob
 
         bool IsLinked() const;
 
+        /// Returns true if the GL can give and take linked program binaries.
+        static bool HasBinarySupport();
+        /// Returns the size of the binary of the linked program, zero if
+        /// there is no binary.
+        size_t GetBinarySize() const;
+        /// Gets the binary of the linked program and its driver specific format.
+        bool GetBinary(void *buffer, size_t bufferSize, uint32_t &format) const;
+        /// Links the program from a binary given by GetBinary. Returns false,
+        /// if the driver rejects the binary, e.g. after a driver update.
+        bool LoadBinary(const void *binary, size_t size, uint32_t format);
+
         size_t GetLinkInfoSize() const;
         void GetLinkInfo(char *buffer, size_t bufferSize) const;
 
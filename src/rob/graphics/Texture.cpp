@@ -1,7 +1,9 @@
 
 #include "Texture.h"
+#include "S3tc.h"
 
 #include "GLCheck.h"
+#include "../memory/PtrAlign.h"
 #include <GL/glew.h>
 
 namespace rob
@@ -12,6 +14,8 @@ namespace rob
         , m_width(0)
         , m_height(0)
         , m_format(FMT_RGB)
+        , m_levelCount(0)
+        , m_size(0)
     {
         ::glGenTextures(1, &m_object);
         GL_CHECK;
@@ -36,15 +40,60 @@ namespace rob
 
     void Texture::TexImage(size_t w, size_t h, Format fmt, const void * const data)
     {
-        m_width = w;
-        m_height = h;
-        m_format = fmt;
+        TexLevel(0, w, h, fmt, data);
+        SetLevelCount(1);
+    }
+
+    void Texture::TexLevel(size_t level, size_t w, size_t h, Format fmt, const void * const data)
+    {
+        if (level == 0)
+        {
+            m_width = w;
+            m_height = h;
+            m_size = 0;
+        }
 
-        const GLint internalFmt = static_cast<GLint>(fmt);
-        const GLenum format = gl_formats[fmt];
-        ::glTexImage2D(GL_TEXTURE_2D, 0, internalFmt, w, h, 0, format, GL_UNSIGNED_BYTE, data);
+        if (IsCompressed(fmt) && GLEW_EXT_texture_compression_s3tc)
+        {
+            const GLenum internalFmt = (fmt == FMT_BC1)
+                ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            const size_t size = GetImageSize(w, h, fmt);
+            ::glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFmt, w, h, 0, size, data);
+            GL_CHECK;
+            m_format = fmt;
+            m_size += size;
+        }
+        else if (IsCompressed(fmt))
+        {
+            uint8_t * const rgba = new uint8_t[w * h * 4];
+            if (fmt == FMT_BC1)
+                DecompressBC1(static_cast<const uint8_t*>(data), w, h, rgba);
+            else
+                DecompressBC3(static_cast<const uint8_t*>(data), w, h, rgba);
+            ::glTexImage2D(GL_TEXTURE_2D, level, FMT_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+            GL_CHECK;
+            delete[] rgba;
+            m_format = FMT_RGBA;
+            m_size += w * h * 4;
+        }
+        else
+        {
+            const GLint internalFmt = static_cast<GLint>(fmt);
+            const GLenum format = gl_formats[fmt];
+            ::glTexImage2D(GL_TEXTURE_2D, level, internalFmt, w, h, 0, format, GL_UNSIGNED_BYTE, data);
+            GL_CHECK;
+            m_format = fmt;
+            m_size += w * h * static_cast<size_t>(fmt);
+        }
+    }
+
+    void Texture::SetLevelCount(size_t count)
+    {
+        m_levelCount = count;
+        ::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, count - 1);
         GL_CHECK;
-        ::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);//GL_NEAREST);
+        ::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (count > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
         GL_CHECK;
         ::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         GL_CHECK;
@@ -56,4 +105,26 @@ namespace rob
     size_t Texture::GetHeight() const
     { return m_height; }
 
+    Texture::Format Texture::GetFormat() const
+    { return m_format; }
+
+    size_t Texture::GetLevelCount() const
+    { return m_levelCount; }
+
+    size_t Texture::GetSize() const
+    { return m_size; }
+
+    bool Texture::IsCompressed(Format fmt)
+    { return fmt == FMT_BC1 || fmt == FMT_BC3; }
+
+    size_t Texture::GetImageSize(size_t w, size_t h, Format fmt)
+    {
+        if (IsCompressed(fmt))
+        {
+            const size_t blockSize = (fmt == FMT_BC1) ? BC1_BLOCK_SIZE : BC3_BLOCK_SIZE;
+            return ((w + 3) / 4) * ((h + 3) / 4) * blockSize;
+        }
+        return align(w * static_cast<size_t>(fmt), 4) * h;
+    }
+
 } // rob
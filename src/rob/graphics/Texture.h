@@ -14,8 +14,14 @@ namespace rob
         enum Format
         {
             FMT_RGB = 3,
-            FMT_RGBA = 4
+            FMT_RGBA = 4,
+            /// S3TC compressed formats
+            FMT_BC1 = 5,
+            FMT_BC3 = 6
         };
+
+        /// Maximum number of mip levels of a texture.
+        static const size_t MAX_LEVELS = 16;
     public:
         Texture();
         ~Texture();
@@ -28,14 +34,35 @@ namespace rob
         /// \pre This texture must be bind to the graphics context before calling this method.
         void TexImage(size_t w, size_t h, Format fmt, const void * const data);
 
+        /// Sets the image of a mip level. Rows of uncompressed data are aligned
+        /// to 4 bytes. Compressed data is decompressed to RGBA if the GL has no
+        /// S3TC support. Level 0 must be set first and SetLevelCount after the
+        /// last level.
+        /// \pre This texture must be bind to the graphics context before calling this method.
+        void TexLevel(size_t level, size_t w, size_t h, Format fmt, const void * const data);
+        /// Sets the filtering for the number of levels set with TexLevel.
+        /// \pre This texture must be bind to the graphics context before calling this method.
+        void SetLevelCount(size_t count);
+
         size_t GetWidth() const;
         size_t GetHeight() const;
+        /// Returns the format of the image in the GL.
+        Format GetFormat() const;
+        size_t GetLevelCount() const;
+        /// Returns the bytes of all levels in the GL.
+        size_t GetSize() const;
+
+        static bool IsCompressed(Format fmt);
+        /// Returns the bytes of an image, as given to TexLevel.
+        static size_t GetImageSize(size_t w, size_t h, Format fmt);
 
     private:
         GLuint m_object;
         size_t m_width;
         size_t m_height;
         Format m_format;
+        size_t m_levelCount;
+        size_t m_size;
     };
 
 } // rob
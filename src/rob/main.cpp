@@ -2,6 +2,10 @@
 #include <SDL2/SDL.h>
 
 #include "duck/Game.h"
+#include "duck/Headless.h"
+
+#include <cstdlib>
+#include <cstring>
 
 #ifdef ROB_DEBUG
 #include "resource/Builder/MasterBuilder.h"
@@ -14,9 +18,27 @@ int main(int argc, char *argv[])
 #ifdef ROB_DEBUG
     rob::MasterBuilder builder;
     builder.Build("data_source", "data");
+    builder.BuildPack("data", "data.pak");
 #endif
 
+    // --headless <sessions> <steps>
+    if (argc >= 2 && std::strcmp(argv[1], "--headless") == 0)
+    {
+        const int sessions = (argc >= 3) ? std::atoi(argv[2]) : 8;
+        const int steps = (argc >= 4) ? std::atoi(argv[3]) : 3600;
+        duck::HeadlessHost host(sessions > 0 ? sessions : 1);
+        host.Run(steps > 0 ? steps : 1);
+        return 0;
+    }
+
+    // --replay <file> [timing.csv]
+    if (argc >= 3 && std::strcmp(argv[1], "--replay") == 0)
+        return duck::RunReplay(argv[2], (argc >= 4) ? argv[3] : nullptr) ? 0 : 1;
+
     duck::Game game;
+    // --record <file>
+    if (argc >= 3 && std::strcmp(argv[1], "--record") == 0)
+        game.SetRecordFile(argv[2]);
     game.Run();
 
     return 0;
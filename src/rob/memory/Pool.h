@@ -41,6 +41,9 @@ namespace rob
         T* Get(size_t index)
         { return m_start + index; }
 
+        const T* Get(size_t index) const
+        { return m_start + index; }
+
         void Return(T *object)
         {
             ROB_ASSERT(m_start <= object && object < m_end);
@@ -0,0 +1,169 @@
+
+#include "SizeClassAllocator.h"
+#include "PtrAlign.h"
+#include "../Assert.h"
+
+namespace rob
+{
+
+    static const size_t MIN_BLOCK_SIZE = 64;
+    static const size_t BLOCK_ALIGNMENT = 16;
+    static const size_t CLASSES_PER_DOUBLING = 4;
+
+    // Each doubling of the size is split into four classes to keep the
+    // rounding waste under 25%, e.g. 64, 80, 96, 112, 128, 160, ...
+    static size_t GetClassSize(const size_t sizeClass)
+    {
+        const size_t base = MIN_BLOCK_SIZE << (sizeClass / CLASSES_PER_DOUBLING);
+        return base + (sizeClass % CLASSES_PER_DOUBLING) * (base / CLASSES_PER_DOUBLING);
+    }
+
+    struct SizeClassAllocator::Header
+    {
+        size_t m_sizeClass;
+        size_t m_size;
+        // Only used by blocks from the heap.
+        char *m_memory;
+        Header *m_prev;
+        Header *m_next;
+    };
+
+    const size_t SizeClassAllocator::HEADER_SIZE = align(sizeof(Header), BLOCK_ALIGNMENT);
+
+    SizeClassAllocator::SizeClassAllocator()
+        : m_free()
+        , m_start(nullptr)
+        , m_head(nullptr)
+        , m_end(nullptr)
+        , m_heapBlocks(nullptr)
+        , m_allocatedSize(0)
+        , m_heapSize(0)
+        , m_allocations(0)
+    { }
+
+    SizeClassAllocator::~SizeClassAllocator()
+    { Reset(); }
+
+    void SizeClassAllocator::SetMemory(void *start, size_t size)
+    {
+        ROB_ASSERT(m_head == nullptr);
+        char *s = static_cast<char*>(start);
+        char *aligned = ptr_align(s, BLOCK_ALIGNMENT);
+        m_start = aligned;
+        m_head = aligned;
+        m_end = (aligned < s + size) ? s + size : aligned;
+    }
+
+    void* SizeClassAllocator::Allocate(size_t size)
+    {
+        const size_t blockSize = size + HEADER_SIZE;
+        size_t sizeClass = 0;
+        while (sizeClass < CLASS_COUNT && GetClassSize(sizeClass) < blockSize)
+            sizeClass++;
+        if (sizeClass == CLASS_COUNT)
+            return AllocateHeap(size);
+
+        const size_t classSize = GetClassSize(sizeClass);
+        char *block = static_cast<char*>(m_free[sizeClass].Obtain());
+        if (block == nullptr)
+        {
+            if (classSize > static_cast<size_t>(m_end - m_head))
+                return AllocateHeap(size);
+            block = m_head;
+            m_head += classSize;
+        }
+
+        Header *header = reinterpret_cast<Header*>(block);
+        header->m_sizeClass = sizeClass;
+        header->m_size = classSize;
+        m_allocatedSize += classSize;
+        m_allocations++;
+        return block + HEADER_SIZE;
+    }
+
+    void SizeClassAllocator::Deallocate(void *ptr)
+    {
+        if (ptr == nullptr)
+            return;
+
+        Header *header = reinterpret_cast<Header*>(static_cast<char*>(ptr) - HEADER_SIZE);
+        ROB_ASSERT(m_allocations > 0);
+        m_allocatedSize -= header->m_size;
+        m_allocations--;
+
+        if (header->m_sizeClass == HEAP_CLASS)
+        {
+            DeallocateHeap(header);
+            return;
+        }
+        ROB_ASSERT(m_start <= reinterpret_cast<char*>(header) && reinterpret_cast<char*>(header) < m_head);
+        m_free[header->m_sizeClass].Return(header);
+    }
+
+    void SizeClassAllocator::Reset()
+    {
+        while (m_heapBlocks)
+        {
+            Header *next = m_heapBlocks->m_next;
+            delete[] m_heapBlocks->m_memory;
+            m_heapBlocks = next;
+        }
+        for (size_t i = 0; i < CLASS_COUNT; i++)
+            m_free[i] = Freelist();
+        m_head = m_start;
+        m_allocatedSize = 0;
+        m_heapSize = 0;
+        m_allocations = 0;
+    }
+
+    size_t SizeClassAllocator::GetAllocatedSize() const
+    { return m_allocatedSize; }
+
+    size_t SizeClassAllocator::GetUsedSize() const
+    { return static_cast<size_t>(m_head - m_start); }
+
+    size_t SizeClassAllocator::GetTotalSize() const
+    { return static_cast<size_t>(m_end - m_start); }
+
+    size_t SizeClassAllocator::GetHeapSize() const
+    { return m_heapSize; }
+
+    size_t SizeClassAllocator::GetAllocationCount() const
+    { return m_allocations; }
+
+    void* SizeClassAllocator::AllocateHeap(size_t size)
+    {
+        const size_t blockSize = size + HEADER_SIZE;
+        // new[] only guarantees the alignment of fundamental types.
+        char *memory = new char[blockSize + BLOCK_ALIGNMENT];
+        char *block = ptr_align(memory, BLOCK_ALIGNMENT);
+
+        Header *header = reinterpret_cast<Header*>(block);
+        header->m_sizeClass = HEAP_CLASS;
+        header->m_size = blockSize;
+        header->m_memory = memory;
+        header->m_prev = nullptr;
+        header->m_next = m_heapBlocks;
+        if (m_heapBlocks)
+            m_heapBlocks->m_prev = header;
+        m_heapBlocks = header;
+
+        m_allocatedSize += blockSize;
+        m_heapSize += blockSize;
+        m_allocations++;
+        return block + HEADER_SIZE;
+    }
+
+    void SizeClassAllocator::DeallocateHeap(Header *header)
+    {
+        m_heapSize -= header->m_size;
+        if (header->m_prev)
+            header->m_prev->m_next = header->m_next;
+        else
+            m_heapBlocks = header->m_next;
+        if (header->m_next)
+            header->m_next->m_prev = header->m_prev;
+        delete[] header->m_memory;
+    }
+
+} // rob
@@ -0,0 +1,65 @@
+
+#ifndef H_ROB_SIZE_CLASS_ALLOCATOR_H
+#define H_ROB_SIZE_CLASS_ALLOCATOR_H
+
+#include "Freelist.h"
+#include "../Types.h"
+
+namespace rob
+{
+
+    /// General purpose allocator on top of a fixed block of memory. Sizes are
+    /// rounded up to one of a fixed set of size classes and freed blocks are
+    /// kept in a free list per size class for reuse. Allocations that don't
+    /// fit into the memory block are taken from the heap, so that running out
+    /// isn't fatal.
+    class SizeClassAllocator
+    {
+    public:
+        SizeClassAllocator();
+        SizeClassAllocator(const SizeClassAllocator&) = delete;
+        SizeClassAllocator& operator = (const SizeClassAllocator&) = delete;
+        ~SizeClassAllocator();
+
+        void SetMemory(void *start, size_t size);
+
+        /// Returned memory is aligned to 16 bytes.
+        void* Allocate(size_t size);
+        void Deallocate(void *ptr);
+
+        /// Releases all allocations at once, including the ones from the heap.
+        void Reset();
+
+        /// Bytes in live allocations, rounded up to their size class.
+        size_t GetAllocatedSize() const;
+        /// Bytes taken from the memory block, either in use or free listed.
+        size_t GetUsedSize() const;
+        size_t GetTotalSize() const;
+        /// Bytes in live allocations that didn't fit into the memory block.
+        size_t GetHeapSize() const;
+        size_t GetAllocationCount() const;
+
+    private:
+        struct Header;
+        static const size_t HEADER_SIZE;
+
+        static const size_t CLASS_COUNT = 80; // Blocks up to 56 MB
+        static const size_t HEAP_CLASS = CLASS_COUNT;
+
+        void* AllocateHeap(size_t size);
+        void DeallocateHeap(Header *header);
+
+    private:
+        Freelist m_free[CLASS_COUNT];
+        char *m_start;
+        char *m_head;
+        const char *m_end;
+        Header *m_heapBlocks;
+        size_t m_allocatedSize;
+        size_t m_heapSize;
+        size_t m_allocations;
+    };
+
+} // rob
+
+#endif // H_ROB_SIZE_CLASS_ALLOCATOR_H
@@ -11,15 +11,14 @@ namespace rob
         , m_height(0)
         , m_horiSpacing(0)
         , m_lineSpacing(0)
+        , m_glyph(nullptr)
+        , m_glyphMapping(nullptr)
         , m_glyphCount(0)
+        , m_kerningPairs(nullptr)
+        , m_kerningCount(0)
         , m_textureCount(0)
-    {
-        for (size_t i = 0; i < MAX_GLYPHS; i++)
-        {
-            m_glyphMapping[i] = 0;
-            m_glyph[i].m_textureIdx = -1;
-        }
-    }
+        , m_file(nullptr)
+    { }
 
     bool Font::IsReady() const
     { return m_glyphCount > 0; }
@@ -48,12 +47,12 @@ namespace rob
     uint16_t Font::GetLineSpacing() const
     { return m_lineSpacing; }
 
-    void Font::AddGlyph(uint32_t character, const Glyph &glyph)
+    void Font::SetGlyphs(const Glyph *glyphs, const uint32_t *glyphMapping, size_t glyphCount)
     {
-        const size_t index = m_glyphCount++;
-        ROB_ASSERT(index < MAX_GLYPHS);
-        m_glyphMapping[index] = character;
-        m_glyph[character] = glyph;
+        ROB_ASSERT(glyphCount <= MAX_GLYPHS);
+        m_glyph = glyphs;
+        m_glyphMapping = glyphMapping;
+        m_glyphCount = glyphCount;
     }
 
     const Glyph& Font::GetGlyph(uint32_t character) const
@@ -74,10 +73,38 @@ namespace rob
     size_t Font::GetGlyphCount() const
     { return m_glyphCount; }
 
-    void Font::AddTexture(size_t page, TextureHandle texture)
+    void Font::SetKerningPairs(const KerningPair *pairs, size_t count)
+    {
+        m_kerningPairs = pairs;
+        m_kerningCount = count;
+    }
+
+    int16_t Font::GetKerning(uint32_t first, uint32_t second) const
+    {
+        size_t begin = 0;
+        size_t end = m_kerningCount;
+        while (begin < end)
+        {
+            const size_t mid = begin + (end - begin) / 2;
+            const KerningPair &pair = m_kerningPairs[mid];
+            if (pair.m_first < first || (pair.m_first == first && pair.m_second < second))
+                begin = mid + 1;
+            else
+                end = mid;
+        }
+        if (begin < m_kerningCount && m_kerningPairs[begin].m_first == first
+            && m_kerningPairs[begin].m_second == second)
+        {
+            return m_kerningPairs[begin].m_amount;
+        }
+        return 0;
+    }
+
+    void Font::AddTexture(size_t page, TextureHandle texture, uint32_t resourceId)
     {
         ROB_ASSERT(page < MAX_TEXTURE_PAGES);
         m_textures[page] = texture;
+        m_textureResources[page] = resourceId;
         m_textureCount = (page + 1 > m_textureCount) ? page + 1 : m_textureCount;
     }
 
@@ -87,7 +114,19 @@ namespace rob
         return m_textures[page];
     }
 
+    uint32_t Font::GetTextureResource(size_t page) const
+    {
+        ROB_ASSERT(page < MAX_TEXTURE_PAGES);
+        return m_textureResources[page];
+    }
+
     size_t Font::GetTextureCount() const
     { return m_textureCount; }
 
+    void Font::SetFile(MappedFile *file)
+    { m_file = file; }
+
+    MappedFile* Font::GetFile() const
+    { return m_file; }
+
 } // rob
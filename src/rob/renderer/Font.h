@@ -22,8 +22,25 @@ namespace rob
         uint16_t m_textureIdx;
     };
 
+    struct KerningPair
+    {
+        uint32_t m_first;
+        uint32_t m_second;
+        // Added to the advance of the first character
+        int16_t m_amount;
+        int16_t m_padding;
+    };
+
+    class MappedFile;
+
+    /// Uses the glyph table of a font file in place, see FontFile.h. Copies of
+    /// a font share the table.
     class Font
     {
+    public:
+        static const size_t MAX_GLYPHS = 256;
+        static const size_t MAX_TEXTURE_PAGES = 8;
+
     public:
         Font();
 
@@ -41,35 +58,51 @@ namespace rob
         void SetLineSpacing(uint16_t spacing);
         uint16_t GetLineSpacing() const;
 
-        void AddGlyph(uint32_t index, const Glyph &glyph);
+        /// Sets the glyph table of MAX_GLYPHS glyphs indexed by character, and
+        /// the characters the font has. The tables are not copied.
+        void SetGlyphs(const Glyph *glyphs, const uint32_t *glyphMapping, size_t glyphCount);
         const Glyph& GetGlyph(uint32_t character) const;
 
         const Glyph& GetGlyphByIndex(size_t index) const;
         size_t GetGlyphCount() const;
 
-        void AddTexture(size_t page, TextureHandle texture);
+        /// Sets the kerning pairs sorted by the first and the second character.
+        /// The pairs are not copied.
+        void SetKerningPairs(const KerningPair *pairs, size_t count);
+        /// Returns the kerning of the character pair, or zero if the font has
+        /// no kerning for the pair.
+        int16_t GetKerning(uint32_t first, uint32_t second) const;
+
+        /// Sets the texture of a page. The resource id is kept for releasing
+        /// the texture when the font is unloaded.
+        void AddTexture(size_t page, TextureHandle texture, uint32_t resourceId);
         TextureHandle GetTexture(size_t page) const;
+        uint32_t GetTextureResource(size_t page) const;
         size_t GetTextureCount() const;
 
+        /// The mapped font file the tables are in, if the font was loaded from
+        /// a file. The file is owned by FontCache.
+        void SetFile(MappedFile *file);
+        MappedFile* GetFile() const;
+
     private:
         uint16_t m_base;
         uint16_t m_height;
         uint16_t m_horiSpacing;
         uint16_t m_lineSpacing;
 
-        // TODO: Enable dynamic glyph count (no hard coded limit).
-        // The alocations should be done by FontManager.
-        static const size_t MAX_GLYPHS = 256;
-        Glyph m_glyph[MAX_GLYPHS];
-        uint32_t m_glyphMapping[MAX_GLYPHS];
+        const Glyph *m_glyph;
+        const uint32_t *m_glyphMapping;
         size_t m_glyphCount;
 
-        static const size_t MAX_TEXTURE_PAGES = 8;
+        const KerningPair *m_kerningPairs;
+        size_t m_kerningCount;
+
         TextureHandle m_textures[MAX_TEXTURE_PAGES];
+        uint32_t m_textureResources[MAX_TEXTURE_PAGES];
         size_t m_textureCount;
 
-        // TODO: Add kerning support
-        // int16_t **m_kerningPairs; (or something?)
+        MappedFile *m_file;
     };
 
 } // rob
@@ -44,49 +44,63 @@ namespace rob
     };
 
 
-    ShaderProgramHandle Renderer::CompileShaderProgram(const char * const vert, const char * const frag)
+    static bool LinkShaderProgram(Graphics *graphics, ShaderProgram *program,
+                                  const char * const vert, const char * const frag)
     {
-        VertexShaderHandle vs = m_graphics->CreateVertexShader();
-        VertexShader *vertShader = m_graphics->GetVertexShader(vs);
+        VertexShaderHandle vs = graphics->CreateVertexShader();
+        VertexShader *vertShader = graphics->GetVertexShader(vs);
         vertShader->SetSource(vert);
         if (!vertShader->Compile())
         {
             char buffer[512];
             vertShader->GetCompileInfo(buffer, 512);
             log::Error(&buffer[0]);
-            m_graphics->DestroyVertexShader(vs);
-            return InvalidHandle;
+            graphics->DestroyVertexShader(vs);
+            return false;
         }
 
-        FragmentShaderHandle fs = m_graphics->CreateFragmentShader();
-        FragmentShader *fragShader = m_graphics->GetFragmentShader(fs);
+        FragmentShaderHandle fs = graphics->CreateFragmentShader();
+        FragmentShader *fragShader = graphics->GetFragmentShader(fs);
         fragShader->SetSource(frag);
         if (!fragShader->Compile())
         {
             char buffer[512];
             fragShader->GetCompileInfo(buffer, 512);
             log::Error(&buffer[0]);
-            m_graphics->DestroyVertexShader(vs);
-            m_graphics->DestroyFragmentShader(fs);
-            return InvalidHandle;
+            graphics->DestroyVertexShader(vs);
+            graphics->DestroyFragmentShader(fs);
+            return false;
         }
 
-        ShaderProgramHandle p = m_graphics->CreateShaderProgram();
-        ShaderProgram *program = m_graphics->GetShaderProgram(p);
         program->SetShaders(vertShader, fragShader);
-        if (!program->Link())
+        const bool linked = program->Link();
+        if (!linked)
         {
             char buffer[512];
             program->GetLinkInfo(buffer, 512);
             log::Error(&buffer[0]);
-            m_graphics->DestroyVertexShader(vs);
-            m_graphics->DestroyFragmentShader(fs);
-            m_graphics->DestroyFragmentShader(p);
-            return InvalidHandle;
         }
 
-        m_graphics->DestroyVertexShader(vs);
-        m_graphics->DestroyFragmentShader(fs);
+        graphics->DestroyVertexShader(vs);
+        graphics->DestroyFragmentShader(fs);
+        return linked;
+    }
+
+    ShaderProgramHandle Renderer::CompileShaderProgram(const char * const vert, const char * const frag)
+    {
+        ShaderProgramHandle p = m_graphics->CreateShaderProgram();
+        ShaderProgram *program = m_graphics->GetShaderProgram(p);
+
+        const uint64_t key = m_shaderCache.GetKey(vert, frag);
+        if (!m_shaderCache.Load(key, program))
+        {
+            if (!LinkShaderProgram(m_graphics, program, vert, frag))
+            {
+                m_graphics->DestroyShaderProgram(p);
+                return InvalidHandle;
+            }
+            m_shaderCache.Store(key, program);
+        }
 
         m_graphics->AddProgramUniform(p, m_globals.projection);
         m_graphics->AddProgramUniform(p, m_globals.model);
@@ -108,6 +122,7 @@ namespace rob
         , m_colorProgram(InvalidHandle)
         , m_textureProgram(InvalidHandle)
         , m_fontProgram(InvalidHandle)
+        , m_shaderCache()
         , m_color(Color::White)
         , m_font()
         , m_fontScale(1.0f)
@@ -122,14 +137,16 @@ namespace rob
         m_graphics->SetUniform(m_globals.time_ms, 0);
         m_graphics->SetUniform(m_globals.texture0, 0);
 
+        m_shaderCache.Open("shader.cache");
         m_colorProgram = CompileShaderProgram(g_colorVertexShader, g_colorFragmentShader);
         m_textureProgram = CompileShaderProgram(g_textureVertexShader, g_textureFragmentShader);
         m_fontProgram = CompileShaderProgram(g_fontVertexShader, g_fontFragmentShader);
+        m_shaderCache.Save();
 
-//        m_font = cache->GetFont("lucida_24.fnt");
-//        m_font = cache->GetFont("dejavu_24.fnt");
-//        m_font = cache->GetFont("dejavu_96.fnt");
-        m_font = cache->GetFont("dejavu_192.fnt");
+//        m_font = cache->GetFont("lucida_24.font");
+//        m_font = cache->GetFont("dejavu_24.font");
+//        m_font = cache->GetFont("dejavu_96.font");
+        m_font = cache->GetFont("dejavu_192.font");
 
         m_vertexBuffer = m_graphics->CreateVertexBuffer();
         m_graphics->BindVertexBuffer(m_vertexBuffer);
@@ -139,6 +156,8 @@ namespace rob
 
     Renderer::~Renderer()
     {
+        // Saves the programs compiled after the constructor.
+        m_shaderCache.Save();
         m_graphics->DestroyVertexBuffer(m_vertexBuffer);
         if (m_colorProgram != InvalidHandle)
             m_graphics->DestroyShaderProgram(m_colorProgram);
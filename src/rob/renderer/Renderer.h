@@ -6,6 +6,7 @@
 #include "../resource/ResourceID.h"
 #include "Color.h"
 #include "Font.h"
+#include "ShaderCache.h"
 
 #include "../math/Types.h"
 #include "../math/Matrix4.h"
@@ -55,6 +56,8 @@ namespace rob
         Renderer& operator = (const Renderer&) = delete;
         ~Renderer();
 
+        /// Compiles and links a shader program, or links it from the binary
+        /// in the shader cache if the sources have been compiled before.
         ShaderProgramHandle CompileShaderProgram(const char * const vert, const char * const frag);
 
         Graphics* GetGraphics();
@@ -121,6 +124,7 @@ namespace rob
         ShaderProgramHandle     m_colorProgram;
         ShaderProgramHandle     m_textureProgram;
         ShaderProgramHandle     m_fontProgram;
+        ShaderCache             m_shaderCache;
 
         Color m_color;
         Font m_font;
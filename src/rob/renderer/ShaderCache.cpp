@@ -0,0 +1,191 @@
+
+#include "ShaderCache.h"
+#include "../graphics/ShaderProgram.h"
+
+#include "../Log.h"
+
+#include <GL/glew.h>
+
+#include <fstream>
+
+namespace rob
+{
+
+    static const uint32_t SHADER_CACHE_MAGIC = 0x43485352; // "RSHC"
+    static const uint32_t SHADER_CACHE_VERSION = 1;
+
+    struct ShaderCacheHeader
+    {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_entryCount;
+        uint32_t m_reserved;
+    };
+
+    struct ShaderCacheEntry
+    {
+        uint64_t m_key;
+        uint32_t m_format;
+        uint32_t m_size;
+    };
+
+    /// FNV-1a hash of a string, continuing from hash.
+    static uint64_t HashString(uint64_t hash, const char *str)
+    {
+        for (; *str; str++)
+            hash = (hash ^ uint8_t(*str)) * 1099511628211ull;
+        // Separates the strings, so that "ab" + "c" differs from "a" + "bc".
+        return (hash ^ 0xff) * 1099511628211ull;
+    }
+
+    static const char* GetGLString(GLenum name)
+    {
+        const GLubyte *str = ::glGetString(name);
+        return str ? reinterpret_cast<const char*>(str) : "";
+    }
+
+    ShaderCache::ShaderCache()
+        : m_entries()
+        , m_filename()
+        , m_contextHash(0)
+        , m_enabled(false)
+        , m_dirty(false)
+    { }
+
+    void ShaderCache::Open(const char * const filename)
+    {
+        m_filename = filename;
+        m_enabled = ShaderProgram::HasBinarySupport();
+        if (!m_enabled)
+            return;
+
+        uint64_t hash = 14695981039346656037ull;
+        hash = HashString(hash, GetGLString(GL_VENDOR));
+        hash = HashString(hash, GetGLString(GL_RENDERER));
+        hash = HashString(hash, GetGLString(GL_VERSION));
+        m_contextHash = hash;
+
+        std::ifstream in(filename, std::ios_base::binary);
+        if (!in.is_open())
+            return;
+
+        ShaderCacheHeader header;
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!in || header.m_magic != SHADER_CACHE_MAGIC || header.m_version != SHADER_CACHE_VERSION)
+        {
+            log::Info("ShaderCache: Ignored invalid cache file ", filename);
+            return;
+        }
+
+        for (size_t i = 0; i < header.m_entryCount; i++)
+        {
+            ShaderCacheEntry entry;
+            in.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+            if (!in)
+                break;
+
+            Entry e;
+            e.m_key = entry.m_key;
+            e.m_format = entry.m_format;
+            e.m_binary.resize(entry.m_size);
+            in.read(e.m_binary.data(), e.m_binary.size());
+            if (!in)
+                break;
+            m_entries.push_back(std::move(e));
+        }
+    }
+
+    void ShaderCache::Save()
+    {
+        if (!m_dirty)
+            return;
+
+        std::ofstream out(m_filename.c_str(), std::ios_base::binary);
+        if (!out.is_open())
+        {
+            log::Error("ShaderCache: Could not write cache file ", m_filename.c_str());
+            return;
+        }
+
+        ShaderCacheHeader header;
+        header.m_magic = SHADER_CACHE_MAGIC;
+        header.m_version = SHADER_CACHE_VERSION;
+        header.m_entryCount = m_entries.size();
+        header.m_reserved = 0;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const Entry &e : m_entries)
+        {
+            ShaderCacheEntry entry;
+            entry.m_key = e.m_key;
+            entry.m_format = e.m_format;
+            entry.m_size = e.m_binary.size();
+            out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            out.write(e.m_binary.data(), e.m_binary.size());
+        }
+        m_dirty = false;
+    }
+
+    uint64_t ShaderCache::GetKey(const char * const vert, const char * const frag) const
+    {
+        return HashString(HashString(m_contextHash, vert), frag);
+    }
+
+    bool ShaderCache::Load(uint64_t key, ShaderProgram *program)
+    {
+        if (!m_enabled)
+            return false;
+
+        const Entry *entry = Find(key);
+        if (!entry)
+            return false;
+
+        if (!program->LoadBinary(entry->m_binary.data(), entry->m_binary.size(), entry->m_format))
+        {
+            log::Info("ShaderCache: Binary was rejected, compiling the program");
+            Remove(key);
+            return false;
+        }
+        return true;
+    }
+
+    void ShaderCache::Store(uint64_t key, const ShaderProgram *program)
+    {
+        if (!m_enabled)
+            return;
+
+        Entry e;
+        e.m_key = key;
+        e.m_binary.resize(program->GetBinarySize());
+        if (e.m_binary.empty() || !program->GetBinary(e.m_binary.data(), e.m_binary.size(), e.m_format))
+            return;
+
+        Remove(key);
+        m_entries.push_back(std::move(e));
+        m_dirty = true;
+    }
+
+    ShaderCache::Entry* ShaderCache::Find(uint64_t key)
+    {
+        for (Entry &e : m_entries)
+        {
+            if (e.m_key == key)
+                return &e;
+        }
+        return nullptr;
+    }
+
+    void ShaderCache::Remove(uint64_t key)
+    {
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            if (m_entries[i].m_key == key)
+            {
+                m_entries.erase(m_entries.begin() + i);
+                m_dirty = true;
+                return;
+            }
+        }
+    }
+
+} // rob
@@ -0,0 +1,62 @@
+
+#ifndef H_ROB_SHADER_CACHE_H
+#define H_ROB_SHADER_CACHE_H
+
+#include "../Types.h"
+
+#include <string>
+#include <vector>
+
+namespace rob
+{
+
+    class ShaderProgram;
+
+    /// Keeps the binaries of linked shader programs in a file, so that the
+    /// programs don't have to be compiled on the next start. A binary is
+    /// found by a hash of the shader sources and the GL vendor, renderer
+    /// and version, so a driver update or a changed shader doesn't use a
+    /// stale binary.
+    class ShaderCache
+    {
+    public:
+        ShaderCache();
+        ShaderCache(const ShaderCache&) = delete;
+        ShaderCache& operator = (const ShaderCache&) = delete;
+
+        /// Reads the cache file. Needs the GL context. Does nothing if the
+        /// GL doesn't support program binaries.
+        void Open(const char * const filename);
+        /// Writes the cache file if programs were added after Open.
+        void Save();
+
+        uint64_t GetKey(const char * const vert, const char * const frag) const;
+
+        /// Links the program from the cached binary. Returns false, if there
+        /// is no binary or it was rejected, and the program must be compiled.
+        bool Load(uint64_t key, ShaderProgram *program);
+        /// Adds the binary of the linked program to the cache.
+        void Store(uint64_t key, const ShaderProgram *program);
+
+    private:
+        struct Entry
+        {
+            uint64_t m_key;
+            uint32_t m_format;
+            std::vector<char> m_binary;
+        };
+
+        Entry* Find(uint64_t key);
+        void Remove(uint64_t key);
+
+    private:
+        std::vector<Entry> m_entries;
+        std::string m_filename;
+        uint64_t m_contextHash;
+        bool m_enabled;
+        bool m_dirty;
+    };
+
+} // rob
+
+#endif // H_ROB_SHADER_CACHE_H
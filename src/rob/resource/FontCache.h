@@ -20,9 +20,11 @@ namespace rob
         ~FontCache();
 
         using ResourceCache::Get;
+        using ResourceCache::Find;
         using ResourceCache::UnloadAll;
 
         bool Load(const char * const filename, Font &font);
+        bool Load(const char *data, size_t size, Font &font);
         void Unload(Font font);
 
     private:
@@ -0,0 +1,51 @@
+
+#ifndef H_ROB_FONT_FILE_H
+#define H_ROB_FONT_FILE_H
+
+#include "../renderer/Font.h"
+#include "../Types.h"
+
+namespace rob
+{
+
+    static const uint32_t FONT_FILE_MAGIC = 0x544E4652; // "RFNT"
+    static const uint32_t FONT_FILE_VERSION = 1;
+
+    /// Header of a .font file written by FontBuilder. The header is followed by
+    ///  - the glyph table, Glyph[Font::MAX_GLYPHS] indexed by character,
+    ///  - the characters of the font, uint32_t[m_glyphCount],
+    ///  - the texture resource ids of the pages, uint32_t[m_pageCount],
+    ///  - the kerning pairs, KerningPair[m_kerningCount], sorted by the first
+    ///    and the second character.
+    /// The tables are used in place from the mapped file or resource pack.
+    struct FontFileHeader
+    {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint16_t m_base;
+        uint16_t m_height;
+        uint16_t m_horiSpacing;
+        uint16_t m_lineSpacing;
+        uint32_t m_glyphCount;
+        uint32_t m_pageCount;
+        uint32_t m_kerningCount;
+        uint32_t m_reserved;
+    };
+
+    static_assert(sizeof(FontFileHeader) == 32, "Font file header must have a fixed size");
+    static_assert(sizeof(Glyph) == 16, "Glyph must have a fixed size");
+    static_assert(sizeof(KerningPair) == 12, "Kerning pair must have a fixed size");
+
+    /// Returns the size of a font file with the counts of the header.
+    inline size_t GetFontFileSize(const FontFileHeader &header)
+    {
+        return sizeof(FontFileHeader)
+            + sizeof(Glyph) * Font::MAX_GLYPHS
+            + sizeof(uint32_t) * header.m_glyphCount
+            + sizeof(uint32_t) * header.m_pageCount
+            + sizeof(KerningPair) * header.m_kerningCount;
+    }
+
+} // rob
+
+#endif // H_ROB_FONT_FILE_H
@@ -1,8 +1,11 @@
 
 #include "MasterCache.h"
 #include "../filesystem/FilesFromDirectory.h"
+#include "../String.h"
 #include "../Log.h"
 
+#include <cstring>
+
 namespace rob
 {
 
@@ -10,9 +13,19 @@ namespace rob
         : m_textures(graphics)
         , m_sounds(audio)
         , m_fonts(graphics, this)
-        , m_resources()
+        , m_pack()
+        , m_files()
+        , m_fileIndices()
+        , m_loader()
+        , m_ticker()
+        , m_textureBudget(0)
+        , m_soundBudget(0)
     {
-        Scan("data/");
+        m_ticker.Init();
+        if (m_pack.Open("data.pak"))
+            log::Info("MasterCache: Mapped data.pak with ", m_pack.GetEntryCount(), " resources");
+        else
+            Scan("data/");
     }
 
     void MasterCache::Scan(const char * const dir)
@@ -38,44 +51,261 @@ namespace rob
                 log::Error("MasterCache: Filepath too long: ", filepath.c_str());
                 continue;
             }
-            m_resources[id] = resource;
+            if (const size_t *index = m_fileIndices.Find(id))
+            {
+                log::Error("MasterCache: Resource id collision between ", m_files[*index].m_filepath,
+                           " and ", filepath.c_str());
+                continue;
+            }
+            m_fileIndices.Insert(id, m_files.size());
+            m_files.push_back(resource);
             log::Debug("MasterCache: Found: ", filepath.c_str(), ": ", uint32_t(id));
         }
     }
 
     TextureHandle MasterCache::GetTexture(ResourceID id)
     {
-        const Resource *resource = nullptr;
-        if (FindResource(id, &resource))
-            return m_textures.Get(id, resource->m_filepath);
+        TextureHandle texture;
+        if (m_textures.Find(id, texture))
+            return texture;
+
+        Location location;
+        if (FindResource(id, location))
+        {
+            return location.m_data
+                ? m_textures.Get(id, location.m_data, location.m_size)
+                : m_textures.Get(id, location.m_name);
+        }
         ReportInvalidResource(id);
         return InvalidHandle;
     }
 
     SoundHandle MasterCache::GetSound(ResourceID id)
     {
-        const Resource *resource = nullptr;
-        if (FindResource(id, &resource))
-            return m_sounds.Get(id, resource->m_filepath);
+        SoundHandle sound;
+        if (m_sounds.Find(id, sound))
+            return sound;
+
+        Location location;
+        if (FindResource(id, location))
+        {
+            return location.m_data
+                ? m_sounds.Get(id, location.m_data, location.m_size)
+                : m_sounds.Get(id, location.m_name);
+        }
         ReportInvalidResource(id);
         return InvalidSound;
     }
 
     Font MasterCache::GetFont(ResourceID id)
     {
-        const Resource *resource = nullptr;
-        if (FindResource(id, &resource))
-            return m_fonts.Get(id, resource->m_filepath);
+        Font font;
+        if (m_fonts.Find(id, font))
+            return font;
+
+        Location location;
+        if (FindResource(id, location))
+        {
+            return location.m_data
+                ? m_fonts.Get(id, location.m_data, location.m_size)
+                : m_fonts.Get(id, location.m_name);
+        }
         ReportInvalidResource(id);
         return Font();
     }
 
-    bool MasterCache::FindResource(ResourceID id, const Resource **resource) const
+    TextureHandle MasterCache::RequestTexture(ResourceID id)
+    {
+        TextureHandle texture;
+        if (m_textures.Find(id, texture))
+            return texture;
+
+        Location location;
+        if (!FindResource(id, location))
+        {
+            ReportInvalidResource(id);
+            return InvalidHandle;
+        }
+
+        texture = m_textures.CreatePlaceholder();
+        if (!m_loader.Push(ResourceLoader::Type::Texture, id, texture, location.m_name,
+                           location.m_data, location.m_size))
+        {
+            m_textures.Unload(texture);
+            return location.m_data
+                ? m_textures.Get(id, location.m_data, location.m_size)
+                : m_textures.Get(id, location.m_name);
+        }
+        // The reference keeps the texture loaded until the upload.
+        m_textures.Insert(id, texture);
+        m_textures.AddRef(id);
+        return texture;
+    }
+
+    SoundHandle MasterCache::RequestSound(ResourceID id)
     {
-        auto it = m_resources.find(id);
-        if (it == m_resources.end())
+        SoundHandle sound;
+        if (m_sounds.Find(id, sound))
+            return sound;
+
+        Location location;
+        if (!FindResource(id, location))
+        {
+            ReportInvalidResource(id);
+            return InvalidSound;
+        }
+
+        sound = m_sounds.CreatePlaceholder();
+        if (!m_loader.Push(ResourceLoader::Type::Sound, id, sound, location.m_name,
+                           location.m_data, location.m_size))
+        {
+            m_sounds.Unload(sound);
+            return location.m_data
+                ? m_sounds.Get(id, location.m_data, location.m_size)
+                : m_sounds.Get(id, location.m_name);
+        }
+        m_sounds.Insert(id, sound);
+        m_sounds.AddRef(id);
+        return sound;
+    }
+
+    static bool HasExtension(const char *filepath, const char *ext)
+    {
+        const size_t len = StringLength(filepath);
+        const size_t extLen = StringLength(ext);
+        return len >= extLen && std::strcmp(filepath + len - extLen, ext) == 0;
+    }
+
+    bool MasterCache::IsTexture(const Location &location) const
+    { return HasExtension(location.m_name, ".tex"); }
+
+    bool MasterCache::IsSound(const Location &location) const
+    { return HasExtension(location.m_name, ".wav"); }
+
+    void MasterCache::Prefetch(const ResourceID *ids, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            Location location;
+            if (!FindResource(ids[i], location))
+            {
+                ReportInvalidResource(ids[i]);
+                continue;
+            }
+
+            if (IsTexture(location))
+                RequestTexture(ids[i]);
+            else if (IsSound(location))
+                RequestSound(ids[i]);
+            else
+                log::Info("MasterCache: Cannot prefetch ", location.m_name);
+        }
+    }
+
+    TextureHandle MasterCache::AcquireTexture(ResourceID id)
+    {
+        const TextureHandle texture = GetTexture(id);
+        m_textures.AddRef(id);
+        return texture;
+    }
+
+    void MasterCache::ReleaseTexture(ResourceID id)
+    {
+        m_textures.Release(id);
+    }
+
+    SoundHandle MasterCache::AcquireSound(ResourceID id)
+    {
+        const SoundHandle sound = GetSound(id);
+        m_sounds.AddRef(id);
+        return sound;
+    }
+
+    void MasterCache::ReleaseSound(ResourceID id)
+    {
+        m_sounds.Release(id);
+    }
+
+    void MasterCache::Acquire(const ResourceID *ids, size_t count)
+    {
+        Prefetch(ids, count);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!m_textures.AddRef(ids[i]))
+                m_sounds.AddRef(ids[i]);
+        }
+    }
+
+    void MasterCache::Release(const ResourceID *ids, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            m_textures.Release(ids[i]);
+            m_sounds.Release(ids[i]);
+        }
+    }
+
+    void MasterCache::Update(Time_t budget)
+    {
+        const Time_t start = m_ticker.GetTicks();
+        while (ResourceLoader::Job *job = m_loader.Peek())
+        {
+            UploadJob(*job);
+            m_loader.Pop();
+            if (m_ticker.GetTicks() - start >= budget)
+                break;
+        }
+
+        if (m_textureBudget > 0)
+            m_textures.Trim(m_textureBudget);
+        if (m_soundBudget > 0)
+            m_sounds.Trim(m_soundBudget);
+    }
+
+    size_t MasterCache::GetPendingCount() const
+    {
+        return m_loader.GetPendingCount();
+    }
+
+    void MasterCache::UploadJob(ResourceLoader::Job &job)
+    {
+        // If the file couldn't be read, the handle keeps its placeholder.
+        // The loader has logged the error.
+        const bool ready = (job.m_status == ResourceLoader::Status::Ready);
+        switch (job.m_type)
+        {
+        case ResourceLoader::Type::Texture:
+            if (ready) m_textures.Upload(job.m_handle, job.m_texture);
+            TextureCache::FreeTextureData(job.m_texture);
+            m_textures.Release(job.m_id);
+            break;
+        case ResourceLoader::Type::Sound:
+            if (ready) m_sounds.Upload(job.m_handle, job.m_sound);
+            AudioSystem::FreeSoundData(job.m_sound);
+            m_sounds.Release(job.m_id);
+            break;
+        }
+    }
+
+    bool MasterCache::FindResource(ResourceID id, Location &location) const
+    {
+        if (m_pack.IsOpen())
+        {
+            const PackEntry *entry = m_pack.Find(id);
+            if (!entry)
+                return false;
+            location.m_name = m_pack.GetName(entry);
+            location.m_data = m_pack.GetData(entry);
+            location.m_size = entry->m_size;
+            return true;
+        }
+
+        const size_t *index = m_fileIndices.Find(id);
+        if (!index)
             return false;
-        *resource = &it->second;
+        location.m_name = m_files[*index].m_filepath;
+        location.m_data = nullptr;
+        location.m_size = 0;
         return true;
     }
 
@@ -6,8 +6,11 @@
 #include "TextureCache.h"
 #include "SoundCache.h"
 #include "FontCache.h"
+#include "ResourceLoader.h"
+#include "ResourcePack.h"
+#include "../time/MicroTicker.h"
 
-#include <unordered_map>
+#include <vector>
 
 namespace rob
 {
@@ -15,6 +18,8 @@ namespace rob
     class Graphics;
     class AudioSystem;
 
+    /// Finds the resources from the memory mapped data.pak if there is one,
+    /// otherwise from the files in the data directory.
     class MasterCache
     {
     public:
@@ -24,21 +29,83 @@ namespace rob
         SoundHandle GetSound(ResourceID id);
         Font GetFont(ResourceID id);
 
+        /// Like GetTexture, but keeps the texture loaded until ReleaseTexture.
+        /// A handle that is kept over frames must be acquired, because an
+        /// unreferenced texture can be unloaded to stay within the budget.
+        TextureHandle AcquireTexture(ResourceID id);
+        void ReleaseTexture(ResourceID id);
+        /// Like GetSound, but keeps the sound loaded until ReleaseSound.
+        SoundHandle AcquireSound(ResourceID id);
+        void ReleaseSound(ResourceID id);
+        /// Requests the textures and sounds of the list like Prefetch, and
+        /// keeps them loaded until Release is called with the same list.
+        void Acquire(const ResourceID *ids, size_t count);
+        void Release(const ResourceID *ids, size_t count);
+
+        /// Limits the bytes of texture and sound data. When over the budget,
+        /// Update unloads unreferenced resources, least recently used first.
+        /// They are loaded again when they are used. Zero means no limit.
+        void SetTextureBudget(size_t bytes) { m_textureBudget = bytes; }
+        void SetSoundBudget(size_t bytes) { m_soundBudget = bytes; }
+        size_t GetTextureMemory() const { return m_textures.GetMemoryUsage(); }
+        size_t GetSoundMemory() const { return m_sounds.GetMemoryUsage(); }
+
+        /// Returns a texture handle right away and reads the texture on a
+        /// loader thread. Until Update uploads the image, the handle has a
+        /// transparent placeholder image.
+        TextureHandle RequestTexture(ResourceID id);
+        /// Returns a sound handle right away and decodes the sound on a
+        /// loader thread. The sound plays nothing until Update uploads it.
+        SoundHandle RequestSound(ResourceID id);
+        /// Requests the textures (.tex) and sounds (.wav) of the list.
+        void Prefetch(const ResourceID *ids, size_t count);
+
+        /// Uploads the resources the loader threads have read until the time
+        /// budget in microseconds is used. Uploads at least one resource if
+        /// there is one ready. Then unloads resources over the memory budgets.
+        /// Gets called from Game every frame.
+        void Update(Time_t budget);
+        /// Returns the number of requested resources that are not uploaded yet.
+        size_t GetPendingCount() const;
+
     private:
         TextureCache m_textures;
         SoundCache m_sounds;
         FontCache m_fonts;
 
+        ResourcePack m_pack;
+
         struct Resource
         {
             char m_filepath[260];
         };
-        std::unordered_map<uint32_t, Resource> m_resources;
+        /// The files found from the data directory when there is no pack.
+        std::vector<Resource> m_files;
+        ResourceTable<size_t> m_fileIndices;
+
+        ResourceLoader m_loader;
+        MicroTicker m_ticker;
+
+        size_t m_textureBudget;
+        size_t m_soundBudget;
+
+        /// Where the contents of a resource are found.
+        struct Location
+        {
+            /// File path, or the resource name in the pack.
+            const char *m_name;
+            /// The contents in the pack, nullptr if the resource is a file.
+            const char *m_data;
+            size_t m_size;
+        };
 
     private:
         void Scan(const char * const dir);
-        bool FindResource(ResourceID id, const Resource **resource) const;
+        bool FindResource(ResourceID id, Location &location) const;
         void ReportInvalidResource(ResourceID id) const;
+        void UploadJob(ResourceLoader::Job &job);
+        bool IsTexture(const Location &location) const;
+        bool IsSound(const Location &location) const;
     };
 
 } // rob
@@ -3,51 +3,147 @@
 #define H_ROB_RESOURCE_CACHE_H
 
 #include "ResourceID.h"
-#include <unordered_map>
-#include <vector>
+#include "ResourceTable.h"
 
 namespace rob
 {
 
+    /// Keeps the loaded resources by id. A resource stays loaded while it is
+    /// referenced. Unreferenced resources are unloaded by Trim, least
+    /// recently used first, and loaded again by the next Get.
     template <class T>
     class ResourceCache
     {
     public:
-        ResourceCache() : m_resources() { }
+        ResourceCache() : m_resources(), m_useCount(0) { }
         ResourceCache(const ResourceCache&) = delete;
         ResourceCache& operator = (const ResourceCache&) = delete;
 
         T Get(ResourceID id, const char * const filename)
         {
-            auto it = m_resources.find(id);
-            if (it != m_resources.end())
-                return it->second;
-
             T resource;
+            if (Find(id, resource))
+                return resource;
+
             if (Load(filename, resource))
-                m_resources[id] = resource;
+                Insert(id, resource);
+            return resource;
+        }
+
+        /// Like Get, but loads the resource from memory, e.g. from a resource pack.
+        T Get(ResourceID id, const char *data, size_t size)
+        {
+            T resource;
+            if (Find(id, resource))
+                return resource;
+
+            if (Load(data, size, resource))
+                Insert(id, resource);
             return resource;
         }
 
+        /// Returns a loaded resource and marks it used.
+        bool Find(ResourceID id, T &resource)
+        {
+            Entry *entry = m_resources.Find(id);
+            if (!entry)
+                return false;
+            entry->m_lastUse = ++m_useCount;
+            resource = entry->m_resource;
+            return true;
+        }
+
+        /// Adds a resource that was created outside of Load, e.g. a placeholder
+        /// that gets its data later.
+        void Insert(ResourceID id, T resource)
+        {
+            Entry entry;
+            entry.m_resource = resource;
+            entry.m_refCount = 0;
+            entry.m_lastUse = ++m_useCount;
+            m_resources.Insert(id, entry);
+        }
+
+        /// Keeps a loaded resource from being unloaded by Trim until Release.
+        bool AddRef(ResourceID id)
+        {
+            Entry *entry = m_resources.Find(id);
+            if (!entry)
+                return false;
+            entry->m_refCount++;
+            return true;
+        }
+
+        void Release(ResourceID id)
+        {
+            Entry *entry = m_resources.Find(id);
+            if (entry && entry->m_refCount > 0)
+                entry->m_refCount--;
+        }
+
+        /// Returns the bytes used by the loaded resources.
+        size_t GetMemoryUsage() const
+        {
+            size_t usage = 0;
+            m_resources.ForEach([this, &usage](uint32_t id, const Entry &entry)
+                                { usage += GetSize(entry.m_resource); });
+            return usage;
+        }
+
+        /// Unloads unreferenced resources, least recently used first, until
+        /// the resources use at most budget bytes.
+        void Trim(size_t budget)
+        {
+            size_t usage = GetMemoryUsage();
+            while (usage > budget)
+            {
+                uint32_t oldestId = 0;
+                const Entry *oldest = nullptr;
+                m_resources.ForEach([&oldestId, &oldest](uint32_t id, const Entry &entry)
+                {
+                    if (entry.m_refCount == 0 && (!oldest || entry.m_lastUse < oldest->m_lastUse))
+                    {
+                        oldestId = id;
+                        oldest = &entry;
+                    }
+                });
+                if (!oldest)
+                    break;
+
+                usage -= GetSize(oldest->m_resource);
+                Unload(oldest->m_resource);
+                m_resources.Remove(oldestId);
+            }
+        }
+
         void UnloadAll()
         {
-            for (auto it : m_resources)
-                Unload(it.second);
-            m_resources.clear();
+            m_resources.ForEach([this](uint32_t id, const Entry &entry) { Unload(entry.m_resource); });
+            m_resources.Clear();
         }
 
     protected:
         virtual bool Load(const char * const filename, T &resource) = 0;
+        virtual bool Load(const char *data, size_t size, T &resource) = 0;
         virtual void Unload(T resource) = 0;
+        /// Returns the bytes the resource uses, for Trim.
+        virtual size_t GetSize(T resource) const { return 0; }
 
     protected:
-        std::unordered_map<uint32_t, T> m_resources;
+        struct Entry
+        {
+            T m_resource;
+            uint32_t m_refCount;
+            uint32_t m_lastUse;
+        };
+        ResourceTable<Entry> m_resources;
+        uint32_t m_useCount;
     };
 
     #define ROB_DEFINE_RESOURCE_CACHE_DTOR(Class) \
         Class::~Class() \
         { \
-            if (!m_resources.empty()) \
+            if (!m_resources.IsEmpty()) \
             { \
                 log::Info(#Class ": Resources unloaded by destructor"); \
                 UnloadAll(); \
@@ -10,10 +10,12 @@ namespace rob
     static constexpr size_t seed1 = 16777619u;
     static constexpr size_t seed2 = 2166136261u;
 
+    /// FNV hash of a string literal, including the terminating zero, that
+    /// the compiler can calculate. Gives the same hash as CalculateFnv.
     template <size_t N, size_t I>
     struct FnvHash
     {
-        static uint32_t Hash(const char (&str)[N])
+        static constexpr uint32_t Hash(const char (&str)[N])
         {
             return (FnvHash<N, I-1>::Hash(str) ^ str[I-1]) * seed1;
         }
@@ -22,7 +24,7 @@ namespace rob
     template <size_t N>
     struct FnvHash<N, 1>
     {
-        static uint32_t Hash(const char (&str)[N])
+        static constexpr uint32_t Hash(const char (&str)[N])
         {
             return (seed2 ^ str[0]) * seed1;
         }
@@ -52,16 +54,18 @@ namespace rob
             const char * const m_str;
         };
 
-        ResourceID()
+        constexpr ResourceID()
             : ResourceID("")
         { }
 
-        ResourceID(uint32_t id)
+        constexpr ResourceID(uint32_t id)
             : m_id(id)
         { }
 
+        /// Hashes a string literal at compile time when the id is constexpr,
+        /// e.g. static constexpr ResourceID BG_TEXTURE = "bg.tex";
         template <size_t N>
-        ResourceID(const char (&str)[N])
+        constexpr ResourceID(const char (&str)[N])
             : m_id(FnvHash<N, N>::Hash(str))
         { }
 
@@ -69,9 +73,9 @@ namespace rob
             : m_id(CalculateFnv(str.m_str))
         { }
 
-        uint32_t GetHash() const { return m_id; }
+        constexpr uint32_t GetHash() const { return m_id; }
 
-        operator uint32_t() const { return m_id; }
+        constexpr operator uint32_t() const { return m_id; }
     };
 
 } // rob
@@ -0,0 +1,191 @@
+
+#include "ResourceLoader.h"
+
+#include "../Log.h"
+
+#include <SDL2/SDL.h>
+
+namespace rob
+{
+
+    ResourceLoader::ResourceLoader()
+        : m_threadCount(0)
+        , m_mutex(nullptr)
+        , m_jobReady(nullptr)
+        , m_first(0)
+        , m_next(0)
+        , m_end(0)
+        , m_quit(false)
+    {
+        m_mutex = ::SDL_CreateMutex();
+        m_jobReady = ::SDL_CreateCond();
+
+        for (size_t i = 0; i < MAX_LOADER_THREADS; i++)
+        {
+            SDL_Thread *thread = ::SDL_CreateThread(&ResourceLoader::ThreadMain, "ResourceLoader", this);
+            if (!thread)
+            {
+                log::Error("Could not create a resource loader thread: ", ::SDL_GetError());
+                break;
+            }
+            m_threads[m_threadCount++] = thread;
+        }
+    }
+
+    ResourceLoader::~ResourceLoader()
+    {
+        ::SDL_LockMutex(m_mutex);
+        m_quit = true;
+        ::SDL_CondBroadcast(m_jobReady);
+        ::SDL_UnlockMutex(m_mutex);
+
+        for (size_t i = 0; i < m_threadCount; i++)
+            ::SDL_WaitThread(m_threads[i], nullptr);
+
+        for (; m_first != m_end; m_first++)
+        {
+            Job &job = m_jobs[m_first % MAX_LOAD_JOBS];
+            TextureCache::FreeTextureData(job.m_texture);
+            AudioSystem::FreeSoundData(job.m_sound);
+        }
+
+        ::SDL_DestroyCond(m_jobReady);
+        ::SDL_DestroyMutex(m_mutex);
+    }
+
+    bool ResourceLoader::Push(Type type, uint32_t id, uint32_t handle, const char *filename,
+                              const char *data, size_t size)
+    {
+        ::SDL_LockMutex(m_mutex);
+        if (m_end - m_first == MAX_LOAD_JOBS)
+        {
+            ::SDL_UnlockMutex(m_mutex);
+            return false;
+        }
+
+        Job &job = m_jobs[m_end % MAX_LOAD_JOBS];
+        job.m_type = type;
+        job.m_status = Status::Queued;
+        job.m_id = id;
+        job.m_handle = handle;
+        job.m_filename = filename;
+        job.m_data = data;
+        job.m_size = size;
+        job.m_texture.m_pixels = nullptr;
+        job.m_texture.m_file = nullptr;
+        job.m_sound.m_samples = nullptr;
+        m_end++;
+
+        if (m_threadCount == 0)
+        {
+            // Without loader threads the file is read right away.
+            job.m_status = Status::Reading;
+            m_next++;
+            ::SDL_UnlockMutex(m_mutex);
+            ReadJob(job);
+            return true;
+        }
+
+        ::SDL_CondSignal(m_jobReady);
+        ::SDL_UnlockMutex(m_mutex);
+        return true;
+    }
+
+    ResourceLoader::Job* ResourceLoader::Peek()
+    {
+        Job *job = nullptr;
+        ::SDL_LockMutex(m_mutex);
+        if (m_first != m_end)
+        {
+            Job &first = m_jobs[m_first % MAX_LOAD_JOBS];
+            if (first.m_status == Status::Ready || first.m_status == Status::Failed)
+                job = &first;
+        }
+        ::SDL_UnlockMutex(m_mutex);
+        return job;
+    }
+
+    void ResourceLoader::Pop()
+    {
+        ::SDL_LockMutex(m_mutex);
+        m_first++;
+        ::SDL_UnlockMutex(m_mutex);
+    }
+
+    size_t ResourceLoader::GetPendingCount() const
+    {
+        ::SDL_LockMutex(m_mutex);
+        const size_t count = m_end - m_first;
+        ::SDL_UnlockMutex(m_mutex);
+        return count;
+    }
+
+    int ResourceLoader::ThreadMain(void *data)
+    {
+        static_cast<ResourceLoader*>(data)->RunJobs();
+        return 0;
+    }
+
+    void ResourceLoader::RunJobs()
+    {
+        ::SDL_LockMutex(m_mutex);
+        while (true)
+        {
+            while (!m_quit && m_next == m_end)
+                ::SDL_CondWait(m_jobReady, m_mutex);
+            if (m_quit)
+                break;
+
+            Job &job = m_jobs[m_next % MAX_LOAD_JOBS];
+            job.m_status = Status::Reading;
+            m_next++;
+
+            ::SDL_UnlockMutex(m_mutex);
+            ReadJob(job);
+            ::SDL_LockMutex(m_mutex);
+        }
+        ::SDL_UnlockMutex(m_mutex);
+    }
+
+    /// Reads a byte of every page, so that the pages of a mapped file are
+    /// read in on the loader thread instead of during the upload.
+    static void TouchPages(const char *data, size_t size)
+    {
+        const size_t PAGE_SIZE = 4096;
+        volatile char sum = 0;
+        for (size_t i = 0; i < size; i += PAGE_SIZE)
+            sum += data[i];
+        (void)sum;
+    }
+
+    void ResourceLoader::ReadJob(Job &job)
+    {
+        bool ok = false;
+        switch (job.m_type)
+        {
+        case Type::Texture:
+            if (job.m_data)
+            {
+                ok = TextureCache::ParseTexture(job.m_data, job.m_size, job.m_texture);
+                if (!ok) log::Error("Invalid texture ", job.m_filename);
+            }
+            else
+            {
+                ok = TextureCache::ReadTexture(job.m_filename, job.m_texture);
+            }
+            if (ok)
+                TouchPages(job.m_texture.m_pixels, job.m_texture.m_size);
+            break;
+        case Type::Sound:
+            ok = job.m_data
+                ? AudioSystem::DecodeSound(job.m_data, job.m_size, job.m_sound)
+                : AudioSystem::DecodeSound(job.m_filename, job.m_sound);
+            break;
+        }
+
+        ::SDL_LockMutex(m_mutex);
+        job.m_status = ok ? Status::Ready : Status::Failed;
+        ::SDL_UnlockMutex(m_mutex);
+    }
+
+} // rob
@@ -0,0 +1,92 @@
+
+#ifndef H_ROB_RESOURCE_LOADER_H
+#define H_ROB_RESOURCE_LOADER_H
+
+#include "TextureCache.h"
+#include "../audio/AudioSystem.h"
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+namespace rob
+{
+
+    static const size_t MAX_LOADER_THREADS = 2;
+    static const size_t MAX_LOAD_JOBS = 64;
+
+    /// Reads and decodes resource files on background threads. The results are
+    /// taken on the main thread in the order the files were queued, because
+    /// only the main thread can upload them to the graphics or audio context.
+    class ResourceLoader
+    {
+    public:
+        enum class Type
+        {
+            Texture,
+            Sound
+        };
+
+        enum class Status
+        {
+            Queued,
+            Reading,
+            Ready,
+            Failed
+        };
+
+        struct Job
+        {
+            Type m_type;
+            Status m_status;
+            uint32_t m_id;
+            uint32_t m_handle;
+            const char *m_filename;
+            const char *m_data;
+            size_t m_size;
+            TextureData m_texture;
+            SoundData m_sound;
+        };
+
+    public:
+        ResourceLoader();
+        ResourceLoader(const ResourceLoader&) = delete;
+        ResourceLoader& operator = (const ResourceLoader&) = delete;
+        ~ResourceLoader();
+
+        /// Queues a file to be read for the resource handle. If data is given,
+        /// the file contents are parsed from it instead, e.g. from a resource
+        /// pack. The filename and data must stay valid until the job is popped.
+        /// Returns false if the queue is full.
+        bool Push(Type type, uint32_t id, uint32_t handle, const char *filename,
+                  const char *data = nullptr, size_t size = 0);
+
+        /// Returns the oldest queued job if it has been read, nullptr otherwise.
+        Job* Peek();
+        /// Removes the job returned by Peek. Its data must have been released.
+        void Pop();
+
+        size_t GetPendingCount() const;
+
+    private:
+        static int ThreadMain(void *data);
+        void RunJobs();
+        void ReadJob(Job &job);
+
+    private:
+        SDL_Thread *m_threads[MAX_LOADER_THREADS];
+        size_t m_threadCount;
+
+        SDL_mutex *m_mutex;
+        SDL_cond *m_jobReady;
+
+        Job m_jobs[MAX_LOAD_JOBS];
+        size_t m_first;
+        size_t m_next;
+        size_t m_end;
+        bool m_quit;
+    };
+
+} // rob
+
+#endif // H_ROB_RESOURCE_LOADER_H
@@ -0,0 +1,62 @@
+
+#include "ResourcePack.h"
+
+#include "../Log.h"
+
+#include <algorithm>
+
+namespace rob
+{
+
+    ResourcePack::ResourcePack()
+        : m_file()
+        , m_entries(nullptr)
+        , m_entryCount(0)
+    { }
+
+    bool ResourcePack::Open(const char * const filename)
+    {
+        if (!m_file.Open(filename))
+            return false;
+
+        const size_t size = m_file.GetSize();
+        const PackHeader *header = reinterpret_cast<const PackHeader*>(m_file.GetData());
+        if (size < sizeof(PackHeader) ||
+            header->m_magic != RESOURCE_PACK_MAGIC ||
+            header->m_version != RESOURCE_PACK_VERSION ||
+            (size - sizeof(PackHeader)) / sizeof(PackEntry) < header->m_entryCount)
+        {
+            log::Error("Invalid resource pack ", filename);
+            m_file.Close();
+            return false;
+        }
+
+        const PackEntry *entries = reinterpret_cast<const PackEntry*>(header + 1);
+        for (size_t i = 0; i < header->m_entryCount; i++)
+        {
+            const PackEntry &entry = entries[i];
+            if (entry.m_nameOffset >= size || entry.m_offset > size ||
+                entry.m_size > size - entry.m_offset)
+            {
+                log::Error("Invalid entry in resource pack ", filename);
+                m_file.Close();
+                return false;
+            }
+        }
+
+        m_entries = entries;
+        m_entryCount = header->m_entryCount;
+        return true;
+    }
+
+    const PackEntry* ResourcePack::Find(ResourceID id) const
+    {
+        const PackEntry *end = m_entries + m_entryCount;
+        const PackEntry *it = std::lower_bound(m_entries, end, uint32_t(id),
+            [](const PackEntry &entry, uint32_t id) { return entry.m_id < id; });
+        if (it == end || it->m_id != uint32_t(id))
+            return nullptr;
+        return it;
+    }
+
+} // rob
@@ -0,0 +1,63 @@
+
+#ifndef H_ROB_RESOURCE_PACK_H
+#define H_ROB_RESOURCE_PACK_H
+
+#include "ResourceID.h"
+#include "../filesystem/MappedFile.h"
+
+namespace rob
+{
+
+    static const uint32_t RESOURCE_PACK_MAGIC = 0x4B415052; // "RPAK"
+    static const uint32_t RESOURCE_PACK_VERSION = 1;
+    /// Alignment of the resource data in the pack.
+    static const size_t RESOURCE_PACK_ALIGN = 16;
+
+    /// The pack starts with the header, followed by the entries sorted by
+    /// resource id, the zero terminated resource names and the aligned data.
+    struct PackHeader
+    {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_entryCount;
+        uint32_t m_reserved;
+    };
+
+    struct PackEntry
+    {
+        uint32_t m_id;
+        uint32_t m_nameOffset;
+        uint32_t m_offset;
+        uint32_t m_size;
+    };
+
+    /// A memory mapped resource pack built by MasterBuilder::BuildPack.
+    class ResourcePack
+    {
+    public:
+        ResourcePack();
+        ResourcePack(const ResourcePack&) = delete;
+        ResourcePack& operator = (const ResourcePack&) = delete;
+
+        bool Open(const char * const filename);
+        bool IsOpen() const { return m_entries != nullptr; }
+
+        /// Finds the entry of the resource by binary search, nullptr if there is none.
+        const PackEntry* Find(ResourceID id) const;
+
+        const char* GetName(const PackEntry *entry) const
+        { return m_file.GetData() + entry->m_nameOffset; }
+        const char* GetData(const PackEntry *entry) const
+        { return m_file.GetData() + entry->m_offset; }
+
+        size_t GetEntryCount() const { return m_entryCount; }
+
+    private:
+        MappedFile m_file;
+        const PackEntry *m_entries;
+        size_t m_entryCount;
+    };
+
+} // rob
+
+#endif // H_ROB_RESOURCE_PACK_H
@@ -0,0 +1,150 @@
+
+#ifndef H_ROB_RESOURCE_TABLE_H
+#define H_ROB_RESOURCE_TABLE_H
+
+#include "../Types.h"
+
+namespace rob
+{
+
+    /// An open addressing hash table from resource ids to values. The ids are
+    /// hashes already, so the low bits of an id give its slot directly and
+    /// with the load kept under a half most lookups probe a single slot.
+    template <class T>
+    class ResourceTable
+    {
+    public:
+        ResourceTable()
+            : m_slots(nullptr)
+            , m_capacity(0)
+            , m_size(0)
+        { }
+
+        ResourceTable(const ResourceTable&) = delete;
+        ResourceTable& operator = (const ResourceTable&) = delete;
+
+        ~ResourceTable()
+        { delete[] m_slots; }
+
+        T* Find(uint32_t id)
+        {
+            if (m_capacity == 0)
+                return nullptr;
+            const size_t mask = m_capacity - 1;
+            for (size_t i = id & mask; m_slots[i].m_used; i = (i + 1) & mask)
+            {
+                if (m_slots[i].m_id == id)
+                    return &m_slots[i].m_value;
+            }
+            return nullptr;
+        }
+
+        const T* Find(uint32_t id) const
+        { return const_cast<ResourceTable*>(this)->Find(id); }
+
+        /// Adds the value, or replaces the value if the id is in the table.
+        void Insert(uint32_t id, const T &value)
+        {
+            if ((m_size + 1) * 2 > m_capacity)
+                Grow();
+            const size_t mask = m_capacity - 1;
+            size_t i = id & mask;
+            for (; m_slots[i].m_used; i = (i + 1) & mask)
+            {
+                if (m_slots[i].m_id == id)
+                {
+                    m_slots[i].m_value = value;
+                    return;
+                }
+            }
+            m_slots[i].m_id = id;
+            m_slots[i].m_used = true;
+            m_slots[i].m_value = value;
+            m_size++;
+        }
+
+        /// Removes the value of the id, if it is in the table. The values after
+        /// it in the probe sequence are moved back, so no tombstones are left.
+        void Remove(uint32_t id)
+        {
+            if (m_capacity == 0)
+                return;
+            const size_t mask = m_capacity - 1;
+            size_t i = id & mask;
+            for (; m_slots[i].m_used; i = (i + 1) & mask)
+            {
+                if (m_slots[i].m_id == id)
+                    break;
+            }
+            if (!m_slots[i].m_used)
+                return;
+
+            for (size_t j = (i + 1) & mask; m_slots[j].m_used; j = (j + 1) & mask)
+            {
+                // The slot can move to the hole if its home slot isn't
+                // cyclically between the hole and the slot.
+                const size_t home = m_slots[j].m_id & mask;
+                if (((j - home) & mask) >= ((j - i) & mask))
+                {
+                    m_slots[i] = m_slots[j];
+                    i = j;
+                }
+            }
+            m_slots[i] = Slot();
+            m_size--;
+        }
+
+        void Clear()
+        {
+            for (size_t i = 0; i < m_capacity; i++)
+                m_slots[i] = Slot();
+            m_size = 0;
+        }
+
+        bool IsEmpty() const { return m_size == 0; }
+        size_t GetSize() const { return m_size; }
+
+        /// Calls func(id, value) for every value in the table.
+        template <class Func>
+        void ForEach(Func func) const
+        {
+            for (size_t i = 0; i < m_capacity; i++)
+            {
+                if (m_slots[i].m_used)
+                    func(m_slots[i].m_id, m_slots[i].m_value);
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t m_id = 0;
+            bool m_used = false;
+            T m_value = T();
+        };
+
+        void Grow()
+        {
+            Slot *slots = m_slots;
+            const size_t capacity = m_capacity;
+
+            m_capacity = (capacity == 0) ? 16 : capacity * 2;
+            m_slots = new Slot[m_capacity];
+            m_size = 0;
+            for (size_t i = 0; i < capacity; i++)
+            {
+                if (slots[i].m_used)
+                    Insert(slots[i].m_id, slots[i].m_value);
+            }
+            delete[] slots;
+        }
+
+    private:
+        Slot *m_slots;
+        size_t m_capacity;
+        size_t m_size;
+    };
+
+} // rob
+
+#endif // H_ROB_RESOURCE_TABLE_H
@@ -17,9 +17,39 @@ namespace rob
         return (sound = m_audio->LoadSound(filename)) != InvalidSound;
     }
 
+    bool SoundCache::Load(const char *data, size_t size, SoundHandle &sound)
+    {
+        SoundData soundData;
+        if (!AudioSystem::DecodeSound(data, size, soundData))
+        {
+            sound = InvalidSound;
+            return false;
+        }
+
+        sound = m_audio->CreateSound();
+        m_audio->UploadSound(sound, soundData);
+        AudioSystem::FreeSoundData(soundData);
+        return true;
+    }
+
     void SoundCache::Unload(SoundHandle sound)
     {
         m_audio->UnloadSound(sound);
     }
 
+    size_t SoundCache::GetSize(SoundHandle sound) const
+    {
+        return m_audio->GetSoundSize(sound);
+    }
+
+    SoundHandle SoundCache::CreatePlaceholder()
+    {
+        return m_audio->CreateSound();
+    }
+
+    void SoundCache::Upload(SoundHandle sound, const SoundData &data)
+    {
+        m_audio->UploadSound(sound, data);
+    }
+
 } // rob
@@ -17,10 +17,22 @@ namespace rob
         ~SoundCache();
 
         using ResourceCache::Get;
+        using ResourceCache::Find;
+        using ResourceCache::Insert;
+        using ResourceCache::AddRef;
+        using ResourceCache::Release;
+        using ResourceCache::GetMemoryUsage;
+        using ResourceCache::Trim;
         using ResourceCache::UnloadAll;
 
         bool Load(const char * const filename, SoundHandle &sound);
+        bool Load(const char *data, size_t size, SoundHandle &sound);
         void Unload(SoundHandle sound);
+        size_t GetSize(SoundHandle sound) const;
+
+        /// Creates a sound that plays nothing until its samples are uploaded.
+        SoundHandle CreatePlaceholder();
+        void Upload(SoundHandle sound, const SoundData &data);
 
     private:
         AudioSystem *m_audio;
@@ -1,12 +1,12 @@
 
 #include "TextureCache.h"
+#include "TextureFile.h"
 #include "../graphics/Graphics.h"
-#include "../graphics/Texture.h"
-#include "../memory/LinearAllocator.h"
+#include "../filesystem/MappedFile.h"
 
 #include "../Log.h"
 
-#include <fstream>
+#include <cstring>
 
 namespace rob
 {
@@ -19,45 +19,143 @@ namespace rob
 
     bool TextureCache::Load(const char * const filename, TextureHandle &texture)
     {
-        std::ifstream in(filename, std::ios_base::binary);
-        if (!in.is_open())
+        TextureData data;
+        if (!ReadTexture(filename, data))
+        {
+            texture = InvalidHandle;
+            return false;
+        }
+
+        texture = m_graphics->CreateTexture();
+        Upload(texture, data);
+        FreeTextureData(data);
+        return true;
+    }
+
+    bool TextureCache::Load(const char *file, size_t size, TextureHandle &texture)
+    {
+        TextureData data;
+        if (!ParseTexture(file, size, data))
+        {
+            log::Error("Invalid texture data");
+            texture = InvalidHandle;
+            return false;
+        }
+
+        texture = m_graphics->CreateTexture();
+        Upload(texture, data);
+        return true;
+    }
+
+    void TextureCache::Unload(TextureHandle texture)
+    {
+        m_graphics->DestroyTexture(texture);
+    }
+
+    size_t TextureCache::GetSize(TextureHandle texture) const
+    {
+        const Texture *t = m_graphics->GetTexture(texture);
+        return t->GetSize();
+    }
+
+    bool TextureCache::ReadTexture(const char * const filename, TextureData &data)
+    {
+        data.m_pixels = nullptr;
+        data.m_file = nullptr;
+
+        MappedFile *file = new MappedFile();
+        if (!file->Open(filename))
         {
             log::Error("Could not open texture file ", filename);
-            return InvalidHandle;
+            delete file;
+            return false;
         }
 
-        size_t width = 0;
-        size_t height = 0;
-        size_t st_format = 0;
-        in.read(reinterpret_cast<char*>(&width), sizeof(size_t));
-        in.read(reinterpret_cast<char*>(&height), sizeof(size_t));
-        in.read(reinterpret_cast<char*>(&st_format), sizeof(size_t));
-        if (!in)
+        if (!ParseTexture(file->GetData(), file->GetSize(), data))
         {
             log::Error("Invalid texture file ", filename);
-            texture = InvalidHandle;
+            delete file;
             return false;
         }
-        const size_t imageSize = width * height * st_format;
 
-        const size_t IMAGE_DATA_ALIGN = 4;
-        LinearAllocator alloc(imageSize + IMAGE_DATA_ALIGN - 1);
-        char *imageData = static_cast<char*>(alloc.Allocate(imageSize, IMAGE_DATA_ALIGN));
+        data.m_file = file;
+        return true;
+    }
 
-        in.read(imageData, imageSize);
+    bool TextureCache::ParseTexture(const char *file, size_t size, TextureData &data)
+    {
+        data.m_pixels = nullptr;
+        data.m_file = nullptr;
 
-        texture = m_graphics->CreateTexture();
+        if (size < sizeof(TextureFileHeader))
+            return false;
+
+        TextureFileHeader header;
+        std::memcpy(&header, file, sizeof(header));
+        if (header.m_magic != TEXTURE_FILE_MAGIC || header.m_version != TEXTURE_FILE_VERSION)
+            return false;
+        if (header.m_format < Texture::FMT_RGB || header.m_format > Texture::FMT_BC3)
+            return false;
+        if (header.m_levelCount == 0 || header.m_levelCount > Texture::MAX_LEVELS)
+            return false;
+        if (header.m_dataSize > size - sizeof(header) ||
+            header.m_levelCount * sizeof(TextureFileLevel) > header.m_dataSize)
+            return false;
+
+        const Texture::Format format = static_cast<Texture::Format>(header.m_format);
+        const size_t fileSize = sizeof(header) + header.m_dataSize;
+        for (size_t i = 0; i < header.m_levelCount; i++)
+        {
+            TextureFileLevel level;
+            std::memcpy(&level, file + sizeof(header) + i * sizeof(level), sizeof(level));
+
+            const size_t width = (header.m_width >> i) ? (header.m_width >> i) : 1;
+            const size_t height = (header.m_height >> i) ? (header.m_height >> i) : 1;
+            if (level.m_offset > fileSize || level.m_size > fileSize - level.m_offset ||
+                level.m_size < Texture::GetImageSize(width, height, format))
+                return false;
+            data.m_levels[i] = file + level.m_offset;
+        }
+
+        data.m_width = header.m_width;
+        data.m_height = header.m_height;
+        data.m_format = format;
+        data.m_pixels = file + sizeof(header);
+        data.m_size = header.m_dataSize;
+        data.m_levelCount = header.m_levelCount;
+        return true;
+    }
+
+    void TextureCache::FreeTextureData(TextureData &data)
+    {
+        delete data.m_file;
+        data.m_file = nullptr;
+        data.m_pixels = nullptr;
+    }
+
+    TextureHandle TextureCache::CreatePlaceholder()
+    {
+        static const uint8_t pixel[4] = { 0, 0, 0, 0 };
+        const TextureHandle texture = m_graphics->CreateTexture();
         m_graphics->BindTexture(0, texture);
         Texture *t = m_graphics->GetTexture(texture);
-        t->TexImage(width, height, static_cast<Texture::Format>(st_format), imageData);
+        t->TexImage(1, 1, Texture::FMT_RGBA, pixel);
         m_graphics->BindTexture(0, InvalidHandle);
-
-        return true;
+        return texture;
     }
 
-    void TextureCache::Unload(TextureHandle texture)
+    void TextureCache::Upload(TextureHandle texture, const TextureData &data)
     {
-        m_graphics->DestroyTexture(texture);
+        m_graphics->BindTexture(0, texture);
+        Texture *t = m_graphics->GetTexture(texture);
+        for (size_t i = 0; i < data.m_levelCount; i++)
+        {
+            const size_t width = (data.m_width >> i) ? (data.m_width >> i) : 1;
+            const size_t height = (data.m_height >> i) ? (data.m_height >> i) : 1;
+            t->TexLevel(i, width, height, data.m_format, data.m_levels[i]);
+        }
+        t->SetLevelCount(data.m_levelCount);
+        m_graphics->BindTexture(0, InvalidHandle);
     }
 
 } // rob
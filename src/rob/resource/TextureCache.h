@@ -4,11 +4,30 @@
 
 #include "ResourceCache.h"
 #include "../graphics/GraphicsTypes.h"
+#include "../graphics/Texture.h"
 
 namespace rob
 {
 
     class Graphics;
+    class MappedFile;
+
+    /// Image data of a texture file, see TextureCache::ReadTexture.
+    struct TextureData
+    {
+        size_t m_width;
+        size_t m_height;
+        Texture::Format m_format;
+        /// The level data after the file header.
+        const char *m_pixels;
+        size_t m_size;
+        /// The mip levels, level 0 is the full size image.
+        const char *m_levels[Texture::MAX_LEVELS];
+        size_t m_levelCount;
+        /// The mapping of the texture file if it was opened for this data,
+        /// nullptr if the pixels point to memory owned by someone else.
+        MappedFile *m_file;
+    };
 
     class TextureCache : private ResourceCache<TextureHandle>
     {
@@ -19,10 +38,32 @@ namespace rob
         ~TextureCache();
 
         using ResourceCache::Get;
+        using ResourceCache::Find;
+        using ResourceCache::Insert;
+        using ResourceCache::AddRef;
+        using ResourceCache::Release;
+        using ResourceCache::GetMemoryUsage;
+        using ResourceCache::Trim;
         using ResourceCache::UnloadAll;
 
         bool Load(const char * const filename, TextureHandle &texture);
+        bool Load(const char *data, size_t size, TextureHandle &texture);
         void Unload(TextureHandle texture);
+        size_t GetSize(TextureHandle texture) const;
+
+        /// Maps the texture file to memory. Doesn't use the graphics context,
+        /// so it can be called from any thread. The data must be released with
+        /// FreeTextureData.
+        static bool ReadTexture(const char * const filename, TextureData &data);
+        /// Checks the header of texture file contents in memory, see
+        /// TextureFileHeader. The pixels point to the given memory.
+        static bool ParseTexture(const char *file, size_t size, TextureData &data);
+        static void FreeTextureData(TextureData &data);
+
+        /// Creates a texture with a transparent 1x1 image.
+        TextureHandle CreatePlaceholder();
+        /// Replaces the image of the texture.
+        void Upload(TextureHandle texture, const TextureData &data);
 
     private:
         Graphics *m_graphics;
@@ -31,4 +72,3 @@ namespace rob
 } // rob
 
 #endif // H_ROB_TEXTURE_CACHE_H
-
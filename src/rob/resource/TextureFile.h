@@ -0,0 +1,49 @@
+
+#ifndef H_ROB_TEXTURE_FILE_H
+#define H_ROB_TEXTURE_FILE_H
+
+#include "../Types.h"
+
+namespace rob
+{
+
+    static const uint32_t TEXTURE_FILE_MAGIC = 0x58455452; // "RTEX"
+    static const uint32_t TEXTURE_FILE_VERSION = 2;
+    /// Rows of uncompressed levels are padded to the default GL unpack alignment.
+    static const uint32_t TEXTURE_ROW_ALIGN = 4;
+    /// Alignment of the levels in a texture file.
+    static const uint32_t TEXTURE_LEVEL_ALIGN = 16;
+
+    /// Header of a .tex file written by TextureBuilder. The header is followed
+    /// by a TextureFileLevel for each mip level, and then by the levels. Each
+    /// level has the image rows bottom row first, or the S3TC blocks of the
+    /// image, so that the data of a mapped file can be given straight to GL.
+    /// The fields have fixed widths.
+    struct TextureFileHeader
+    {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_width;
+        uint32_t m_height;
+        /// See Texture::Format.
+        uint32_t m_format;
+        /// Number of mip levels, level 0 is the full size image.
+        uint32_t m_levelCount;
+        /// Bytes of level table and level data after the header.
+        uint32_t m_dataSize;
+        uint32_t m_reserved;
+    };
+
+    struct TextureFileLevel
+    {
+        /// Offset of the level from the start of the file.
+        uint32_t m_offset;
+        uint32_t m_size;
+    };
+
+    static_assert(sizeof(TextureFileHeader) == 32, "Texture file header must have a fixed size");
+    static_assert(sizeof(TextureFileLevel) == 8, "Texture file level must have a fixed size");
+
+} // rob
+
+#endif // H_ROB_TEXTURE_FILE_H
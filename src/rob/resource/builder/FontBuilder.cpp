@@ -0,0 +1,239 @@
+
+#include "FontBuilder.h"
+#include "BmfFont.internal.h"
+#include "../FontFile.h"
+#include "../ResourceID.h"
+#include "../../util/StreamUtil.h"
+#include "../../Log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace rob
+{
+
+    FontBuilder::FontBuilder()
+    {
+        m_extensions.push_back(".fnt");
+        m_newExtension = ".font";
+    }
+
+    /// The pages are built to textures with the .tex extension.
+    static std::string ChangePageTextureExtension(const std::string &pageName)
+    {
+        const size_t pos = pageName.rfind('.');
+        return pageName.substr(0, pos) + ".tex";
+    }
+
+    static bool ReadBmf(std::istream &in, const std::string &filename, FontFileHeader &header,
+                        Glyph (&glyphs)[Font::MAX_GLYPHS], std::vector<uint32_t> &glyphMapping,
+                        std::vector<uint32_t> &pages, std::vector<KerningPair> &kerningPairs)
+    {
+        static constexpr uint8_t BmfVersion = 3;
+
+        if (! (ReadValue<uint8_t>(in) == 'B'
+            && ReadValue<uint8_t>(in) == 'M'
+            && ReadValue<uint8_t>(in) == 'F'))
+        {
+            log::Error("Invalid BMFont file header in ", filename.c_str());
+            return false;
+        }
+
+        const uint8_t version = ReadValue<uint8_t>(in);
+        if (version != BmfVersion)
+        {
+            log::Error("Wrong BMFont version in ", filename.c_str(), ". Expected ",
+                       static_cast<unsigned int>(BmfVersion), ", found ", static_cast<unsigned int>(version));
+            return false;
+        }
+
+        size_t pageCount = 0;
+
+        while (in)
+        {
+            const uint8_t block_type = ReadValue<uint8_t>(in);
+            if (in.eof()) break;
+            const uint32_t block_size = ReadValue<uint32_t>(in);
+            const std::ios::streampos blockStart = in.tellg();
+
+            switch (block_type)
+            {
+            case BmfInfoBlock::TYPE:
+                {
+                    BmfInfoBlock block;
+                    block.font_size         = ReadValue<int16_t>(in);
+                    block.bit_field         = ReadValue<uint8_t>(in);
+                    block.char_set          = ReadValue<uint8_t>(in);
+                    block.stretch_h         = ReadValue<uint16_t>(in);
+                    block.anti_aliasing     = ReadValue<uint8_t>(in);
+                    block.padding_up        = ReadValue<uint8_t>(in);
+                    block.padding_right     = ReadValue<uint8_t>(in);
+                    block.padding_down      = ReadValue<uint8_t>(in);
+                    block.padding_left      = ReadValue<uint8_t>(in);
+                    block.spacing_horizontal = ReadValue<uint8_t>(in);
+                    block.spacing_vertical  = ReadValue<uint8_t>(in);
+                    block.outline           = ReadValue<uint8_t>(in);
+
+                    header.m_lineSpacing = block.spacing_vertical;
+                }
+                break;
+
+            case BmfCommonBlock::TYPE:
+                {
+                    BmfCommonBlock block;
+                    block.line_height    = ReadValue<uint16_t>(in);
+                    block.base           = ReadValue<uint16_t>(in);
+                    block.scale_w        = ReadValue<uint16_t>(in);
+                    block.scale_h        = ReadValue<uint16_t>(in);
+                    block.pages          = ReadValue<uint16_t>(in);
+                    block.bit_field      = ReadValue<uint8_t>(in);
+                    block.alpha_channel  = ReadValue<uint8_t>(in);
+                    block.red_channel    = ReadValue<uint8_t>(in);
+                    block.green_channel  = ReadValue<uint8_t>(in);
+                    block.blue_channel   = ReadValue<uint8_t>(in);
+                    pageCount = block.pages;
+
+                    header.m_base = block.base;
+                    header.m_height = block.line_height;
+                }
+                break;
+
+            case BmfPageBlock::TYPE:
+                {
+                    if (pageCount > Font::MAX_TEXTURE_PAGES)
+                    {
+                        log::Error("Too many pages in ", filename.c_str(), ": ", pageCount);
+                        return false;
+                    }
+                    for (size_t i = 0; i < pageCount; i++)
+                    {
+                        std::string pageName;
+                        std::getline(in, pageName, '\0');
+                        pages.push_back(ResourceID(ChangePageTextureExtension(pageName).c_str()));
+                    }
+                }
+                break;
+
+            case BmfCharBlock::TYPE:
+                {
+                    const size_t characterCount = block_size / 20;
+                    for (size_t i = 0; i < characterCount; i++)
+                    {
+                        BmfCharBlock block;
+                        block.id        = ReadValue<uint32_t>(in);
+                        block.x         = ReadValue<uint16_t>(in);
+                        block.y         = ReadValue<uint16_t>(in);
+                        block.width     = ReadValue<uint16_t>(in);
+                        block.height    = ReadValue<uint16_t>(in);
+                        block.offset_x  = ReadValue<int16_t>(in);
+                        block.offset_y  = ReadValue<int16_t>(in);
+                        block.advance_x = ReadValue<uint16_t>(in);
+                        block.page      = ReadValue<uint8_t>(in);
+                        block.channel   = ReadValue<uint8_t>(in);
+
+                        if (block.id >= Font::MAX_GLYPHS || glyphs[block.id].m_textureIdx != uint16_t(-1))
+                        {
+                            log::Info("Skipped character ", block.id, " of ", filename.c_str());
+                            continue;
+                        }
+
+                        Glyph &glyph = glyphs[block.id];
+                        glyph.m_x       = block.x;
+                        glyph.m_y       = block.y;
+                        glyph.m_width   = block.width;
+                        glyph.m_height  = block.height;
+                        glyph.m_offsetX = block.offset_x;
+                        glyph.m_offsetY = block.offset_y;
+                        glyph.m_advance = block.advance_x;
+                        glyph.m_textureIdx = block.page;
+
+                        glyphMapping.push_back(block.id);
+                    }
+                }
+                break;
+
+            case BmfKerningPairBlock::TYPE:
+                {
+                    const size_t pairCount = block_size / 10;
+                    for (size_t i = 0; i < pairCount; i++)
+                    {
+                        BmfKerningPairBlock block;
+                        block.first = ReadValue<uint32_t>(in);
+                        block.second = ReadValue<uint32_t>(in);
+                        block.amount = ReadValue<int16_t>(in);
+
+                        KerningPair pair;
+                        pair.m_first = block.first;
+                        pair.m_second = block.second;
+                        pair.m_amount = block.amount;
+                        pair.m_padding = 0;
+                        kerningPairs.push_back(pair);
+                    }
+                }
+                break;
+
+            default:
+                log::Error("Invalid BMFont block type ", static_cast<unsigned int>(block_type),
+                           " in ", filename.c_str());
+                return false;
+            }
+
+            // Skips the rest of the block, e.g. the font name of the info block.
+            in.seekg(blockStart + std::ios::streamoff(block_size), std::ios::beg);
+        }
+
+        std::sort(kerningPairs.begin(), kerningPairs.end(), [](const KerningPair &a, const KerningPair &b)
+                  { return a.m_first < b.m_first || (a.m_first == b.m_first && a.m_second < b.m_second); });
+        return true;
+    }
+
+    bool FontBuilder::Build(const std::string &directory, const std::string &filename,
+                            const std::string &destDirectory, const std::string &destFilename)
+    {
+        std::ifstream in(filename.c_str(), std::ios::binary);
+        if (!in.is_open())
+        {
+            log::Error("Could not open font file ", filename.c_str());
+            return false;
+        }
+
+        FontFileHeader header;
+        header.m_magic = FONT_FILE_MAGIC;
+        header.m_version = FONT_FILE_VERSION;
+        header.m_base = 0;
+        header.m_height = 0;
+        header.m_horiSpacing = 0;
+        header.m_lineSpacing = 0;
+        header.m_reserved = 0;
+
+        Glyph glyphs[Font::MAX_GLYPHS] = { };
+        for (size_t i = 0; i < Font::MAX_GLYPHS; i++)
+            glyphs[i].m_textureIdx = -1;
+
+        std::vector<uint32_t> glyphMapping;
+        std::vector<uint32_t> pages;
+        std::vector<KerningPair> kerningPairs;
+        if (!ReadBmf(in, filename, header, glyphs, glyphMapping, pages, kerningPairs))
+            return false;
+
+        header.m_glyphCount = glyphMapping.size();
+        header.m_pageCount = pages.size();
+        header.m_kerningCount = kerningPairs.size();
+
+        std::ofstream out(destFilename.c_str(), std::ios_base::binary);
+        if (!out.is_open())
+        {
+            log::Error("Could not open the destination file for font ", destFilename.c_str());
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(glyphs), sizeof(glyphs));
+        out.write(reinterpret_cast<const char*>(glyphMapping.data()), glyphMapping.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(pages.data()), pages.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(kerningPairs.data()), kerningPairs.size() * sizeof(KerningPair));
+        return bool(out);
+    }
+
+} // rob
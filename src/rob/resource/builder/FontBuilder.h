@@ -0,0 +1,22 @@
+
+#ifndef H_ROB_FONT_BUILDER_H
+#define H_ROB_FONT_BUILDER_H
+
+#include "ResourceBuilder.h"
+
+namespace rob
+{
+
+    /// Converts BMFont binary files (.fnt) to font files (.font) that have
+    /// the glyph table ready for use, see FontFile.h.
+    class FontBuilder : public ResourceBuilder
+    {
+    public:
+        FontBuilder();
+        bool Build(const std::string &directory, const std::string &filename,
+                   const std::string &destDirectory, const std::string &destFilename) override;
+    };
+
+} // rob
+
+#endif // H_ROB_FONT_BUILDER_H
@@ -1,35 +1,280 @@
 
 #include "MasterBuilder.h"
 #include "../../filesystem/FilesFromDirectory.h"
+#include "../../filesystem/FileStat.h"
+#include "../../memory/PtrAlign.h"
+#include "../../thread/TaskPool.h"
+#include "../../time/MicroTicker.h"
 #include "../../Log.h"
+#include "../ResourcePack.h"
 
 #include "TextureBuilder.h"
+#include "FontBuilder.h"
 #include "ResourceCopier.h"
 
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+
 namespace rob
 {
 
     TextureBuilder  g_textureBuilder;
+    FontBuilder     g_fontBuilder;
     ResourceCopier  g_resourceCopier;
 
+    /// A file that needs building, see MasterBuilder::Build.
+    struct BuildJob
+    {
+        ResourceBuilder *m_builder;
+        std::string m_sourceFile;
+        std::string m_destFile;
+        const std::string *m_file;
+        uint64_t m_hash;
+        Time_t m_time;
+        bool m_result;
+    };
+
+    struct BuildContext
+    {
+        std::vector<BuildJob> *m_jobs;
+        const char *m_source;
+        const char *m_dest;
+        MicroTicker *m_ticker;
+    };
+
+    /// FNV-1a hash of the file contents and the builder version.
+    static uint64_t HashFile(const std::string &filename, uint32_t version)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        const auto add = [&hash](uint8_t byte) { hash = (hash ^ byte) * 1099511628211ull; };
+
+        for (size_t i = 0; i < sizeof(version); i++)
+            add(uint8_t(version >> (i * 8)));
+
+        std::ifstream in(filename.c_str(), std::ios_base::binary);
+        char buf[4096];
+        while (in)
+        {
+            in.read(buf, sizeof(buf));
+            const size_t size = in.gcount();
+            for (size_t i = 0; i < size; i++)
+                add(uint8_t(buf[i]));
+        }
+        return hash;
+    }
+
+    static void ReadManifest(const std::string &filename, std::unordered_map<std::string, uint64_t> &manifest)
+    {
+        std::ifstream in(filename.c_str());
+        std::string file;
+        uint64_t hash;
+        while (in >> std::hex >> hash && std::getline(in >> std::ws, file))
+            manifest[file] = hash;
+    }
+
+    static void WriteManifest(const std::string &filename, const std::unordered_map<std::string, uint64_t> &manifest)
+    {
+        std::ofstream out(filename.c_str());
+        if (!out.is_open())
+        {
+            log::Error("Could not write build manifest ", filename.c_str());
+            return;
+        }
+        for (const auto &entry : manifest)
+            out << std::hex << entry.second << ' ' << entry.first << '\n';
+    }
+
+    static void BuildFiles(void *context, int begin, int end, int threadIndex)
+    {
+        BuildContext *ctx = static_cast<BuildContext*>(context);
+        for (int i = begin; i < end; i++)
+        {
+            BuildJob &job = (*ctx->m_jobs)[i];
+            const Time_t start = ctx->m_ticker->GetTicks();
+            job.m_result = job.m_builder->Build(ctx->m_source, job.m_sourceFile, ctx->m_dest, job.m_destFile);
+            job.m_time = ctx->m_ticker->GetTicks() - start;
+        }
+    }
+
+    void MasterBuilder::SetTextureCompression(bool compress)
+    {
+        g_textureBuilder.SetCompression(compress);
+    }
+
     void MasterBuilder::Build(const char * const source, const char * const dest)
     {
         std::vector<std::string> files;
         GetFilesFromDirectory(source, files, true);
 
+        const std::string manifestFile = std::string(dest) + ".manifest";
+        std::unordered_map<std::string, uint64_t> manifest;
+        ReadManifest(manifestFile, manifest);
+
+        std::vector<BuildJob> jobs;
         for (const std::string &file : files)
         {
-            const std::string sourceFile = std::string(source) + "/" + file;
+            BuildJob job;
+            job.m_sourceFile = std::string(source) + "/" + file;
             const std::string destFile = std::string(dest) + "/" + file;
 
             ResourceBuilder *builder = ResourceBuilder::m_tail;
-            while (builder)
-            {
-                if (builder->TryBuild(source, sourceFile, dest, destFile))
-                    break;
+            while (builder && !builder->Accepts(job.m_sourceFile, destFile, job.m_destFile))
                 builder = builder->m_next;
+            if (!builder)
+                continue;
+
+            job.m_builder = builder;
+            job.m_file = &file;
+            job.m_hash = HashFile(job.m_sourceFile, builder->GetVersion());
+            job.m_time = 0;
+            job.m_result = false;
+
+            auto it = manifest.find(file);
+            if (it != manifest.end() && it->second == job.m_hash && FileExists(job.m_destFile.c_str()))
+                continue;
+            jobs.push_back(job);
+        }
+
+        if (jobs.empty())
+            return;
+
+        MicroTicker ticker;
+        ticker.Init();
+        BuildContext context = { &jobs, source, dest, &ticker };
+
+        const Time_t start = ticker.GetTicks();
+        TaskPool taskPool;
+        taskPool.ParallelFor(&BuildFiles, &context, int(jobs.size()));
+        const Time_t totalTime = ticker.GetTicks() - start;
+
+        size_t built = 0;
+        for (const BuildJob &job : jobs)
+        {
+            if (job.m_result)
+            {
+                log::Info("Built ", job.m_sourceFile.c_str(), " to ", job.m_destFile.c_str(),
+                          " in ", job.m_time, " us");
+                manifest[*job.m_file] = job.m_hash;
+                built++;
+            }
+            else
+            {
+                log::Error("Could not build ", job.m_sourceFile.c_str(), " to ", job.m_destFile.c_str());
+                manifest.erase(*job.m_file);
+            }
+        }
+        log::Info("Built ", built, " of ", jobs.size(), " resources in ", totalTime / 1000,
+                  " ms on ", taskPool.GetThreadCount(), " threads");
+
+        WriteManifest(manifestFile, manifest);
+    }
+
+    bool MasterBuilder::BuildPack(const char * const source, const char * const packFile)
+    {
+        std::string directory(source);
+        if (!directory.empty() && directory[directory.length() - 1] != '/')
+            directory += '/';
+
+        std::vector<std::string> files;
+        GetFilesFromDirectory(directory, files, true);
+
+        bool upToDate = FileExists(packFile);
+        const time_t packTime = upToDate ? GetModifyTime(packFile) : time_t(0);
+
+        struct PackedFile
+        {
+            PackEntry m_entry;
+            const std::string *m_name;
+        };
+        std::vector<PackedFile> packed;
+        packed.reserve(files.size());
+
+        for (const std::string &file : files)
+        {
+            const std::string filepath = directory + file;
+            if (GetModifyTime(filepath.c_str()) > packTime)
+                upToDate = false;
+
+            PackedFile p;
+            p.m_entry.m_id = ResourceID(file.c_str());
+            p.m_entry.m_size = GetFileSize(filepath.c_str());
+            p.m_name = &file;
+            packed.push_back(p);
+        }
+        if (upToDate)
+        {
+            // A removed file doesn't show in the modify times.
+            ResourcePack pack;
+            if (pack.Open(packFile) && pack.GetEntryCount() == packed.size())
+                return true;
+        }
+
+        std::sort(packed.begin(), packed.end(), [](const PackedFile &a, const PackedFile &b)
+                  { return a.m_entry.m_id < b.m_entry.m_id; });
+
+        for (size_t i = 1; i < packed.size(); i++)
+        {
+            if (packed[i].m_entry.m_id == packed[i - 1].m_entry.m_id)
+            {
+                log::Error("Resource id collision between ", packed[i - 1].m_name->c_str(),
+                           " and ", packed[i].m_name->c_str());
+                return false;
+            }
+        }
+
+        size_t offset = sizeof(PackHeader) + packed.size() * sizeof(PackEntry);
+        for (PackedFile &p : packed)
+        {
+            p.m_entry.m_nameOffset = offset;
+            offset += p.m_name->length() + 1;
+        }
+        for (PackedFile &p : packed)
+        {
+            offset = align(offset, RESOURCE_PACK_ALIGN);
+            p.m_entry.m_offset = offset;
+            offset += p.m_entry.m_size;
+        }
+
+        std::ofstream out(packFile, std::ios_base::binary);
+        if (!out.is_open())
+        {
+            log::Error("Could not open resource pack ", packFile, " for writing");
+            return false;
+        }
+
+        PackHeader header;
+        header.m_magic = RESOURCE_PACK_MAGIC;
+        header.m_version = RESOURCE_PACK_VERSION;
+        header.m_entryCount = packed.size();
+        header.m_reserved = 0;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const PackedFile &p : packed)
+            out.write(reinterpret_cast<const char*>(&p.m_entry), sizeof(PackEntry));
+        for (const PackedFile &p : packed)
+            out.write(p.m_name->c_str(), p.m_name->length() + 1);
+
+        std::vector<char> data;
+        for (const PackedFile &p : packed)
+        {
+            const size_t padding = p.m_entry.m_offset - size_t(out.tellp());
+            for (size_t i = 0; i < padding; i++)
+                out.put(0);
+
+            data.resize(p.m_entry.m_size);
+            std::ifstream in((directory + *p.m_name).c_str(), std::ios_base::binary);
+            in.read(data.data(), data.size());
+            if (!in)
+            {
+                log::Error("Could not read ", p.m_name->c_str(), " to resource pack");
+                return false;
             }
+            out.write(data.data(), data.size());
         }
+
+        log::Info("Built resource pack ", packFile, " with ", packed.size(), " resources");
+        return bool(out);
     }
 
 } // rob
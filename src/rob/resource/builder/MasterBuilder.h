@@ -9,6 +9,11 @@ namespace rob
     {
     public:
         void Build(const char * const source, const char * const dest);
+        /// Sets whether the built textures are S3TC compressed, see TextureBuilder.
+        void SetTextureCompression(bool compress);
+        /// Packs the files of the built directory into a single resource pack,
+        /// see ResourcePack. The pack is rebuilt only if a file is newer than it.
+        bool BuildPack(const char * const source, const char * const packFile);
     };
 
 } // rob
@@ -1,7 +1,5 @@
 
 #include "ResourceBuilder.h"
-#include "../../filesystem/FileStat.h"
-#include "../../Log.h"
 
 namespace rob
 {
@@ -26,8 +24,8 @@ namespace rob
         }
     }
 
-    bool ResourceBuilder::TryBuild(const std::string &directory, const std::string &filename,
-                                   const std::string &destDirectory, const std::string &destFilename)
+    bool ResourceBuilder::Accepts(const std::string &filename, const std::string &destFilename,
+                                  std::string &newFilename) const
     {
         for (size_t i = 0; i < m_extensions.size(); i++)
         {
@@ -41,25 +39,13 @@ namespace rob
             const size_t pos = fnlen - extlen;
             if (filename.compare(pos, extlen, ext) == 0)
             {
-                std::string newFilename = destFilename;
+                newFilename = destFilename;
                 if (!m_newExtension.empty())
                 {
                     const size_t pos = destFilename.length() - extlen;
                     newFilename.resize(pos);
                     newFilename += m_newExtension;
                 }
-                if (!FileExists(newFilename.c_str()) ||
-                    GetModifyTime(newFilename.c_str()) < GetModifyTime(filename.c_str()))
-                {
-                    if (Build(directory, filename, destDirectory, newFilename))
-                    {
-                        log::Info("Built ", filename.c_str(), " to ", newFilename.c_str());
-                    }
-                    else
-                    {
-                        log::Error("Could not build ", filename.c_str(), " to ", newFilename.c_str());
-                    }
-                }
                 return true;
             }
         }
@@ -2,6 +2,8 @@
 #ifndef H_ROB_RESOURCE_BUILDER_H
 #define H_ROB_RESOURCE_BUILDER_H
 
+#include "../../Types.h"
+
 #include <string>
 #include <vector>
 
@@ -16,10 +18,16 @@ namespace rob
         ResourceBuilder& operator = (const ResourceBuilder&) = delete;
         virtual ~ResourceBuilder() { }
 
-        bool TryBuild(const std::string &directory, const std::string &filename,
-                      const std::string &destDirectory, const std::string &destFilename);
+        /// Returns true if the builder builds the file, and the name of the
+        /// built file in newFilename.
+        bool Accepts(const std::string &filename, const std::string &destFilename,
+                     std::string &newFilename) const;
+        /// Builds a file. Gets called from several threads at once for
+        /// different files.
         virtual bool Build(const std::string &directory, const std::string &filename,
                            const std::string &destDirectory, const std::string &destFilename) = 0;
+        /// Version of the built files. Changing it rebuilds all files of the builder.
+        virtual uint32_t GetVersion() const { return 1; }
 
     protected:
         std::vector<std::string> m_extensions;
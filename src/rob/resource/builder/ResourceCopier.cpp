@@ -9,7 +9,6 @@ namespace rob
     {
         m_extensions.push_back(".ion");
         m_extensions.push_back(".wav");
-        m_extensions.push_back(".fnt");
         m_extensions.push_back(".txt");
     }
 
@@ -0,0 +1,191 @@
+
+#include "S3tcCompressor.h"
+#include "../../graphics/S3tc.h"
+
+namespace rob
+{
+
+    /// Reads a block of 4x4 pixels. The pixels outside of the image repeat
+    /// the last row and column.
+    static void ReadBlock(const uint8_t *rgba, size_t w, size_t h, size_t bx, size_t by,
+                          uint8_t (&pixels)[16][4])
+    {
+        for (size_t y = 0; y < 4; y++)
+        {
+            const size_t py = (by + y < h) ? by + y : h - 1;
+            for (size_t x = 0; x < 4; x++)
+            {
+                const size_t px = (bx + x < w) ? bx + x : w - 1;
+                const uint8_t *src = rgba + (py * w + px) * 4;
+                for (size_t i = 0; i < 4; i++)
+                    pixels[y * 4 + x][i] = src[i];
+            }
+        }
+    }
+
+    static uint16_t Pack565(const int *rgb)
+    {
+        return uint16_t(((rgb[0] * 31 + 127) / 255) << 11
+                      | ((rgb[1] * 63 + 127) / 255) << 5
+                      | ((rgb[2] * 31 + 127) / 255));
+    }
+
+    static void Unpack565(uint16_t c, int *rgb)
+    {
+        const int r = (c >> 11) & 0x1f;
+        const int g = (c >> 5) & 0x3f;
+        const int b = c & 0x1f;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    /// Encodes the colors of the block in four color mode. The end points are
+    /// the corners of the bounding box of the colors, inset a bit to reduce
+    /// the error of the other colors.
+    static void EncodeColorBlock(const uint8_t (&pixels)[16][4], uint8_t *block)
+    {
+        int minColor[3] = { 255, 255, 255 };
+        int maxColor[3] = { 0, 0, 0 };
+        for (size_t p = 0; p < 16; p++)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                if (pixels[p][i] < minColor[i]) minColor[i] = pixels[p][i];
+                if (pixels[p][i] > maxColor[i]) maxColor[i] = pixels[p][i];
+            }
+        }
+        for (size_t i = 0; i < 3; i++)
+        {
+            const int inset = (maxColor[i] - minColor[i]) / 16;
+            minColor[i] += inset;
+            maxColor[i] -= inset;
+        }
+
+        uint16_t c0 = Pack565(maxColor);
+        uint16_t c1 = Pack565(minColor);
+        if (c0 < c1)
+        {
+            const uint16_t c = c0;
+            c0 = c1;
+            c1 = c;
+        }
+
+        int palette[4][3];
+        Unpack565(c0, palette[0]);
+        Unpack565(c1, palette[1]);
+        for (size_t i = 0; i < 3; i++)
+        {
+            palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+            palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+        }
+
+        uint32_t indices = 0;
+        if (c0 != c1)
+        {
+            for (size_t p = 0; p < 16; p++)
+            {
+                uint32_t best = 0;
+                int bestDist = 0x7fffffff;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    int dist = 0;
+                    for (size_t i = 0; i < 3; i++)
+                    {
+                        const int d = pixels[p][i] - palette[c][i];
+                        dist += d * d;
+                    }
+                    if (dist < bestDist)
+                    {
+                        best = c;
+                        bestDist = dist;
+                    }
+                }
+                indices |= best << (p * 2);
+            }
+        }
+
+        block[0] = uint8_t(c0);
+        block[1] = uint8_t(c0 >> 8);
+        block[2] = uint8_t(c1);
+        block[3] = uint8_t(c1 >> 8);
+        for (size_t i = 0; i < 4; i++)
+            block[4 + i] = uint8_t(indices >> (i * 8));
+    }
+
+    /// Encodes the alpha of the block in eight value mode with the minimum
+    /// and the maximum alpha as end points.
+    static void EncodeAlphaBlock(const uint8_t (&pixels)[16][4], uint8_t *block)
+    {
+        int a0 = 0;
+        int a1 = 255;
+        for (size_t p = 0; p < 16; p++)
+        {
+            if (pixels[p][3] > a0) a0 = pixels[p][3];
+            if (pixels[p][3] < a1) a1 = pixels[p][3];
+        }
+
+        int palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+        uint64_t indices = 0;
+        if (a0 != a1)
+        {
+            for (size_t p = 0; p < 16; p++)
+            {
+                uint64_t best = 0;
+                int bestDist = 256;
+                for (uint32_t a = 0; a < 8; a++)
+                {
+                    const int dist = (pixels[p][3] > palette[a])
+                        ? pixels[p][3] - palette[a]
+                        : palette[a] - pixels[p][3];
+                    if (dist < bestDist)
+                    {
+                        best = a;
+                        bestDist = dist;
+                    }
+                }
+                indices |= best << (p * 3);
+            }
+        }
+
+        block[0] = uint8_t(a0);
+        block[1] = uint8_t(a1);
+        for (size_t i = 0; i < 6; i++)
+            block[2 + i] = uint8_t(indices >> (i * 8));
+    }
+
+    void CompressBC1(const uint8_t *rgba, size_t w, size_t h, uint8_t *blocks)
+    {
+        uint8_t pixels[16][4];
+        for (size_t by = 0; by < h; by += 4)
+        {
+            for (size_t bx = 0; bx < w; bx += 4)
+            {
+                ReadBlock(rgba, w, h, bx, by, pixels);
+                EncodeColorBlock(pixels, blocks);
+                blocks += BC1_BLOCK_SIZE;
+            }
+        }
+    }
+
+    void CompressBC3(const uint8_t *rgba, size_t w, size_t h, uint8_t *blocks)
+    {
+        uint8_t pixels[16][4];
+        for (size_t by = 0; by < h; by += 4)
+        {
+            for (size_t bx = 0; bx < w; bx += 4)
+            {
+                ReadBlock(rgba, w, h, bx, by, pixels);
+                EncodeAlphaBlock(pixels, blocks);
+                EncodeColorBlock(pixels, blocks + 8);
+                blocks += BC3_BLOCK_SIZE;
+            }
+        }
+    }
+
+} // rob
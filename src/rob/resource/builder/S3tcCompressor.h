@@ -0,0 +1,18 @@
+
+#ifndef H_ROB_S3TC_COMPRESSOR_H
+#define H_ROB_S3TC_COMPRESSOR_H
+
+#include "../../Types.h"
+
+namespace rob
+{
+
+    /// Compresses an RGBA image of w x h pixels to BC1 (DXT1) blocks. The
+    /// alpha is ignored. See DecompressBC1 for the size of the output.
+    void CompressBC1(const uint8_t *rgba, size_t w, size_t h, uint8_t *blocks);
+    /// Compresses an RGBA image to BC3 (DXT5) blocks.
+    void CompressBC3(const uint8_t *rgba, size_t w, size_t h, uint8_t *blocks);
+
+} // rob
+
+#endif // H_ROB_S3TC_COMPRESSOR_H
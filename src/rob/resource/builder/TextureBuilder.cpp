@@ -3,10 +3,14 @@
 #include "../../Log.h"
 #include "../../Types.h"
 #include "../../graphics/Texture.h"
+#include "../../memory/PtrAlign.h"
+#include "../TextureFile.h"
+#include "S3tcCompressor.h"
 
 #include <FreeImage.h>
 
 #include <fstream>
+#include <vector>
 
 namespace rob
 {
@@ -16,6 +20,60 @@ namespace rob
         m_extensions.push_back(".png");
         m_extensions.push_back(".tga");
         m_newExtension = ".tex";
+        m_compress = true;
+    }
+
+    /// Halves the RGBA image with a box filter. The colors are weighted by
+    /// alpha so that transparent pixels don't darken the edges.
+    static std::vector<uint8_t> BuildMipLevel(const std::vector<uint8_t> &image, size_t w, size_t h)
+    {
+        const size_t mipW = (w > 1) ? w / 2 : 1;
+        const size_t mipH = (h > 1) ? h / 2 : 1;
+        std::vector<uint8_t> mip(mipW * mipH * 4);
+        for (size_t y = 0; y < mipH; y++)
+        {
+            for (size_t x = 0; x < mipW; x++)
+            {
+                uint32_t color[3] = { 0, 0, 0 };
+                uint32_t alpha = 0;
+                for (size_t sy = 0; sy < 2; sy++)
+                {
+                    for (size_t sx = 0; sx < 2; sx++)
+                    {
+                        const size_t px = (x * 2 + sx < w) ? x * 2 + sx : w - 1;
+                        const size_t py = (y * 2 + sy < h) ? y * 2 + sy : h - 1;
+                        const uint8_t *src = image.data() + (py * w + px) * 4;
+                        for (size_t i = 0; i < 3; i++)
+                            color[i] += src[i] * uint32_t(src[3]);
+                        alpha += src[3];
+                    }
+                }
+                uint8_t *dest = mip.data() + (y * mipW + x) * 4;
+                for (size_t i = 0; i < 3; i++)
+                    dest[i] = alpha ? uint8_t((color[i] + alpha / 2) / alpha) : 0;
+                dest[3] = uint8_t((alpha + 2) / 4);
+            }
+        }
+        return mip;
+    }
+
+    /// Writes the RGBA image as RGB or RGBA rows aligned to TEXTURE_ROW_ALIGN.
+    static void WriteRows(const std::vector<uint8_t> &image, size_t w, size_t h,
+                          size_t bytesPerPixel, std::vector<uint8_t> &data)
+    {
+        const size_t pitch = align(w * bytesPerPixel, TEXTURE_ROW_ALIGN);
+        for (size_t y = 0; y < h; y++)
+        {
+            const uint8_t *src = image.data() + y * w * 4;
+            uint8_t *dest = data.data() + y * pitch;
+            for (size_t x = 0; x < w; x++)
+            {
+                for (size_t i = 0; i < bytesPerPixel; i++)
+                    dest[i] = src[i];
+                src += 4;
+                dest += bytesPerPixel;
+            }
+        }
     }
 
     bool TextureBuilder::Build(const std::string &directory, const std::string &filename,
@@ -71,68 +129,96 @@ namespace rob
         const size_t width = ::FreeImage_GetWidth(bitmap);
         const size_t height = ::FreeImage_GetHeight(bitmap);
         const size_t bytesPerPixel = static_cast<size_t>(texFormat);
-        const size_t imageSize = width * height * bytesPerPixel;
 
 //        log::Info("Image info: ", width, "x", height, "x", bpp, ", bytespp", bytesPerPixel);
 
-        unsigned char * const imageData = new unsigned char[imageSize];
-        unsigned char *data = imageData;
-        if (texFormat == Texture::FMT_RGB)
+        // The levels are built from RGBA, bottom row first like the scan lines.
+        std::vector<uint8_t> image(width * height * 4);
+        bool hasAlpha = false;
+        for(size_t y = 0; y < height; y++)
         {
-            for(size_t y = 0; y < height; y++)
+            uint8_t *data = image.data() + y * width * 4;
+            const BYTE *bits = FreeImage_GetScanLine(bitmap, y);
+            for(size_t x = 0; x < width; x++)
             {
-                const BYTE *bits = FreeImage_GetScanLine(bitmap, y);
-                for(size_t x = 0; x < width; x++)
-                {
-                    data[0] = bits[FI_RGBA_RED];
-                    data[1] = bits[FI_RGBA_GREEN];
-                    data[2] = bits[FI_RGBA_BLUE];
-
-                    bits += bytesPerPixel;
-                    data += bytesPerPixel;
-                }
+                data[0] = bits[FI_RGBA_RED];
+                data[1] = bits[FI_RGBA_GREEN];
+                data[2] = bits[FI_RGBA_BLUE];
+                data[3] = (texFormat == Texture::FMT_RGBA) ? bits[FI_RGBA_ALPHA] : 255;
+                hasAlpha = hasAlpha || data[3] != 255;
+
+                bits += bytesPerPixel;
+                data += 4;
             }
         }
+
+        ::FreeImage_Unload(bitmap);
+        bitmap = nullptr;
+
+        // Compressed level 0 must be made of whole blocks.
+        if (m_compress && width % 4 == 0 && height % 4 == 0)
+            texFormat = hasAlpha ? Texture::FMT_BC3 : Texture::FMT_BC1;
         else
+            texFormat = hasAlpha ? Texture::FMT_RGBA : Texture::FMT_RGB;
+
+        size_t levelCount = 1;
+        while ((width >> levelCount) || (height >> levelCount))
+            levelCount++;
+
+        TextureFileHeader header;
+        header.m_magic = TEXTURE_FILE_MAGIC;
+        header.m_version = TEXTURE_FILE_VERSION;
+        header.m_width = width;
+        header.m_height = height;
+        header.m_format = static_cast<uint32_t>(texFormat);
+        header.m_levelCount = levelCount;
+        header.m_reserved = 0;
+
+        TextureFileLevel levels[Texture::MAX_LEVELS];
+        std::vector<std::vector<uint8_t>> levelData(levelCount);
+        size_t offset = sizeof(header) + levelCount * sizeof(TextureFileLevel);
+
+        size_t levelW = width;
+        size_t levelH = height;
+        for (size_t i = 0; i < levelCount; i++)
         {
-            for(size_t y = 0; y < height; y++)
-            {
-                const BYTE *bits = FreeImage_GetScanLine(bitmap, y);
-                for(size_t x = 0; x < width; x++)
-                {
-                    data[0] = bits[FI_RGBA_RED];
-                    data[1] = bits[FI_RGBA_GREEN];
-                    data[2] = bits[FI_RGBA_BLUE];
-                    data[3] = bits[FI_RGBA_ALPHA];
+            if (i > 0)
+                image = BuildMipLevel(image, levelW, levelH);
+            levelW = (width >> i) ? (width >> i) : 1;
+            levelH = (height >> i) ? (height >> i) : 1;
+
+            std::vector<uint8_t> &data = levelData[i];
+            data.resize(Texture::GetImageSize(levelW, levelH, texFormat));
+            if (texFormat == Texture::FMT_BC1)
+                CompressBC1(image.data(), levelW, levelH, data.data());
+            else if (texFormat == Texture::FMT_BC3)
+                CompressBC3(image.data(), levelW, levelH, data.data());
+            else
+                WriteRows(image, levelW, levelH, static_cast<size_t>(texFormat), data);
 
-                    bits += bytesPerPixel;
-                    data += bytesPerPixel;
-                }
-            }
+            offset = align(offset, TEXTURE_LEVEL_ALIGN);
+            levels[i].m_offset = offset;
+            levels[i].m_size = data.size();
+            offset += data.size();
         }
+        header.m_dataSize = offset - sizeof(header);
 
-        ::FreeImage_Unload(bitmap);
-        bitmap = nullptr;
-
-        bool result = false;
         std::ofstream out(destFilename.c_str(), std::ios_base::binary);
         if (!out.is_open())
         {
             log::Error("Could not open the destination file for image ", destFilename.c_str());
+            return false;
         }
-        else
-        {
-            out.write(reinterpret_cast<const char*>(&width), sizeof(size_t));
-            out.write(reinterpret_cast<const char*>(&height), sizeof(size_t));
-            const size_t st_format = static_cast<size_t>(texFormat);
-            out.write(reinterpret_cast<const char*>(&st_format), sizeof(size_t));
-            out.write(reinterpret_cast<const char*>(imageData), imageSize);
 
-            result = true;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(levels), levelCount * sizeof(TextureFileLevel));
+        for (size_t i = 0; i < levelCount; i++)
+        {
+            while (size_t(out.tellp()) < levels[i].m_offset)
+                out.put(0);
+            out.write(reinterpret_cast<const char*>(levelData[i].data()), levelData[i].size());
         }
-
-        delete[] imageData;
-        return result;
+        return bool(out);
     }
 
 } // rob
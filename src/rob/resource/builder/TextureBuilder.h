@@ -13,6 +13,16 @@ namespace rob
         TextureBuilder();
         bool Build(const std::string &directory, const std::string &filename,
                    const std::string &destDirectory, const std::string &destFilename) override;
+        /// Version 2 writes TextureFileHeader, version 3 mip levels and
+        /// version 4 compressed levels.
+        uint32_t GetVersion() const override { return m_compress ? 4 : 3; }
+
+        /// Compresses the textures to BC1 if they are opaque and to BC3 if
+        /// they have alpha. Compression is on by default.
+        void SetCompression(bool compress) { m_compress = compress; }
+
+    private:
+        bool m_compress;
     };
 
 } // rob
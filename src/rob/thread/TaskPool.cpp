@@ -0,0 +1,136 @@
+
+#include "TaskPool.h"
+
+#include "../Log.h"
+
+#include <SDL2/SDL.h>
+
+namespace rob
+{
+
+    TaskPool::TaskPool()
+        : m_workerCount(0)
+        , m_mutex(nullptr)
+        , m_workReady(nullptr)
+        , m_workDone(nullptr)
+        , m_task(nullptr)
+        , m_context(nullptr)
+        , m_count(0)
+        , m_next(0)
+        , m_grain(1)
+        , m_busyWorkers(0)
+        , m_generation(0)
+        , m_quit(false)
+    {
+        m_mutex = ::SDL_CreateMutex();
+        m_workReady = ::SDL_CreateCond();
+        m_workDone = ::SDL_CreateCond();
+
+        int workerCount = ::SDL_GetCPUCount() - 1;
+        if (workerCount > MAX_TASK_THREADS - 1)
+            workerCount = MAX_TASK_THREADS - 1;
+
+        for (int i = 0; i < workerCount; i++)
+        {
+            Worker &worker = m_workers[m_workerCount];
+            worker.pool = this;
+            worker.threadIndex = m_workerCount + 1;
+            worker.thread = ::SDL_CreateThread(&TaskPool::WorkerMain, "TaskPool", &worker);
+            if (!worker.thread)
+            {
+                log::Error("Could not create a task pool thread: ", ::SDL_GetError());
+                break;
+            }
+            m_workerCount++;
+        }
+        log::Info("Task pool threads: ", GetThreadCount());
+    }
+
+    TaskPool::~TaskPool()
+    {
+        ::SDL_LockMutex(m_mutex);
+        m_quit = true;
+        ::SDL_CondBroadcast(m_workReady);
+        ::SDL_UnlockMutex(m_mutex);
+
+        for (int i = 0; i < m_workerCount; i++)
+            ::SDL_WaitThread(m_workers[i].thread, nullptr);
+
+        ::SDL_DestroyCond(m_workDone);
+        ::SDL_DestroyCond(m_workReady);
+        ::SDL_DestroyMutex(m_mutex);
+    }
+
+    void TaskPool::ParallelFor(TaskFunction task, void *context, int count)
+    {
+        if (count <= 0)
+            return;
+
+        if (m_workerCount == 0 || count == 1)
+        {
+            task(context, 0, count, 0);
+            return;
+        }
+
+        ::SDL_LockMutex(m_mutex);
+        m_task = task;
+        m_context = context;
+        m_count = count;
+        m_next = 0;
+        // A few ranges per thread so that uneven items even out.
+        m_grain = count / (GetThreadCount() * 4);
+        if (m_grain < 1) m_grain = 1;
+        m_busyWorkers = m_workerCount;
+        m_generation++;
+        ::SDL_CondBroadcast(m_workReady);
+
+        RunTasks(0);
+        while (m_busyWorkers > 0)
+            ::SDL_CondWait(m_workDone, m_mutex);
+
+        m_task = nullptr;
+        m_context = nullptr;
+        ::SDL_UnlockMutex(m_mutex);
+    }
+
+    int TaskPool::WorkerMain(void *data)
+    {
+        Worker *worker = static_cast<Worker*>(data);
+        TaskPool *pool = worker->pool;
+
+        // Jobs are only started after all workers have been created, so a
+        // worker that starts late must not skip the first one.
+        uint32_t generation = 0;
+        ::SDL_LockMutex(pool->m_mutex);
+        for (;;)
+        {
+            while (!pool->m_quit && pool->m_generation == generation)
+                ::SDL_CondWait(pool->m_workReady, pool->m_mutex);
+            if (pool->m_quit)
+                break;
+            generation = pool->m_generation;
+
+            pool->RunTasks(worker->threadIndex);
+            if (--pool->m_busyWorkers == 0)
+                ::SDL_CondSignal(pool->m_workDone);
+        }
+        ::SDL_UnlockMutex(pool->m_mutex);
+        return 0;
+    }
+
+    // Called with m_mutex locked. The mutex is released while a task runs.
+    void TaskPool::RunTasks(int threadIndex)
+    {
+        while (m_next < m_count)
+        {
+            const int begin = m_next;
+            const int end = (m_count - begin > m_grain) ? begin + m_grain : m_count;
+            m_next = end;
+
+            ::SDL_UnlockMutex(m_mutex);
+            m_task(m_context, begin, end, threadIndex);
+            ::SDL_LockMutex(m_mutex);
+        }
+    }
+
+} // rob
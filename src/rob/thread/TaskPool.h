@@ -0,0 +1,66 @@
+
+#ifndef H_ROB_TASK_POOL_H
+#define H_ROB_TASK_POOL_H
+
+#include "../Types.h"
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+namespace rob
+{
+
+    /// Runs the items [begin, end) of a ParallelFor call on the given thread.
+    typedef void (*TaskFunction)(void *context, int begin, int end, int threadIndex);
+
+    static const int MAX_TASK_THREADS = 8;
+
+    /// A fixed set of worker threads that split ParallelFor calls between them.
+    /// The calling thread takes part as thread 0.
+    class TaskPool
+    {
+    public:
+        /// Starts a worker for every core except the calling thread's one.
+        TaskPool();
+        TaskPool(const TaskPool&) = delete;
+        TaskPool& operator = (const TaskPool&) = delete;
+        ~TaskPool();
+
+        int GetThreadCount() const { return m_workerCount + 1; }
+
+        /// Calls task on ranges covering [0, count) and returns when all of them are done.
+        void ParallelFor(TaskFunction task, void *context, int count);
+
+    private:
+        struct Worker
+        {
+            TaskPool *pool;
+            int threadIndex;
+            SDL_Thread *thread;
+        };
+
+        static int WorkerMain(void *data);
+        void RunTasks(int threadIndex);
+
+    private:
+        Worker m_workers[MAX_TASK_THREADS];
+        int m_workerCount;
+
+        SDL_mutex *m_mutex;
+        SDL_cond *m_workReady;
+        SDL_cond *m_workDone;
+
+        TaskFunction m_task;
+        void *m_context;
+        int m_count;
+        int m_next;
+        int m_grain;
+        int m_busyWorkers;
+        uint32_t m_generation;
+        bool m_quit;
+    };
+
+} // rob
+
+#endif // H_ROB_TASK_POOL_H
@@ -3,6 +3,7 @@
 #define H_ROB_STREAM_UTIL_H
 
 #include <istream>
+#include <streambuf>
 
 namespace rob
 {
@@ -22,6 +23,35 @@ namespace rob
         return file.gcount();
     }
 
+    /// A read-only stream buffer over a block of memory, for reading e.g.
+    /// resource pack data with an std::istream.
+    class MemoryStreamBuf : public std::streambuf
+    {
+    public:
+        MemoryStreamBuf(const char *data, size_t size)
+        {
+            char *begin = const_cast<char*>(data);
+            setg(begin, begin, begin + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which = std::ios_base::in) override
+        {
+            char *pos = gptr();
+            if (dir == std::ios_base::beg) pos = eback();
+            else if (dir == std::ios_base::end) pos = egptr();
+            pos += off;
+            if (pos < eback() || pos > egptr())
+                return pos_type(off_type(-1));
+            setg(eback(), pos, egptr());
+            return pos_type(pos - eback());
+        }
+
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override
+        { return seekoff(off_type(pos), std::ios_base::beg, which); }
+    };
+
 } // rob
 
 #endif // H_ROB_STREAM_UTIL_H